@@ -17,7 +17,7 @@
 
 QT       += core gui svg testlib
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 TARGET = BandageTests
 TEMPLATE = app
@@ -117,7 +117,19 @@ SOURCES += \
     ogdf/basic/Constraint.cpp \
     ogdf/internal/energybased/MultilevelGraph.cpp \
     ui/graphinfodialog.cpp \
-    ui/tablewidgetitemname.cpp
+    ui/tablewidgetitemname.cpp \
+    program/compressedfile.cpp \
+    program/sequencefilereader.cpp \
+    program/fastaindex.cpp \
+    graph/csvtable.cpp \
+    graph/nodeattributes.cpp \
+    graph/graphstatistics.cpp \
+    graph/graphcomponents.cpp \
+    graph/radixheap.cpp \
+    graph/gfatopology.cpp \
+    program/recordfilewriter.cpp \
+    graph/gfapathstore.cpp \
+    graph/nodenameindex.cpp
 
 HEADERS  += \
     program/settings.h \
@@ -240,7 +252,19 @@ HEADERS  += \
     ogdf/basic/Constraints.h \
     ogdf/internal/energybased/MultilevelGraph.h \
     ui/graphinfodialog.h \
-    ui/tablewidgetitemname.h
+    ui/tablewidgetitemname.h \
+    program/compressedfile.h \
+    program/sequencefilereader.h \
+    program/fastaindex.h \
+    graph/csvtable.h \
+    graph/nodeattributes.h \
+    graph/graphstatistics.h \
+    graph/graphcomponents.h \
+    graph/radixheap.h \
+    graph/gfatopology.h \
+    program/recordfilewriter.h \
+    graph/gfapathstore.h \
+    graph/nodenameindex.h
 
 FORMS    += \
     ui/mainwindow.ui \
@@ -263,6 +287,15 @@ RESOURCES += \
 unix:INCLUDEPATH += /usr/include/
 unix:LIBS += -L/usr/lib
 
+# zlib is used to read gzipped input files.  Building with CONFIG+=zstd adds
+# support for zstd-compressed input (requires libzstd).
+unix:LIBS += -lz
+win32:LIBS += -lzlib
+zstd {
+    DEFINES += BANDAGE_ZSTD
+    LIBS += -lzstd
+}
+
 # The following settings are compatible with OGDF being built in 64 bit release mode using Visual Studio 2013
 win32:LIBS += -lpsapi
 win32:RC_FILE = images/myapp.rc
@@ -20,8 +20,15 @@
 #include "../program/globals.h"
 #include "../program/settings.h"
 #include <QTextStream>
+#include <QStringList>
+#include <algorithm>
 #include "blastsearch.h"
 #include "../program/memory.h"
+#include <QtConcurrentMap>
+#include <QFutureWatcher>
+#include <QEventLoop>
+#include <QThread>
+#include <QCoreApplication>
 
 BlastQueries::BlastQueries() :
     m_tempNuclFile(0), m_tempProtFile(0)
@@ -156,6 +163,75 @@ void BlastQueries::writeTempFile(QSharedPointer<QFile> file, SequenceType sequen
 }
 
 
+//This function returns the query files for BLAST searches of the given
+//sequence type, split into the given number of shards so they can be searched
+//by separate BLAST processes.  Each shard holds a consecutive run of queries,
+//split so the shards have similar total lengths.  With one shard, the
+//ordinary temp file is used.  It returns false if a shard file couldn't be
+//written.
+bool BlastQueries::getQueryFileShards(SequenceType sequenceType, int shardCount,
+                                      QStringList * shardFilenames)
+{
+    QSharedPointer<QFile> tempFile = (sequenceType == NUCLEOTIDE) ? m_tempNuclFile : m_tempProtFile;
+    shardFilenames->clear();
+
+    std::vector<BlastQuery *> queries;
+    long long totalLength = 0;
+    for (size_t i = 0; i < m_queries.size(); ++i)
+    {
+        if (m_queries[i]->getSequenceType() == sequenceType)
+        {
+            queries.push_back(m_queries[i]);
+            totalLength += m_queries[i]->getLength();
+        }
+    }
+    if (queries.empty())
+        return true;
+
+    shardCount = std::min(shardCount, int(queries.size()));
+    if (shardCount <= 1)
+    {
+        shardFilenames->push_back(tempFile->fileName());
+        return true;
+    }
+
+    QString prefix = (sequenceType == NUCLEOTIDE) ? "nucl_queries_" : "prot_queries_";
+    size_t queryIndex = 0;
+    long long lengthSoFar = 0;
+    for (int i = 0; i < shardCount; ++i)
+    {
+        QString shardFilename = g_blastSearch->m_tempDirectory + prefix + QString::number(i + 1) + ".fasta";
+        QFile shardFile(shardFilename);
+        if (!shardFile.open(QIODevice::WriteOnly | QIODevice::Text))
+            return false;
+        QTextStream out(&shardFile);
+
+        //Each shard gets at least one query, and the last shard gets all
+        //that remain.
+        long long shardEnd = totalLength * (i + 1) / shardCount;
+        size_t queriesLeftForOtherShards = size_t(shardCount - i - 1);
+        do
+        {
+            out << ">" << queries[queryIndex]->getName() << "\n";
+            out << queries[queryIndex]->getSequence();
+            out << "\n";
+            lengthSoFar += queries[queryIndex]->getLength();
+            ++queryIndex;
+        }
+        while (queryIndex < queries.size() - queriesLeftForOtherShards &&
+               (i == shardCount - 1 || lengthSoFar < shardEnd));
+
+        out.flush();
+        if (out.status() != QTextStream::Ok)
+            return false;
+        shardFile.close();
+        shardFilenames->push_back(shardFilename);
+    }
+
+    return true;
+}
+
+
 void BlastQueries::searchOccurred()
 {
     for (size_t i = 0; i < m_queries.size(); ++i)
@@ -238,12 +314,33 @@ bool BlastQueries::isQueryPresent(BlastQuery * query)
 }
 
 
+static void findPathsForQuery(BlastQuery * query)
+{
+    query->findQueryPaths();
+}
+
 //This function looks at each BLAST query and tries to find a path through
 //the graph which covers the maximal amount of the query.
+//The queries are independent of each other and only read the graph, so they
+//are done in parallel on the global thread pool.  Each query stores its own
+//paths, so the results don't depend on the order the threads finish in.
 void BlastQueries::findQueryPaths()
 {
-    for (size_t i = 0; i < m_queries.size(); ++i)
-        m_queries[i]->findQueryPaths();
+    QFuture<void> future = QtConcurrent::map(m_queries, findPathsForQuery);
+
+    //If this is the GUI thread, keep processing events while the paths are
+    //found so the interface stays responsive.
+    if (QThread::currentThread() == QCoreApplication::instance()->thread())
+    {
+        QFutureWatcher<void> watcher;
+        QEventLoop loop;
+        QObject::connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+        watcher.setFuture(future);
+        if (!future.isFinished())
+            loop.exec();
+    }
+
+    future.waitForFinished();
 }
 
 
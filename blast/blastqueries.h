@@ -24,6 +24,7 @@
 #include <QFile>
 #include "../program/globals.h"
 #include <QSharedPointer>
+#include <QStringList>
 
 //This class manages all BLAST queries. It holds BlastQuery
 //objects itself, and it creates/modifies/deletes the temp
@@ -55,6 +56,7 @@ public:
     int getQueryCount(SequenceType sequenceType);
     bool isQueryPresent(BlastQuery * query);
     void findQueryPaths();
+    bool getQueryFileShards(SequenceType sequenceType, int shardCount, QStringList * shardFilenames);
 
     std::vector<QColor> m_presetColours;
 
@@ -210,22 +210,13 @@ void BlastQuery::findQueryPaths()
 
     //We now want to throw out any paths which are sub-paths of other, larger
     //paths.
+    QList<Path> sufficientCoveragePathsOnly;
+    for (int i = 0; i < sufficientCoveragePaths.size(); ++i)
+        sufficientCoveragePathsOnly.push_back(sufficientCoveragePaths[i].getPath());
+    std::vector<bool> subsetPaths = Path::findPathsWithNodeSubsets(sufficientCoveragePathsOnly);
     for (int i = 0; i < sufficientCoveragePaths.size(); ++i)
     {
-        bool throwOut = false;
-        for (int j = 0; j < sufficientCoveragePaths.size(); ++j)
-        {
-            //No need to compare a path with itself.
-            if (i == j)
-                continue;
-
-            if (sufficientCoveragePaths[i].getPath().hasNodeSubset(sufficientCoveragePaths[j].getPath()))
-            {
-                throwOut = true;
-                break;
-            }
-        }
-        if (!throwOut)
+        if (!subsetPaths[i])
             m_paths.push_back(sufficientCoveragePaths[i]);
     }
 
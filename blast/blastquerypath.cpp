@@ -157,7 +157,7 @@ int BlastQueryPath::getHitOverlap(BlastHit * hit1, BlastHit * hit2) const
     // Overlap in connected nodes is a bit more complex - we need to express
     // the second hit's coordinates in terms of the first hit's node.
     else if (g_assemblyGraph->m_deBruijnGraphEdges.contains(possibleEdge)) {
-        DeBruijnEdge * edge = g_assemblyGraph->m_deBruijnGraphEdges[possibleEdge];
+        DeBruijnEdge * edge = g_assemblyGraph->m_deBruijnGraphEdges.value(possibleEdge);
         int overlap = edge->getOverlap();
         hit1Start = hit1->m_nodeStart;
         hit1End = hit1->m_nodeEnd;
@@ -42,7 +42,6 @@ void BlastSearch::clearBlastHits()
 {
     m_allHits.clear();
     m_blastQueries.clearSearchResults();
-    m_blastOutput = "";
 }
 
 void BlastSearch::cleanUp()
@@ -52,77 +51,202 @@ void BlastSearch::cleanUp()
     emptyTempDirectory();
 }
 
-//This function uses the contents of m_blastOutput (the raw output from the
-//BLAST search) to construct the BlastHit objects.
-//It looks at the filters to possibly exclude hits which fail to meet user-
-//defined thresholds.
-void BlastSearch::buildHitsFromBlastOutput()
+//This function prepares for BLAST output to be read, by indexing the graph's
+//nodes and the queries by name.  This lets each line of the output be matched
+//to its node and query without building any strings.
+void BlastSearch::prepareToBuildHits()
 {
-    QStringList blastHitList = m_blastOutput.split("\n", QString::SkipEmptyParts);
+    m_nodeNameIndex.clear();
+    m_nodeNameIndex.reserve(g_assemblyGraph->m_deBruijnGraphNodes.size());
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        m_nodeNameIndex.insert(i.key().toUtf8(), i.value());
+    }
 
-    for (int i = 0; i < blastHitList.size(); ++i)
+    m_queryNameIndex.clear();
+    for (size_t j = 0; j < m_blastQueries.m_queries.size(); ++j)
     {
-        QString hitString = blastHitList[i];
-        QStringList alignmentParts = hitString.split('\t');
-
-        if (alignmentParts.size() < 12)
-            continue;
-
-        QString queryName = alignmentParts[0];
-        QString nodeLabel = alignmentParts[1];
-        double percentIdentity = alignmentParts[2].toDouble();
-        int alignmentLength = alignmentParts[3].toInt();
-        int numberMismatches = alignmentParts[4].toInt();
-        int numberGapOpens = alignmentParts[5].toInt();
-        int queryStart = alignmentParts[6].toInt();
-        int queryEnd = alignmentParts[7].toInt();
-        int nodeStart = alignmentParts[8].toInt();
-        int nodeEnd = alignmentParts[9].toInt();
-        SciNot eValue(alignmentParts[10]);
-        double bitScore = alignmentParts[11].toDouble();
-
-        //Only save BLAST hits that are on forward strands.
-        if (nodeStart > nodeEnd)
-            continue;
-
-        QString nodeName = getNodeNameFromString(nodeLabel);
-        DeBruijnNode * node;
-        if (g_assemblyGraph->m_deBruijnGraphNodes.contains(nodeName))
-            node = g_assemblyGraph->m_deBruijnGraphNodes[nodeName];
-        else
-            continue;
+        BlastQuery * query = m_blastQueries.m_queries[j];
+        QByteArray queryName = query->getName().toUtf8();
+        if (!m_queryNameIndex.contains(queryName))
+            m_queryNameIndex.insert(queryName, query);
+    }
+}
 
-        BlastQuery * query = g_blastSearch->m_blastQueries.getQueryFromName(queryName);
-        if (query == 0)
-            continue;
-
-        QSharedPointer<BlastHit> hit(new BlastHit(query, node, percentIdentity, alignmentLength,
-                                                  numberMismatches, numberGapOpens, queryStart, queryEnd,
-                                                  nodeStart, nodeEnd, eValue, bitScore));
-
-        //Check the user-defined filters.
-        if (g_settings->blastAlignmentLengthFilter.on &&
-                alignmentLength < g_settings->blastAlignmentLengthFilter)
-            continue;
-        if (g_settings->blastQueryCoverageFilter.on)
+
+//This function interprets one line of BLAST's tabular output and, if it
+//passes the user-defined filters, makes a BlastHit object from it.
+//The line is split in place and the cheap filters are checked first, so
+//rejected lines never allocate anything.  If the line doesn't give a hit, a
+//null pointer is returned.
+QSharedPointer<BlastHit> BlastSearch::makeHitFromBlastOutputLine(const char * line, int length) const
+{
+    QSharedPointer<BlastHit> noHit;
+
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+        --length;
+    if (length == 0)
+        return noHit;
+
+    //Find the start and end of the twelve columns.
+    const char * fieldStarts[12];
+    int fieldLengths[12];
+    int fieldCount = 0;
+    int fieldStart = 0;
+    for (int i = 0; i <= length && fieldCount < 12; ++i)
+    {
+        if (i == length || line[i] == '\t')
+        {
+            fieldStarts[fieldCount] = line + fieldStart;
+            fieldLengths[fieldCount] = i - fieldStart;
+            ++fieldCount;
+            fieldStart = i + 1;
+        }
+    }
+    if (fieldCount < 12)
+        return noHit;
+
+    int alignmentLength = parseBlastInt(fieldStarts[3], fieldLengths[3]);
+    int queryStart = parseBlastInt(fieldStarts[6], fieldLengths[6]);
+    int queryEnd = parseBlastInt(fieldStarts[7], fieldLengths[7]);
+    int nodeStart = parseBlastInt(fieldStarts[8], fieldLengths[8]);
+    int nodeEnd = parseBlastInt(fieldStarts[9], fieldLengths[9]);
+
+    //Only save BLAST hits that are on forward strands.
+    if (nodeStart > nodeEnd)
+        return noHit;
+
+    if (g_settings->blastAlignmentLengthFilter.on &&
+            alignmentLength < g_settings->blastAlignmentLengthFilter)
+        return noHit;
+
+    BlastQuery * query = m_queryNameIndex.value(QByteArray::fromRawData(fieldStarts[0], fieldLengths[0]), 0);
+    if (query == 0)
+        return noHit;
+
+    if (g_settings->blastQueryCoverageFilter.on)
+    {
+        int queryLength = query->getLength();
+        double hitCoveragePercentage = 0.0;
+        if (queryLength > 0)
+            hitCoveragePercentage = 100.0 * double(queryEnd - queryStart + 1) / queryLength;
+        if (hitCoveragePercentage < g_settings->blastQueryCoverageFilter)
+            return noHit;
+    }
+
+    double percentIdentity = QByteArray::fromRawData(fieldStarts[2], fieldLengths[2]).toDouble();
+    if (g_settings->blastIdentityFilter.on &&
+            percentIdentity < g_settings->blastIdentityFilter)
+        return noHit;
+
+    double bitScore = QByteArray::fromRawData(fieldStarts[11], fieldLengths[11]).trimmed().toDouble();
+    if (g_settings->blastBitScoreFilter.on &&
+            bitScore < g_settings->blastBitScoreFilter)
+        return noHit;
+
+    DeBruijnNode * node = getNodeFromBlastLabel(fieldStarts[1], fieldLengths[1]);
+    if (node == 0)
+        return noHit;
+
+    SciNot eValue(QString::fromLatin1(fieldStarts[10], fieldLengths[10]));
+    if (g_settings->blastEValueFilter.on &&
+            eValue > g_settings->blastEValueFilter)
+        return noHit;
+
+    int numberMismatches = parseBlastInt(fieldStarts[4], fieldLengths[4]);
+    int numberGapOpens = parseBlastInt(fieldStarts[5], fieldLengths[5]);
+
+    QSharedPointer<BlastHit> hit(new BlastHit(query, node, percentIdentity, alignmentLength,
+                                              numberMismatches, numberGapOpens, queryStart, queryEnd,
+                                              nodeStart, nodeEnd, eValue, bitScore));
+    return hit;
+}
+
+
+void BlastSearch::addHit(QSharedPointer<BlastHit> hit)
+{
+    m_allHits.push_back(hit);
+    hit->m_query->addHit(hit);
+}
+
+
+//This function parses an integer column of the BLAST output.  Like
+//QString::toInt, it gives 0 for anything that isn't an integer.
+int BlastSearch::parseBlastInt(const char * field, int length)
+{
+    while (length > 0 && field[0] == ' ')
+    {
+        ++field;
+        --length;
+    }
+    while (length > 0 && field[length - 1] == ' ')
+        --length;
+    if (length == 0)
+        return 0;
+
+    bool negative = false;
+    int i = 0;
+    if (field[0] == '-' || field[0] == '+')
+    {
+        negative = (field[0] == '-');
+        ++i;
+    }
+    if (i == length)
+        return 0;
+
+    long long value = 0;
+    for (; i < length; ++i)
+    {
+        if (field[i] < '0' || field[i] > '9')
+            return 0;
+        value = value * 10 + (field[i] - '0');
+        if (value > 2147483648LL)
+            return 0;
+    }
+    if (negative)
+        value = -value;
+    if (value > 2147483647LL)
+        return 0;
+    return int(value);
+}
+
+
+//This function finds the node for a label in the BLAST database.  It is the
+//same as getNodeNameFromString, but it works on the raw bytes and looks the
+//name up in the node name index.
+DeBruijnNode * BlastSearch::getNodeFromBlastLabel(const char * label, int length) const
+{
+    //The label format should look like this:
+    //NODE_nodename_length_123_cov_1.23
+    //The node name may itself contain underscores, so it runs from the first
+    //underscore to the fourth-last underscore.
+    int underscoreCount = 0;
+    int firstUnderscore = -1;
+    for (int i = 0; i < length; ++i)
+    {
+        if (label[i] == '_')
         {
-            double hitCoveragePercentage = 100.0 * hit->getQueryCoverageFraction();
-            if (hitCoveragePercentage < g_settings->blastQueryCoverageFilter)
-                continue;
+            if (firstUnderscore == -1)
+                firstUnderscore = i;
+            ++underscoreCount;
         }
-        if (g_settings->blastIdentityFilter.on &&
-                percentIdentity < g_settings->blastIdentityFilter)
-            continue;
-        if (g_settings->blastEValueFilter.on &&
-                eValue > g_settings->blastEValueFilter)
-                continue;
-        if (g_settings->blastBitScoreFilter.on &&
-                bitScore < g_settings->blastBitScoreFilter)
-            continue;
-
-        m_allHits.push_back(hit);
-        query->addHit(hit);
     }
+    if (underscoreCount < 5)
+        return 0;
+
+    int nameEnd = length;
+    int underscoresFromEnd = 0;
+    while (underscoresFromEnd < 4)
+    {
+        --nameEnd;
+        if (label[nameEnd] == '_')
+            ++underscoresFromEnd;
+    }
+
+    int nameStart = firstUnderscore + 1;
+    return m_nodeNameIndex.value(QByteArray::fromRawData(label + nameStart, nameEnd - nameStart), 0);
 }
 
 
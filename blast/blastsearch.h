@@ -25,6 +25,9 @@
 #include <QString>
 #include <QList>
 #include <QSharedPointer>
+#include <QHash>
+#include <QByteArray>
+#include <QAtomicInt>
 #include "../program/scinot.h"
 
 //This is a class to hold all BLAST search related stuff.
@@ -38,17 +41,21 @@ public:
     ~BlastSearch();
 
     BlastQueries m_blastQueries;
-    QString m_blastOutput;
     bool m_cancelBuildBlastDatabase;
-    bool m_cancelRunBlastSearch;
+
+    //This is set from the GUI thread and read by the thread running the
+    //search, so it is atomic.
+    QAtomicInt m_cancelRunBlastSearch;
+
     QProcess * m_makeblastdb;
-    QProcess * m_blast;
     QString m_tempDirectory;
     QList< QSharedPointer<BlastHit> > m_allHits;
 
     void clearBlastHits();
     void cleanUp();
-    void buildHitsFromBlastOutput();
+    void prepareToBuildHits();
+    QSharedPointer<BlastHit> makeHitFromBlastOutputLine(const char * line, int length) const;
+    void addHit(QSharedPointer<BlastHit> hit);
     void findQueryPaths();
     static QString getNodeNameFromString(QString nodeString);
     bool findProgram(QString programName, QString * command);
@@ -58,6 +65,13 @@ public:
     int loadBlastQueriesFromFastaFile(QString fullFileName);
     QString cleanQueryName(QString queryName);
     void blastQueryChanged(QString queryName);
+
+private:
+    QHash<QByteArray, DeBruijnNode *> m_nodeNameIndex;
+    QHash<QByteArray, BlastQuery *> m_queryNameIndex;
+
+    static int parseBlastInt(const char * field, int length);
+    DeBruijnNode * getNodeFromBlastLabel(const char * label, int length) const;
 };
 
 #endif // BLASTSEARCH_H
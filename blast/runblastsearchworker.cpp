@@ -21,44 +21,133 @@
 #include "../program/settings.h"
 #include "blastsearch.h"
 #include "../program/memory.h"
+#include <QEventLoop>
+#include <QTimer>
+#include <algorithm>
 
 
 RunBlastSearchWorker::RunBlastSearchWorker(QString blastnCommand, QString tblastnCommand, QString parameters) :
-    m_blastnCommand(blastnCommand), m_tblastnCommand(tblastnCommand), m_parameters(parameters)
+    m_blastnCommand(blastnCommand), m_tblastnCommand(tblastnCommand), m_parameters(parameters),
+    m_runningProcessCount(0), m_eventLoop(0)
 {
 
 }
 
 
+//This function runs the BLAST searches.  The nucleotide and protein searches
+//run at the same time, and the queries of each type can be split between
+//several BLAST processes.  The available threads are divided between the
+//processes.  Hits are built as each process produces its output, then added
+//in query order once all processes have finished, so the results are the same
+//as for one process at a time.
 void RunBlastSearchWorker::runBlastSearch()
 {
-    g_blastSearch->m_cancelRunBlastSearch = false;
+    g_blastSearch->m_cancelRunBlastSearch.storeRelease(0);
 
-    bool success;
+    //Hits are built as BLAST produces its output, so the name indices must be
+    //ready before any search starts.
+    g_blastSearch->prepareToBuildHits();
 
-    if (g_blastSearch->m_blastQueries.getQueryCount(NUCLEOTIDE) > 0)
+    int shardCount = g_settings->blastQueryShards;
+    QStringList nuclQueryFiles;
+    QStringList protQueryFiles;
+    if (!g_blastSearch->m_blastQueries.getQueryFileShards(NUCLEOTIDE, shardCount, &nuclQueryFiles) ||
+            !g_blastSearch->m_blastQueries.getQueryFileShards(PROTEIN, shardCount, &protQueryFiles))
     {
-        g_blastSearch->m_blastOutput += runOneBlastSearch(NUCLEOTIDE, &success);
-        if (!success)
-            return;
+        g_blastSearch->clearBlastHits();
+        m_error = "There was a problem writing the BLAST query files.";
+        emit finishedSearch(m_error);
+        return;
+    }
+
+    QStringList blastCommands;
+    for (int i = 0; i < nuclQueryFiles.size(); ++i)
+        blastCommands.push_back(getBlastCommand(m_blastnCommand, nuclQueryFiles[i]));
+    for (int i = 0; i < protQueryFiles.size(); ++i)
+        blastCommands.push_back(getBlastCommand(m_tblastnCommand, protQueryFiles[i]));
+
+    //Unless the user has set the thread count in the BLAST parameters, share
+    //the available threads between the processes.
+    if (!m_parameters.contains("-num_threads") && !blastCommands.empty())
+    {
+        int threadsPerProcess = std::max(1, g_settings->blastThreads / int(blastCommands.size()));
+        for (int i = 0; i < blastCommands.size(); ++i)
+            blastCommands[i] += " -num_threads " + QString::number(threadsPerProcess);
     }
 
-    if (g_blastSearch->m_blastQueries.getQueryCount(PROTEIN) > 0 && !g_blastSearch->m_cancelRunBlastSearch)
+    m_runningProcessCount = 0;
+    for (int i = 0; i < blastCommands.size(); ++i)
     {
-        g_blastSearch->m_blastOutput += runOneBlastSearch(PROTEIN, &success);
-        if (!success)
-            return;
+        QProcess * blast = new QProcess();
+        m_blastProcesses.push_back(blast);
+        m_processHits.push_back(QList< QSharedPointer<BlastHit> >());
+        m_skippingLongLine.push_back(false);
+        connect(blast, SIGNAL(readyReadStandardOutput()), this, SLOT(readBlastOutput()));
+        connect(blast, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(blastProcessFinished()));
+        blast->start(blastCommands[i]);
+        if (blast->waitForStarted(-1))
+            ++m_runningProcessCount;
     }
 
-    if (g_blastSearch->m_cancelRunBlastSearch)
+    //Wait for the processes in a local event loop, so their output can be
+    //read as it arrives.  A timer checks whether the search was cancelled.
+    if (m_runningProcessCount > 0)
+    {
+        QEventLoop eventLoop;
+        m_eventLoop = &eventLoop;
+        QTimer cancelTimer;
+        connect(&cancelTimer, SIGNAL(timeout()), this, SLOT(checkForCancel()));
+        cancelTimer.start(100);
+        eventLoop.exec();
+        m_eventLoop = 0;
+    }
+
+    //Read anything left over, including final lines with no newline, and
+    //check for problems.
+    QString error;
+    for (int i = 0; i < m_blastProcesses.size(); ++i)
+    {
+        QProcess * blast = m_blastProcesses[i];
+        readBlastOutputFromProcess(i, true);
+        if (error == "" && (blast->exitStatus() != QProcess::NormalExit ||
+                            blast->exitCode() != 0 || blast->error() == QProcess::FailedToStart))
+        {
+            error = "There was a problem running the BLAST search";
+            QString stdErr = blast->readAllStandardError();
+            if (stdErr.length() > 0)
+                error += ":\n\n" + stdErr;
+            else
+                error += ".";
+        }
+    }
+
+    if (g_blastSearch->m_cancelRunBlastSearch.loadAcquire())
+        error = "BLAST search cancelled.";
+
+    if (error == "")
+    {
+        for (int i = 0; i < m_processHits.size(); ++i)
+        {
+            for (int j = 0; j < m_processHits[i].size(); ++j)
+                g_blastSearch->addHit(m_processHits[i][j]);
+        }
+    }
+
+    for (int i = 0; i < m_blastProcesses.size(); ++i)
+        delete m_blastProcesses[i];
+    m_blastProcesses.clear();
+    m_processHits.clear();
+    m_skippingLongLine.clear();
+
+    if (error != "")
     {
-        m_error = "BLAST search cancelled.";
+        g_blastSearch->clearBlastHits();
+        m_error = error;
         emit finishedSearch(m_error);
         return;
     }
 
     //If the code got here, then the search completed successfully.
-    g_blastSearch->buildHitsFromBlastOutput();
     g_blastSearch->findQueryPaths();
     g_blastSearch->m_blastQueries.searchOccurred();
     m_error = "";
@@ -66,48 +155,79 @@ void RunBlastSearchWorker::runBlastSearch()
 }
 
 
-QString RunBlastSearchWorker::runOneBlastSearch(SequenceType sequenceType, bool * success)
+QString RunBlastSearchWorker::getBlastCommand(QString program, QString queryFilename)
 {
-    QString fullBlastCommand;
-    if (sequenceType == NUCLEOTIDE)
-        fullBlastCommand = m_blastnCommand + " -query " +g_blastSearch-> m_tempDirectory + "nucl_queries.fasta ";
-    else
-        fullBlastCommand = m_tblastnCommand + " -query " + g_blastSearch->m_tempDirectory + "prot_queries.fasta ";
+    QString fullBlastCommand = program + " -query " + queryFilename + " ";
     fullBlastCommand += "-db " + g_blastSearch->m_tempDirectory + "all_nodes.fasta -outfmt 6";
 
     QString extraCommandLineOptions = m_parameters;
     fullBlastCommand += " " + extraCommandLineOptions;
+    return fullBlastCommand;
+}
+
+
+void RunBlastSearchWorker::readBlastOutput()
+{
+    int processIndex = m_blastProcesses.indexOf(qobject_cast<QProcess *>(sender()));
+    if (processIndex != -1)
+        readBlastOutputFromProcess(processIndex, false);
+}
+
+
+void RunBlastSearchWorker::blastProcessFinished()
+{
+    --m_runningProcessCount;
+    if (m_runningProcessCount <= 0 && m_eventLoop != 0)
+        m_eventLoop->quit();
+}
 
-    g_blastSearch->m_blast = new QProcess();
-    g_blastSearch->m_blast->start(fullBlastCommand);
 
-    bool finished = g_blastSearch->m_blast->waitForFinished(-1);
+void RunBlastSearchWorker::checkForCancel()
+{
+    if (!g_blastSearch->m_cancelRunBlastSearch.loadAcquire())
+        return;
 
-    if (g_blastSearch->m_blast->exitCode() != 0 || !finished)
+    for (int i = 0; i < m_blastProcesses.size(); ++i)
     {
-        if (g_blastSearch->m_cancelRunBlastSearch)
+        if (m_blastProcesses[i]->state() != QProcess::NotRunning)
+            m_blastProcesses[i]->kill();
+    }
+}
+
+
+//This function turns each complete line of BLAST output waiting in a process
+//into a hit.  Lines are read into a fixed buffer, so reading doesn't allocate.
+//If finished is true, a final partial line is read too.
+void RunBlastSearchWorker::readBlastOutputFromProcess(int processIndex, bool finished)
+{
+    QProcess * blast = m_blastProcesses[processIndex];
+    const int bufferSize = 8192;
+    char line[bufferSize];
+
+    while (blast->canReadLine() || (finished && blast->bytesAvailable() > 0))
+    {
+        qint64 length = blast->readLine(line, bufferSize);
+        if (length <= 0)
+            break;
+
+        //A line too long for the buffer can't be a valid hit, so everything up
+        //to its newline is skipped.  The newline may not have arrived yet, so
+        //the skip carries over to the next read from this process.
+        bool lineEnded = line[length - 1] == '\n';
+        if (m_skippingLongLine[processIndex])
         {
-            m_error = "BLAST search cancelled.";
-            emit finishedSearch(m_error);
+            if (lineEnded)
+                m_skippingLongLine[processIndex] = false;
+            continue;
         }
-        else
+        if (!lineEnded && length == bufferSize - 1)
         {
-            m_error = "There was a problem running the BLAST search";
-            QString stdErr = g_blastSearch->m_blast->readAllStandardError();
-            if (stdErr.length() > 0)
-                m_error += ":\n\n" + stdErr;
-            else
-                m_error += ".";
-            emit finishedSearch(m_error);
+            m_skippingLongLine[processIndex] = true;
+            continue;
         }
-        *success = false;
-        return "";
-    }
 
-    QString blastOutput = g_blastSearch->m_blast->readAllStandardOutput();
-    g_blastSearch->m_blast->deleteLater();
-    g_blastSearch->m_blast = 0;
-
-    *success = true;
-    return blastOutput;
+        QSharedPointer<BlastHit> hit = g_blastSearch->makeHitFromBlastOutputLine(line, int(length));
+        if (!hit.isNull())
+            m_processHits[processIndex].push_back(hit);
+    }
 }
@@ -22,8 +22,13 @@
 #include <QObject>
 #include <QProcess>
 #include <QString>
+#include <QList>
+#include <QSharedPointer>
 #include "../program/globals.h"
 
+class BlastHit;
+class QEventLoop;
+
 //This class carries out the task of running blastn and/or
 //tblastn.
 //It is a separate class because when run from the GUI, this
@@ -41,11 +46,23 @@ private:
     QString m_blastnCommand;
     QString m_tblastnCommand;
     QString m_parameters;
-    QString runOneBlastSearch(SequenceType sequenceType, bool * success);
+    QList<QProcess *> m_blastProcesses;
+    QList< QList< QSharedPointer<BlastHit> > > m_processHits;
+    QList<bool> m_skippingLongLine;
+    int m_runningProcessCount;
+    QEventLoop * m_eventLoop;
+
+    QString getBlastCommand(QString program, QString queryFilename);
+    void readBlastOutputFromProcess(int processIndex, bool finished);
 
 public slots:
     void runBlastSearch();
 
+private slots:
+    void readBlastOutput();
+    void blastProcessFinished();
+    void checkForCancel();
+
 signals:
     void finishedSearch(QString error);
 };
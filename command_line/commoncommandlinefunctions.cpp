@@ -50,7 +50,7 @@ void getSettingsUsage(QStringList * text)
     *text << "";
     *text << "Graph scope";
     *text << dashes;
-    *text << "These settings control the graph scope.  If the aroundnodes scope is used, then the --nodes option must also be used.  If the aroundblast scope is used, a BLAST query must be given with the --query option.";
+    *text << "These settings control the graph scope.  If the aroundnodes or aroundbases scope is used, then the --nodes option must also be used.  If the aroundblast scope is used, a BLAST query must be given with the --query option.";
     getGraphScopeOptions(text);
     *text << "--double            Draw graph in double mode (default: off)";
     *text << "";
@@ -138,6 +138,8 @@ void getSettingsUsage(QStringList * text)
     *text << dashes;
     *text << "--query <fastafile> A FASTA file of either nucleotide or protein sequences to be used as BLAST queries (default: none)";
     *text << "--blastp <param>    Parameters to be used by blastn and tblastn when conducting a BLAST search in Bandage (default: none). Format BLAST parameters exactly as they would be used for blastn/tblastn on the command line, and enclose them in quotes.";
+    *text << "--blastthreads <int> Total number of threads used by the BLAST processes " + getRangeAndDefault(g_settings->blastThreads);
+    *text << "--blastshards <int> Number of BLAST processes that the queries of each type are split between " + getRangeAndDefault(g_settings->blastQueryShards);
     *text << "--alfilter <int>    Alignment length filter for BLAST hits. Hits with shorter alignments will be excluded " + getRangeAndDefault(g_settings->blastAlignmentLengthFilter);
     *text << "--qcfilter <float>  Query coverage filter for BLAST hits. Hits with less coverage will be excluded " + getRangeAndDefault(g_settings->blastQueryCoverageFilter);
     *text << "--ifilter <float>   Identity filter for BLAST hits. Hits with less identity will be excluded " + getRangeAndDefault(g_settings->blastIdentityFilter);
@@ -211,10 +213,11 @@ void outputText(QStringList text, QTextStream * out)
 //also displays these.
 void getGraphScopeOptions(QStringList * text)
 {
-    *text << "--scope <scope>     Graph scope, from one of the following options: entire, aroundnodes, aroundblast, depthrange (default: entire)";
-    *text << "--nodes <list>      A comma-separated list of starting nodes for the aroundnodes scope (default: none)";
+    *text << "--scope <scope>     Graph scope, from one of the following options: entire, aroundnodes, aroundblast, depthrange, aroundbases (default: entire)";
+    *text << "--nodes <list>      A comma-separated list of starting nodes for the aroundnodes and aroundbases scopes (default: none)";
     *text << "--partial           Use partial node name matching (default: exact node name matching)";
     *text << "--distance <int>    The number of node steps away to draw for the aroundnodes and aroundblast scopes " + getRangeAndDefault(g_settings->nodeDistance);
+    *text << "--distancebp <int>  The number of bases away to draw for the aroundbases scope " + getRangeAndDefault(g_settings->baseDistance);
     *text << "--mindepth <float>  The minimum allowed depth for the depthrange scope " + getRangeAndDefault(g_settings->minDepthRange);
     *text << "--maxdepth <float>  The maximum allowed depth for the depthrange scope "  + getRangeAndDefault(g_settings->maxDepthRange);
 }
@@ -228,18 +231,21 @@ QString checkForInvalidOrExcessSettings(QStringList * arguments)
     QStringList argumentsCopy = *arguments;
 
     QStringList validScopeOptions;
-    validScopeOptions << "entire" << "aroundnodes" << "aroundblast" << "depthrange";
+    validScopeOptions << "entire" << "aroundnodes" << "aroundblast" << "depthrange" << "aroundbases";
     QString error;
 
     error = checkOptionForString("--scope", arguments, validScopeOptions); if (error.length() > 0) return error;
     error = checkOptionForString("--nodes", arguments, QStringList(), "a list of node names"); if (error.length() > 0) return error;
     checkOptionWithoutValue("--partial", arguments);
     error = checkOptionForInt("--distance", arguments, g_settings->nodeDistance, false); if (error.length() > 0) return error;
+    error = checkOptionForInt("--distancebp", arguments, g_settings->baseDistance, false); if (error.length() > 0) return error;
     error = checkOptionForFloat("--mindepth", arguments, g_settings->minDepthRange, false); if (error.length() > 0) return error;
     error = checkOptionForFloat("--maxdepth", arguments, g_settings->maxDepthRange, false); if (error.length() > 0) return error;
     if (isOptionPresent("--query", arguments) && g_memory->commandLineCommand == NO_COMMAND) return "A graph must be given (e.g. via Bandage load) to use the --query option";
     error = checkOptionForFile("--query", arguments); if (error.length() > 0) return error;
     error = checkOptionForString("--blastp", arguments, QStringList(), "blastn/tblastn parameters"); if (error.length() > 0) return error;
+    error = checkOptionForInt("--blastthreads", arguments, g_settings->blastThreads, false); if (error.length() > 0) return error;
+    error = checkOptionForInt("--blastshards", arguments, g_settings->blastQueryShards, false); if (error.length() > 0) return error;
     checkOptionWithoutValue("--double", arguments);
     error = checkOptionForFloat("--nodelen", arguments, g_settings->manualNodeLengthPerMegabase, false); if (error.length() > 0) return error;
     error = checkOptionForFloat("--minnodlen", arguments, g_settings->minimumNodeLength, false); if (error.length() > 0) return error;
@@ -382,6 +388,10 @@ QString checkForInvalidOrExcessSettings(QStringList * arguments)
     if (nodesScope && !nodesList)
         return "A list of starting nodes must be given with the --nodes option\nwhen the aroundnodes scope is used.";
 
+    bool basesScope = isOptionAndValuePresent("--scope", "aroundbases", &argumentsCopy);
+    if (basesScope && !nodesList)
+        return "A list of starting nodes must be given with the --nodes option\nwhen the aroundbases scope is used.";
+
     bool depthScope = isOptionAndValuePresent("--scope", "depthrange", &argumentsCopy);
     bool minDepthPresent = isOptionPresent("--mindepth", &argumentsCopy);
     bool maxDepthPresent = isOptionPresent("--maxdepth", &argumentsCopy);
@@ -400,6 +410,8 @@ void parseSettings(QStringList arguments)
 
     if (isOptionPresent("--distance", &arguments))
         g_settings->nodeDistance = getIntOption("--distance", &arguments);
+    if (isOptionPresent("--distancebp", &arguments))
+        g_settings->baseDistance = getIntOption("--distancebp", &arguments);
 
     if (isOptionPresent("--mindepth", &arguments))
         g_settings->minDepthRange = getFloatOption("--mindepth", &arguments);
@@ -414,6 +426,10 @@ void parseSettings(QStringList arguments)
         g_settings->blastQueryFilename = getStringOption("--query", &arguments);
     if (isOptionPresent("--blastp", &arguments))
         g_settings->blastSearchParameters = getStringOption("--blastp", &arguments);
+    if (isOptionPresent("--blastthreads", &arguments))
+        g_settings->blastThreads = getIntOption("--blastthreads", &arguments);
+    if (isOptionPresent("--blastshards", &arguments))
+        g_settings->blastQueryShards = getIntOption("--blastshards", &arguments);
 
     g_settings->doubleMode = isOptionPresent("--double", &arguments);
 
@@ -1073,6 +1089,8 @@ GraphScope getGraphScopeOption(QString option, QStringList * arguments)
         return AROUND_BLAST_HITS;
     else if (scopeString == "depthrange")
         return DEPTH_RANGE;
+    else if (scopeString == "aroundbases")
+        return AROUND_BASES;
 
     //Entire graph scope is the default.
     return WHOLE_GRAPH;
@@ -19,7 +19,9 @@
 #include "info.h"
 #include "commoncommandlinefunctions.h"
 #include "../graph/assemblygraph.h"
-#include <QPair>
+#include "../graph/graphstatistics.h"
+#include <QJsonObject>
+#include <QJsonDocument>
 
 
 
@@ -62,8 +64,8 @@ int bandageInfo(QStringList arguments)
         return 1;
     }
 
-    bool tsv;
-    parseInfoOptions(arguments, &tsv);
+    bool tsv, json;
+    parseInfoOptions(arguments, &tsv, &json);
 
     bool loadSuccess = g_assemblyGraph->loadGraphFromFile(graphFilename);
     if (!loadSuccess)
@@ -72,76 +74,79 @@ int bandageInfo(QStringList arguments)
         return 1;
     }
 
-    int nodeCount = g_assemblyGraph->m_nodeCount;
-    int edgeCount = g_assemblyGraph->m_edgeCount;
-    QPair<int, int> overlapRange = g_assemblyGraph->getOverlapRange();
-    int smallestOverlap = overlapRange.first;
-    int largestOverlap = overlapRange.second;
-    int totalLength = g_assemblyGraph->m_totalLength;
-    int totalLengthNoOverlaps = g_assemblyGraph->getTotalLengthMinusEdgeOverlaps();
-    int deadEnds = g_assemblyGraph->getDeadEndCount();
-    double percentageDeadEnds = 100.0 * double(deadEnds) / (2 * nodeCount);
-
-    int n50 = 0;
-    int shortestNode = 0;
-    int firstQuartile = 0;
-    int median = 0;
-    int thirdQuartile = 0;
-    int longestNode = 0;
-    g_assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
-
-    int componentCount = 0;
-    int largestComponentLength = 0;
-    g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
-    long long totalLengthOrphanedNodes = g_assemblyGraph->getTotalLengthOrphanedNodes();
-
-    double medianDepthByBase = g_assemblyGraph->getMedianDepthByBase();
-    long long estimatedSequenceLength = g_assemblyGraph->getEstimatedSequenceLength(medianDepthByBase);
-
-    if (tsv)
+    //All of the statistics are calculated together, using multiple threads.
+    GraphStatistics stats;
+    stats.calculate(g_assemblyGraph.data(), true);
+
+    if (json)
+    {
+        QJsonObject info;
+        info["graph"] = graphFilename;
+        info["node_count"] = stats.m_nodeCount;
+        info["edge_count"] = stats.m_edgeCount;
+        info["smallest_edge_overlap"] = stats.m_smallestOverlap;
+        info["largest_edge_overlap"] = stats.m_largestOverlap;
+        info["total_length"] = double(stats.m_totalLength);
+        info["total_length_no_overlaps"] = double(stats.m_totalLengthNoOverlaps);
+        info["dead_ends"] = stats.m_deadEnds;
+        info["percentage_dead_ends"] = stats.m_percentageDeadEnds;
+        info["connected_components"] = stats.m_componentCount;
+        info["largest_component"] = double(stats.m_largestComponentLength);
+        info["total_length_orphaned_nodes"] = double(stats.m_totalLengthOrphanedNodes);
+        info["n50"] = stats.m_n50;
+        info["shortest_node"] = stats.m_shortestNode;
+        info["lower_quartile_node"] = stats.m_firstQuartile;
+        info["median_node"] = stats.m_median;
+        info["upper_quartile_node"] = stats.m_thirdQuartile;
+        info["longest_node"] = stats.m_longestNode;
+        info["median_depth"] = stats.m_medianDepthByBase;
+        info["estimated_sequence_length"] = double(stats.m_estimatedSequenceLength);
+        out << QJsonDocument(info).toJson();
+    }
+    else if (tsv)
     {
         out << graphFilename << "\t";
-        out << nodeCount << "\t";
-        out << edgeCount << "\t";
-        out << smallestOverlap << "\t";
-        out << largestOverlap << "\t";
-        out << totalLength << "\t";
-        out << totalLengthNoOverlaps << "\t";
-        out << deadEnds << "\t";
-        out << percentageDeadEnds << "%\t";
-        out << componentCount << "\t";
-        out << largestComponentLength << "\t";
-        out << totalLengthOrphanedNodes << "\t";
-        out << n50 << "\t";
-        out << shortestNode << "\t";
-        out << firstQuartile << "\t";
-        out << median << "\t";
-        out << thirdQuartile << "\t";
-        out << longestNode << "\t";
-        out << medianDepthByBase << "\n";
-        out << estimatedSequenceLength << "\n";
+        out << stats.m_nodeCount << "\t";
+        out << stats.m_edgeCount << "\t";
+        out << stats.m_smallestOverlap << "\t";
+        out << stats.m_largestOverlap << "\t";
+        out << stats.m_totalLength << "\t";
+        out << stats.m_totalLengthNoOverlaps << "\t";
+        out << stats.m_deadEnds << "\t";
+        out << stats.m_percentageDeadEnds << "%\t";
+        out << stats.m_componentCount << "\t";
+        out << stats.m_largestComponentLength << "\t";
+        out << stats.m_totalLengthOrphanedNodes << "\t";
+        out << stats.m_n50 << "\t";
+        out << stats.m_shortestNode << "\t";
+        out << stats.m_firstQuartile << "\t";
+        out << stats.m_median << "\t";
+        out << stats.m_thirdQuartile << "\t";
+        out << stats.m_longestNode << "\t";
+        out << stats.m_medianDepthByBase << "\t";
+        out << stats.m_estimatedSequenceLength << "\n";
     }
     else
     {
-        out << "Node count:                       " << nodeCount << "\n";
-        out << "Edge count:                       " << edgeCount << "\n";
-        out << "Smallest edge overlap (bp):       " << smallestOverlap << "\n";
-        out << "Largest edge overlap (bp):        " << largestOverlap << "\n";
-        out << "Total length (bp):                " << totalLength << "\n";
-        out << "Total length no overlaps (bp):    " << totalLengthNoOverlaps << "\n";
-        out << "Dead ends:                        " << deadEnds << "\n";
-        out << "Percentage dead ends:             " << percentageDeadEnds << "%\n";
-        out << "Connected components:             " << componentCount << "\n";
-        out << "Largest component (bp):           " << largestComponentLength << "\n";
-        out << "Total length orphaned nodes (bp): " << largestComponentLength << "\n";
-        out << "N50 (bp):                         " << n50 << "\n";
-        out << "Shortest node (bp):               " << shortestNode << "\n";
-        out << "Lower quartile node (bp):         " << firstQuartile << "\n";
-        out << "Median node (bp):                 " << median << "\n";
-        out << "Upper quartile node (bp):         " << thirdQuartile << "\n";
-        out << "Longest node (bp):                " << longestNode << "\n";
-        out << "Median depth:                     " << medianDepthByBase << "\n";
-        out << "Estimated sequence length (bp):   " << estimatedSequenceLength << "\n";
+        out << "Node count:                       " << stats.m_nodeCount << "\n";
+        out << "Edge count:                       " << stats.m_edgeCount << "\n";
+        out << "Smallest edge overlap (bp):       " << stats.m_smallestOverlap << "\n";
+        out << "Largest edge overlap (bp):        " << stats.m_largestOverlap << "\n";
+        out << "Total length (bp):                " << stats.m_totalLength << "\n";
+        out << "Total length no overlaps (bp):    " << stats.m_totalLengthNoOverlaps << "\n";
+        out << "Dead ends:                        " << stats.m_deadEnds << "\n";
+        out << "Percentage dead ends:             " << stats.m_percentageDeadEnds << "%\n";
+        out << "Connected components:             " << stats.m_componentCount << "\n";
+        out << "Largest component (bp):           " << stats.m_largestComponentLength << "\n";
+        out << "Total length orphaned nodes (bp): " << stats.m_totalLengthOrphanedNodes << "\n";
+        out << "N50 (bp):                         " << stats.m_n50 << "\n";
+        out << "Shortest node (bp):               " << stats.m_shortestNode << "\n";
+        out << "Lower quartile node (bp):         " << stats.m_firstQuartile << "\n";
+        out << "Median node (bp):                 " << stats.m_median << "\n";
+        out << "Upper quartile node (bp):         " << stats.m_thirdQuartile << "\n";
+        out << "Longest node (bp):                " << stats.m_longestNode << "\n";
+        out << "Median depth:                     " << stats.m_medianDepthByBase << "\n";
+        out << "Estimated sequence length (bp):   " << stats.m_estimatedSequenceLength << "\n";
     }
 
     return 0;
@@ -179,6 +184,7 @@ void printInfoUsage(QTextStream * out, bool all)
     text << "<graph>             A graph file of any type supported by Bandage";
     text << "";
     text << "Options:  --tsv               Output the information in a single tab-delimited line starting with the graph file";
+    text << "          --json              Output the information as a JSON object";
     text << "";
 
     getCommonHelp(&text);
@@ -193,7 +199,11 @@ void printInfoUsage(QTextStream * out, bool all)
 
 QString checkForInvalidInfoOptions(QStringList arguments)
 {
+    if (arguments.contains("--tsv") && arguments.contains("--json"))
+        return "--tsv and --json cannot be used together";
+
     checkOptionWithoutValue("--tsv", &arguments);
+    checkOptionWithoutValue("--json", &arguments);
 
     QString error = checkForInvalidOrExcessSettings(&arguments);
     if (error.length() > 0) return error;
@@ -203,8 +213,10 @@ QString checkForInvalidInfoOptions(QStringList arguments)
 
 
 
-void parseInfoOptions(QStringList arguments, bool * tsv)
+void parseInfoOptions(QStringList arguments, bool * tsv, bool * json)
 {
     int tsvIndex = arguments.indexOf("--tsv");
     *tsv = (tsvIndex > -1);
+    int jsonIndex = arguments.indexOf("--json");
+    *json = (jsonIndex > -1);
 }
@@ -191,18 +191,18 @@ int bandageQueryPaths(QStringList arguments)
             tableOut << queryPath.getEvalueProduct().asString(false) << "\t";
 
             //If we are using a separate file for the path sequences, save the
-            //sequence along with its ID to save later, and store the ID here.
-            //Otherwise, just include the sequence in this table.
-            QByteArray sequence = path.getPathSequence();
+            //sequence (already broken into lines) along with its ID to save
+            //later, and store the ID here.  Otherwise, just include the
+            //sequence in this table.
             QString pathSequenceID = query->getName() + "_" + QString::number(j+1);
             if (pathFasta)
             {
                 pathSequenceIDs.push_back(pathSequenceID);
-                pathSequences.push_back(sequence);
+                pathSequences.push_back(path.getPathSequence(70));
                 tableOut << pathSequenceID << "\n";
             }
             else
-                tableOut << sequence << "\n";
+                tableOut << path.getPathSequence() << "\n";
 
             //If we are also saving the hit sequences, save the hit sequence
             //along with its ID to save later.
@@ -230,7 +230,7 @@ int bandageQueryPaths(QStringList arguments)
         for (int i = 0; i < pathSequenceIDs.size(); ++i)
         {
             pathsOut << ">" + pathSequenceIDs[i] + "\n";
-            pathsOut << AssemblyGraph::addNewlinesToSequence(pathSequences[i]);
+            pathsOut << pathSequences[i];
         }
     }
 
@@ -22,6 +22,7 @@
 #include "../ui/mygraphicsscene.h"
 #include "../ui/mygraphicsview.h"
 #include "../graph/assemblygraph.h"
+#include "../graph/gfatopology.h"
 #include <vector>
 #include "../program/settings.h"
 #include <QPainter>
@@ -63,7 +64,7 @@ int bandageReduce(QStringList arguments)
 
     QString outputFilename = arguments.at(0);
     arguments.pop_front();
-    if (!outputFilename.endsWith(".gfa"))
+    if (!outputFilename.endsWith(".gfa") && !outputFilename.endsWith(".gfa.gz"))
         outputFilename += ".gfa";
 
     QString error = checkForInvalidReduceOptions(arguments);
@@ -73,6 +74,9 @@ int bandageReduce(QStringList arguments)
         return 1;
     }
 
+    if (isOptionPresent("--stream", &arguments))
+        return reduceGfaWithoutLoading(inputFilename, outputFilename, arguments, &err);
+
     bool loadSuccess = g_assemblyGraph->loadGraphFromFile(inputFilename);
     if (!loadSuccess)
     {
@@ -113,7 +117,7 @@ int bandageReduce(QStringList arguments)
         return 1;
     }
 
-    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    g_assemblyGraph->labelDrawnNodesAndEdges(startingNodes, g_settings->nodeDistance);
 
     bool success = g_assemblyGraph->saveVisibleGraphToGfa(outputFilename);
     if (!success)
@@ -139,18 +143,16 @@ void printReduceUsage(QTextStream * out, bool all)
     text << "";
     text << "Positional parameters:";
     text << "<inputgraph>        A graph file of any type supported by Bandage";
-    text << "<outputgraph>       The filename for the GFA graph to be made (if it does not end in '.gfa', that extension will be added)";
+    text << "<outputgraph>       The filename for the GFA graph to be made (if it does not end in '.gfa' or '.gfa.gz', '.gfa' will be added; a '.gfa.gz' file is block-gzipped)";
     text << "";
-
-    int nextLineIndex = text.size();
+    text << "Options:  --stream            Read only the links and segment lengths of a GFA input graph and copy the chosen lines to the output, without loading the whole graph (can only be used with the entire, aroundnodes and aroundbases scopes)";
     getCommonHelp(&text);
-    text[nextLineIndex] = "Options:  " + text[nextLineIndex];
 
     if (all)
         getSettingsUsage(&text);
     else
     {
-        nextLineIndex = text.size();
+        int nextLineIndex = text.size();
         getGraphScopeOptions(&text);
         text[nextLineIndex] = "Settings: " + text[nextLineIndex];
     }
@@ -164,6 +166,70 @@ void printReduceUsage(QTextStream * out, bool all)
 
 QString checkForInvalidReduceOptions(QStringList arguments)
 {
+    checkOptionWithoutValue("--stream", &arguments);
     return checkForInvalidOrExcessSettings(&arguments);
 }
 
+
+
+//This function does the reduce for a GFA file without building the graph.
+//Only the graph's topology is loaded, the scope is applied to that, and the
+//chosen S and L lines are copied from the input file unchanged.  This keeps
+//memory use low for very large graphs, but the scopes which need sequences
+//or depths (BLAST hits and depth range) aren't available.
+int reduceGfaWithoutLoading(QString inputFilename, QString outputFilename,
+                            QStringList arguments, QTextStream * err)
+{
+    if (!g_assemblyGraph->checkFileIsGfa(inputFilename))
+    {
+        outputText("Bandage error: --stream can only be used with a GFA input graph", err);
+        return 1;
+    }
+
+    parseSettings(arguments);
+    if (isOptionPresent("--query", &arguments) ||
+            (g_settings->graphScope != WHOLE_GRAPH && g_settings->graphScope != AROUND_NODE &&
+             g_settings->graphScope != AROUND_BASES))
+    {
+        outputText("Bandage error: --stream can only be used with the entire, aroundnodes and aroundbases scopes", err);
+        return 1;
+    }
+
+    GfaTopology topology;
+    if (!topology.load(inputFilename))
+    {
+        outputText("Bandage error: could not load " + inputFilename, err);
+        return 1;
+    }
+
+    std::vector<char> selected;
+    if (g_settings->graphScope == WHOLE_GRAPH)
+        selected.assign(topology.getSegmentCount(), 1);
+    else
+    {
+        std::vector<QString> nodesNotFound;
+        std::vector<int> startingSegments = topology.findSegments(g_settings->startingNodes,
+                                                                  g_settings->startingNodesExactMatch,
+                                                                  &nodesNotFound);
+        if (nodesNotFound.size() > 0)
+        {
+            *err << g_assemblyGraph->generateNodesNotFoundErrorMessage(nodesNotFound,
+                                                                       g_settings->startingNodesExactMatch) << endl;
+            return 1;
+        }
+
+        if (g_settings->graphScope == AROUND_BASES)
+            selected = topology.selectWithinBases(startingSegments, g_settings->baseDistance);
+        else
+            selected = topology.selectWithinSteps(startingSegments, g_settings->nodeDistance);
+    }
+
+    if (!topology.writeSubgraph(inputFilename, outputFilename, selected))
+    {
+        *err << "Bandage was unable to save the graph file." << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
@@ -27,6 +27,8 @@
 int bandageReduce(QStringList arguments);
 void printReduceUsage(QTextStream * out, bool all);
 QString checkForInvalidReduceOptions(QStringList arguments);
+int reduceGfaWithoutLoading(QString inputFilename, QString outputFilename,
+                            QStringList arguments, QTextStream * err);
 void parseReduceOptions(QStringList arguments, int * width, int * height);
 
 #endif // REDUCE_H
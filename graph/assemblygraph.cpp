@@ -41,6 +41,13 @@
 #include <QList>
 #include <math.h>
 #include <QFileInfo>
+#include "../program/compressedfile.h"
+#include "../program/sequencefilereader.h"
+#include "../program/fastaindex.h"
+#include "../program/recordfilewriter.h"
+#include <QtConcurrentMap>
+#include <QThread>
+#include <cstring>
 #include <QDir>
 #include "ogdfnode.h"
 #include "../command_line/commoncommandlinefunctions.h"
@@ -73,6 +80,8 @@ void AssemblyGraph::cleanUp()
         delete i.value();
     }
     m_deBruijnGraphNodes.clear();
+    m_nodeAttributes.clear();
+    invalidateComponents();
 
     QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(m_deBruijnGraphEdges);
     while (j.hasNext())
@@ -82,6 +91,11 @@ void AssemblyGraph::cleanUp()
     }
     m_deBruijnGraphEdges.clear();
 
+    m_indexedSequences.clear();
+    m_sequenceIndex.clear();
+    m_gfaPaths.clear();
+    m_nodeNameIndex.clear();
+
     m_contiguitySearchDone = false;
 
     clearGraphInfo();
@@ -113,13 +127,8 @@ void AssemblyGraph::createDeBruijnEdge(QString node1Name, QString node2Name,
     DeBruijnNode * negNode2 = m_deBruijnGraphNodes[node2Opposite];
 
     //Quit if the edge already exists
-    const std::vector<DeBruijnEdge *> * edges = node1->getEdgesPointer();
-    for (size_t i = 0; i < edges->size(); ++i)
-    {
-        if ((*edges)[i]->getStartingNode() == node1 &&
-                (*edges)[i]->getEndingNode() == node2)
-            return;
-    }
+    if (node1->doesNodeLeadAway(node2) != 0)
+        return;
 
     //Usually, an edge has a different pair, but it is possible
     //for an edge to be its own pair.
@@ -145,10 +154,19 @@ void AssemblyGraph::createDeBruijnEdge(QString node1Name, QString node2Name,
     if (!isOwnPair)
         m_deBruijnGraphEdges.insert(QPair<DeBruijnNode*, DeBruijnNode*>(backwardEdge->getStartingNode(), backwardEdge->getEndingNode()), backwardEdge);
 
+    //Each edge is given once to each node it touches, so a self-looping edge
+    //or an edge which is its own pair isn't added to the same node twice.
     node1->addEdge(forwardEdge);
-    node2->addEdge(forwardEdge);
-    negNode1->addEdge(backwardEdge);
-    negNode2->addEdge(backwardEdge);
+    if (node2 != node1)
+        node2->addEdge(forwardEdge);
+    if (!isOwnPair)
+    {
+        negNode2->addEdge(backwardEdge);
+        if (negNode1 != negNode2)
+            negNode1->addEdge(backwardEdge);
+    }
+
+    invalidateComponents();
 }
 
 
@@ -237,22 +255,33 @@ void AssemblyGraph::resetEdges()
 }
 
 
+//This function works on the node attribute columns.  Deleted nodes have a
+//length of zero, so they don't affect the result.
 double AssemblyGraph::getMeanDepth(bool drawnNodesOnly)
 {
-    long double depthSum = 0.0;
-    long long totalLength = 0;
+    const double * depths = m_nodeAttributes.m_depths.data();
+    const int * lengths = m_nodeAttributes.m_lengths.data();
+    const char * drawn = m_nodeAttributes.m_drawn.data();
+    int nodeCount = m_nodeAttributes.size();
 
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
+    double depthSum = 0.0;
+    long long totalLength = 0;
+    if (drawnNodesOnly)
     {
-        i.next();
-        DeBruijnNode * node = i.value();
-
-        if (drawnNodesOnly && node->isNotDrawn())
-            continue;
-
-        totalLength += node->getLength();
-        depthSum += node->getLength() * node->getDepth();
+        for (int i = 0; i < nodeCount; ++i)
+        {
+            long long length = drawn[i] ? lengths[i] : 0;
+            totalLength += length;
+            depthSum += length * depths[i];
+        }
+    }
+    else
+    {
+        for (int i = 0; i < nodeCount; ++i)
+        {
+            totalLength += lengths[i];
+            depthSum += lengths[i] * depths[i];
+        }
     }
 
     if (totalLength == 0)
@@ -353,6 +382,8 @@ void AssemblyGraph::clearAllBlastHitPointers()
 
 void AssemblyGraph::determineGraphInfo()
 {
+    invalidateComponents();
+
     m_shortestContig = std::numeric_limits<long long>::max();
     m_longestContig = 0;
     int nodeCount = 0;
@@ -467,7 +498,7 @@ void AssemblyGraph::buildDeBruijnGraphFromLastGraph(QString fullFileName)
     m_depthTag = "KC";
 
     bool firstLine = true;
-    QFile inputFile(fullFileName);
+    CompressedFile inputFile(fullFileName);
     if (inputFile.open(QIODevice::ReadOnly))
     {
         QTextStream in(&inputFile);
@@ -506,8 +537,8 @@ void AssemblyGraph::buildDeBruijnGraphFromLastGraph(QString fullFileName)
                 QByteArray sequence = in.readLine().toLocal8Bit();
                 QByteArray revCompSequence = in.readLine().toLocal8Bit();
 
-                DeBruijnNode * node = new DeBruijnNode(posNodeName, nodeDepth, sequence);
-                DeBruijnNode * reverseComplementNode = new DeBruijnNode(negNodeName, nodeDepth, revCompSequence);
+                DeBruijnNode * node = new DeBruijnNode(&m_nodeAttributes, posNodeName, nodeDepth, sequence);
+                DeBruijnNode * reverseComplementNode = new DeBruijnNode(&m_nodeAttributes, negNodeName, nodeDepth, revCompSequence);
                 node->setReverseComplement(reverseComplementNode);
                 reverseComplementNode->setReverseComplement(node);
                 m_deBruijnGraphNodes.insert(posNodeName, node);
@@ -532,6 +563,8 @@ void AssemblyGraph::buildDeBruijnGraphFromLastGraph(QString fullFileName)
             else if (line.startsWith("NR"))
                 break;
         }
+        if (inputFile.hasError())
+            throw "load error";
         inputFile.close();
 
         setAllEdgesExactOverlap(0);
@@ -571,7 +604,7 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName, bool *unsupp
     *customColours = false;
     *bandageOptionsError = "";
 
-    QFile inputFile(fullFileName);
+    CompressedFile inputFile(fullFileName);
     if (inputFile.open(QIODevice::ReadOnly)) {
         std::vector<QString> edgeStartingNodeNames;
         std::vector<QString> edgeEndingNodeNames;
@@ -735,7 +768,7 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName, bool *unsupp
                     labels.insert(getOppositeNodeName(nodeName), l2);
                 }
 
-                DeBruijnNode * node = new DeBruijnNode(nodeName, nodeDepth, sequence, length);
+                DeBruijnNode * node = new DeBruijnNode(&m_nodeAttributes, nodeName, nodeDepth, sequence, length);
                 m_deBruijnGraphNodes.insert(nodeName, node);
             }
 
@@ -768,8 +801,20 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName, bool *unsupp
                     *unsupportedCigar = true;
                 }
             }
+
+            //Lines beginning with "P" (path) or "W" (walk) are saved in the
+            //path store, to be resolved once all of the nodes are made.
+            else if (lineParts.at(0) == "P")
+                m_gfaPaths.addPathLine(lineParts);
+            else if (lineParts.at(0) == "W")
+                m_gfaPaths.addWalkLine(lineParts);
         }
 
+        //A corrupt or cut short compressed file would otherwise load as a
+        //smaller graph.
+        if (inputFile.hasError())
+            throw "load error";
+
         //Pair up reverse complements, creating them if necessary.
         QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
         while (i.hasNext()) {
@@ -802,6 +847,8 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName, bool *unsupp
             int overlap = edgeOverlaps[i];
             createDeBruijnEdge(node1Name, node2Name, overlap, EXACT_OVERLAP);
         }
+
+        m_gfaPaths.resolvePaths(m_deBruijnGraphNodes, m_nodeAttributes.size());
     }
 
     if (m_deBruijnGraphNodes.size() == 0)
@@ -809,12 +856,12 @@ void AssemblyGraph::buildDeBruijnGraphFromGfa(QString fullFileName, bool *unsupp
 
     // For Canu graphs, if there is a file called *.layout.readToTig, then we
     // can use that to get better read depth values.
-    QFileInfo gfaFileInfo(m_filename);
+    QFileInfo gfaFileInfo(CompressedFile::removeCompressionExtension(m_filename));
     QString baseName = gfaFileInfo.completeBaseName();
     QString readToTigFilename = gfaFileInfo.dir().filePath(baseName + ".layout.readToTig");
     QFileInfo readToTigFileInfo(readToTigFilename);
     if (readToTigFileInfo.exists()) {
-        QFile readToTigFile(readToTigFilename);
+        CompressedFile readToTigFile(readToTigFilename);
         if (readToTigFile.open(QIODevice::ReadOnly)) {
             // Keep track of how many bases are put into each node.
             QMap<QString, long long> baseCounts;
@@ -933,7 +980,7 @@ void AssemblyGraph::buildDeBruijnGraphFromFastg(QString fullFileName)
     m_filename = fullFileName;
     m_depthTag = "KC";
 
-    QFile inputFile(fullFileName);
+    CompressedFile inputFile(fullFileName);
     if (inputFile.open(QIODevice::ReadOnly))
     {
         std::vector<QString> edgeStartingNodeNames;
@@ -983,7 +1030,7 @@ void AssemblyGraph::buildDeBruijnGraphFromFastg(QString fullFileName)
                 nodeDepth = nodeDepthString.toDouble();
 
                 //Make the node
-                node = new DeBruijnNode(nodeName, nodeDepth, ""); //Sequence string is currently empty - will be added to on subsequent lines of the fastg file
+                node = new DeBruijnNode(&m_nodeAttributes, nodeName, nodeDepth, ""); //Sequence string is currently empty - will be added to on subsequent lines of the fastg file
                 m_deBruijnGraphNodes.insert(nodeName, node);
 
                 //The second part of nodeDetails is a comma-delimited list of edge nodes.
@@ -1029,6 +1076,8 @@ void AssemblyGraph::buildDeBruijnGraphFromFastg(QString fullFileName)
             }
         }
 
+        if (inputFile.hasError())
+            throw "load error";
         inputFile.close();
 
         //If all went well, each node will have a reverse complement and the code
@@ -1074,7 +1123,7 @@ void AssemblyGraph::makeReverseComplementNodeIfNecessary(DeBruijnNode * node)
             nodeSequence = "*";
         else
             nodeSequence = node->getSequence();
-        DeBruijnNode * newNode = new DeBruijnNode(reverseComplementName, node->getDepth(),
+        DeBruijnNode * newNode = new DeBruijnNode(&m_nodeAttributes, reverseComplementName, node->getDepth(),
                                                   getReverseComplement(nodeSequence),
                                                   node->getLength());
         m_deBruijnGraphNodes.insert(reverseComplementName, newNode);
@@ -1113,7 +1162,8 @@ void AssemblyGraph::buildDeBruijnGraphFromTrinityFasta(QString fullFileName)
 
     std::vector<QString> names;
     std::vector<QByteArray> sequences;
-    readFastaFile(fullFileName, &names, &sequences);
+    if (!readFastaFile(fullFileName, &names, &sequences))
+        throw "load error";
 
     std::vector<QString> edgeStartingNodeNames;
     std::vector<QString> edgeEndingNodeNames;
@@ -1198,7 +1248,7 @@ void AssemblyGraph::buildDeBruijnGraphFromTrinityFasta(QString fullFileName)
                 int nodeLength = nodeRangeEnd - nodeRangeStart + 1;
 
                 QByteArray nodeSequence = sequence.mid(nodeRangeStart, nodeLength);
-                DeBruijnNode * node = new DeBruijnNode(nodeName, 1.0, nodeSequence);
+                DeBruijnNode * node = new DeBruijnNode(&m_nodeAttributes, nodeName, 1.0, nodeSequence);
                 m_deBruijnGraphNodes.insert(nodeName, node);
             }
 
@@ -1253,7 +1303,7 @@ int AssemblyGraph::buildDeBruijnGraphFromAsqg(QString fullFileName)
 
     int badEdgeCount = 0;
 
-    QFile inputFile(fullFileName);
+    CompressedFile inputFile(fullFileName);
     if (inputFile.open(QIODevice::ReadOnly))
     {
         std::vector<QString> edgeStartingNodeNames;
@@ -1289,7 +1339,7 @@ int AssemblyGraph::buildDeBruijnGraphFromAsqg(QString fullFileName)
                 //ASQG files don't seem to include depth, so just set this to one for every node.
                 double nodeDepth = 1.0;
 
-                DeBruijnNode * node = new DeBruijnNode(nodeName, nodeDepth, sequence, length);
+                DeBruijnNode * node = new DeBruijnNode(&m_nodeAttributes, nodeName, nodeDepth, sequence, length);
                 m_deBruijnGraphNodes.insert(nodeName, node);
             }
 
@@ -1358,6 +1408,9 @@ int AssemblyGraph::buildDeBruijnGraphFromAsqg(QString fullFileName)
             }
         }
 
+        if (inputFile.hasError())
+            throw "load error";
+
         //Pair up reverse complements, creating them if necessary.
         QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
         while (i.hasNext())
@@ -1393,7 +1446,8 @@ void AssemblyGraph::buildDeBruijnGraphFromPlainFasta(QString fullFileName)
 
     std::vector<QString> names;
     std::vector<QByteArray> sequences;
-    readFastaFile(fullFileName, &names, &sequences);
+    if (!readFastaFile(fullFileName, &names, &sequences))
+        throw "load error";
 
     std::vector<QString> circularNodeNames;
     for (size_t i = 0; i < names.size(); ++i)
@@ -1442,7 +1496,7 @@ void AssemblyGraph::buildDeBruijnGraphFromPlainFasta(QString fullFileName)
         if (name.length() < 1)
             throw "load error";
 
-        DeBruijnNode * node = new DeBruijnNode(name, depth, sequence);
+        DeBruijnNode * node = new DeBruijnNode(&m_nodeAttributes, name, depth, sequence);
         m_deBruijnGraphNodes.insert(name, node);
         makeReverseComplementNodeIfNecessary(node);
     }
@@ -1530,7 +1584,7 @@ bool AssemblyGraph::checkFileIsAsqg(QString fullFileName)
 
 bool AssemblyGraph::checkFirstLineOfFile(QString fullFileName, QString regExp)
 {
-    QFile inputFile(fullFileName);
+    CompressedFile inputFile(fullFileName);
     if (inputFile.open(QIODevice::ReadOnly))
     {
         QTextStream in(&inputFile);
@@ -1544,33 +1598,78 @@ bool AssemblyGraph::checkFirstLineOfFile(QString fullFileName, QString regExp)
     return false;
 }
 
-/* Split a QString according to CSV rules
+/* Split a line according to CSV rules
  *
- * @param line  line of a csv
- * @param sep   field separator to use
- * @result      list of fields with escaping removed
+ * @param line    line of a csv, without its line ending
+ * @param sep     field separator to use
+ * @param *fields will contain the fields with escaping removed.  The vector's
+ *                QByteArrays are reused between calls, so it can be larger
+ *                than the number of fields.
+ * @result        the number of fields in the line
  *
  * Known Bugs: CSV (as per RFC4180) allows multi-line fields (\r\n between "..."), which
  *             can't be parsed line-by line an hence isn't supported.
  */
-QStringList AssemblyGraph::splitCsv(QString line, QString sep)
+int AssemblyGraph::splitCsv(const QByteArray & line, char sep, std::vector<QByteArray> * fields)
 {
-    QStringList list;
-    QRegExp rx("(\"(?:[^\"]|\"\")*\"|[^"+sep+"]*)");
-    int pos = 0;
+    const char * data = line.constData();
+    int length = line.length();
+    int fieldCount = 0;
 
-    while (rx.indexIn(line, pos) != -1)
+    int pos = 0;
+    while (pos <= length)
     {
-        QString field = rx.cap().replace("\"\"","\"");
-        if (field[0] == '"' && field[field.length()-1] == '"')
-            field=field.mid(1,field.length()-2);
-        list << field;
-        pos += rx.matchedLength() +1;
+        //A quoted field ends at the first quote which isn't part of a pair.
+        //If there is no such quote, the field is not treated as quoted.
+        int fieldStart = pos;
+        int fieldEnd = -1;
+        if (pos < length && data[pos] == '"')
+        {
+            int i = pos + 1;
+            while (i < length)
+            {
+                if (data[i] == '"')
+                {
+                    if (i + 1 < length && data[i + 1] == '"')
+                        i += 2;
+                    else
+                        break;
+                }
+                else
+                    ++i;
+            }
+            if (i < length)
+                fieldEnd = i + 1;
+        }
+        bool quoted = (fieldEnd != -1);
+        if (!quoted)
+        {
+            const void * sepPosition = memchr(data + pos, sep, length - pos);
+            if (sepPosition == 0)
+                fieldEnd = length;
+            else
+                fieldEnd = int(static_cast<const char *>(sepPosition) - data);
+        }
+
+        if (fieldCount == int(fields->size()))
+            fields->push_back(QByteArray());
+        QByteArray & field = (*fields)[fieldCount++];
+        int valueStart = quoted ? fieldStart + 1 : fieldStart;
+        int valueLength = quoted ? fieldEnd - fieldStart - 2 : fieldEnd - fieldStart;
+        field.resize(valueLength);
+        memcpy(field.data(), data + valueStart, valueLength);
+        if (field.contains("\"\""))
+            field.replace("\"\"", "\"");
+
+        pos = fieldEnd + 1;
     }
-    return list;
+    return fieldCount;
 }
 
 /* Load data from CSV and add to deBruijnGraphNodes
+ *
+ * The file is read as bytes a line at a time and its values are stored by
+ * column in m_csvData, with each matched node given its row.
  *
  * @param filename  the full path of the file to be loaded
  * @param *columns  will contain the names of each column after loading data
@@ -1583,22 +1682,21 @@ bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * e
 {
     clearAllCsvData();
 
-    QFile inputFile(filename);
+    CompressedFile inputFile(filename);
     if (!inputFile.open(QIODevice::ReadOnly))
     {
         *errormsg = "Unable to read from specified file.";
         return false;
     }
-    QTextStream in(&inputFile);
-    QString line = in.readLine();
+    QByteArray line = removeLineEnding(inputFile.readLine());
 
     // guess at separator; this assumes that any tab in the first line means
     // we have a tab separated file
-    QString sep = "\t";
-    if (line.split(sep).length() == 1)
+    char sep = '\t';
+    if (!line.contains(sep))
     {
-        sep = ",";
-        if (line.split(sep).length() == 1)
+        sep = ',';
+        if (!line.contains(sep))
         {
             *errormsg = "Neither tab nor comma in first line. Please check file format.";
             return false;
@@ -1607,13 +1705,16 @@ bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * e
 
     int unmatched_nodes = 0; // keep a counter for lines in file that can't be matched to nodes
 
-    QStringList headers = splitCsv(line, sep);
-    if (headers.size() < 2)
+    std::vector<QByteArray> fields;
+    int fieldCount = splitCsv(line, sep, &fields);
+    if (fieldCount < 2)
     {
         *errormsg = "Not enough CSV headers: at least two required.";
         return false;
     }
-    headers.pop_front();
+    QStringList headers;
+    for (int i = 1; i < fieldCount; ++i)
+        headers << QString::fromUtf8(fields[i]);
 
     //Check to see if any of the columns holds colour data.
     int colourCol = -1;
@@ -1629,19 +1730,33 @@ bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * e
     }
 
     *columns = headers;
-    int columnCount = headers.size();
+    m_csvData.setColumnNames(headers);
     QMap<QString, QColor> colourCategories;
+    QHash<QByteArray, QColor> colourValues;
     std::vector<QColor> presetColours = getPresetColours();
 
-    while (!in.atEnd())
+    //Node names are looked up in a hash, which is faster than the node map.
+    QHash<QString, DeBruijnNode *> nodesByName;
+    nodesByName.reserve(m_deBruijnGraphNodes.size());
+    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
+    while (i.hasNext())
     {
-        QApplication::processEvents();
+        i.next();
+        nodesByName.insert(i.key(), i.value());
+    }
+
+    for (int lineCount = 1; !inputFile.atEnd(); ++lineCount)
+    {
+        if (lineCount % 1000 == 0)
+            QApplication::processEvents();
 
-        QStringList cols = splitCsv(in.readLine(), sep);
-        QString nodeName = getNodeNameFromString(cols[0]);
+        line = removeLineEnding(inputFile.readLine());
+        fieldCount = splitCsv(line, sep, &fields);
+        QString nodeName = getNodeNameFromString(QString::fromUtf8(fields[0]));
 
-        //Get rid of the node name - no need to save that.
-        cols.pop_front();
+        //The first field is the node name - no need to save that.
+        const QByteArray * values = fields.data() + 1;
+        int valueCount = fieldCount - 1;
 
         //If one of the columns holds colour data, get the colour from that one.
         //Acceptable colour formats: 6-digit hex colour (e.g. #FFB6C1), an 8-digit hex colour (e.g. #7FD2B48C) or a
@@ -1649,35 +1764,47 @@ bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * e
         //If the colour value is something other than one of these, a colour will be assigned to the value.  That way
         //categorical names can be used and automatically given colours.
         QColor colour;
-        if (colourCol != -1 && cols.size() > colourCol)
+        if (colourCol != -1 && valueCount > colourCol)
         {
-            QString colourString = cols[colourCol];
-            colour = QColor(colourString);
-            if (!colour.isValid())
+            QHash<QByteArray, QColor>::const_iterator c = colourValues.find(values[colourCol]);
+            if (c != colourValues.end())
+                colour = c.value();
+            else
             {
-                if (!colourCategories.contains(colourString))
+                QString colourString = QString::fromUtf8(values[colourCol]);
+                colour = QColor(colourString);
+                if (!colour.isValid())
                 {
-                    int nextColourIndex = colourCategories.size();
-                    colourCategories[colourString] = presetColours[nextColourIndex];
+                    if (!colourCategories.contains(colourString))
+                    {
+                        int nextColourIndex = colourCategories.size();
+                        colourCategories[colourString] = presetColours[nextColourIndex];
+                    }
+                    colour = colourCategories[colourString];
                 }
-                colour = colourCategories[colourString];
+                colourValues.insert(values[colourCol], colour);
             }
         }
 
-        //Get rid of any extra data that doesn't have a header.
-        while (cols.size() > columnCount)
-            cols.pop_back();
-
-        if (nodeName != "" && m_deBruijnGraphNodes.contains(nodeName))
+        DeBruijnNode * node = 0;
+        if (nodeName != "")
+            node = nodesByName.value(nodeName);
+        if (node != 0)
         {
-            m_deBruijnGraphNodes[nodeName]->setCsvData(cols);
+            node->setCsvRow(m_csvData.addRow(values, valueCount));
             if (colour.isValid())
-                m_deBruijnGraphNodes[nodeName]->setCustomColour(colour);
+                node->setCustomColour(colour);
         }
         else
             ++unmatched_nodes;
     }
 
+    if (inputFile.hasError())
+    {
+        *errormsg = inputFile.errorString();
+        return false;
+    }
+
     if (unmatched_nodes)
         *errormsg = "There were " + QString::number(unmatched_nodes) + " unmatched entries in the CSV.";
 
@@ -1685,6 +1812,19 @@ bool AssemblyGraph::loadCSV(QString filename, QStringList * columns, QString * e
 }
 
 
+//This function removes the line ending (\n or \r\n) from a line.
+QByteArray AssemblyGraph::removeLineEnding(QByteArray line)
+{
+    int length = line.length();
+    if (length > 0 && line[length - 1] == '\n')
+        --length;
+    if (length > 0 && line[length - 1] == '\r')
+        --length;
+    line.truncate(length);
+    return line;
+}
+
+
 //This function extracts a node name from a string.
 //The string may be in this Bandage format:
 //        NODE_6+_length_50434_cov_42.3615
@@ -1778,9 +1918,168 @@ bool AssemblyGraph::loadGraphFromFile(QString filename)
 
 
 
+//This function labels as drawn all nodes within nodeDistance steps of any of
+//the starting nodes.  It is a breadth-first search outward from all of the
+//starting nodes at once, so each node is visited only once, at its smallest
+//distance.  Edges are followed in either direction.
+void AssemblyGraph::labelNeighbouringNodesAsDrawn(const std::vector<DeBruijnNode *> & startingNodes,
+                                                  int nodeDistance)
+{
+    prepareNeighbourSearch();
+
+    std::vector<DeBruijnNode *> queue;
+    for (size_t i = 0; i < startingNodes.size(); ++i)
+    {
+        DeBruijnNode * node = startingNodes[i];
+        if (m_neighbourSearchDistances[node->getId()] >= 0)
+            continue;
+        m_neighbourSearchDistances[node->getId()] = 0;
+        queue.push_back(node);
+    }
+
+    //The queue is a vector read from the front, which doesn't need to remove
+    //anything as no node is added twice.
+    for (size_t i = 0; i < queue.size(); ++i)
+    {
+        DeBruijnNode * node = queue[i];
+        int distance = m_neighbourSearchDistances[node->getId()];
+        if (distance >= nodeDistance)
+            continue;
+
+        const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+        for (size_t j = 0; j < edges->size(); ++j)
+        {
+            DeBruijnNode * otherNode = (*edges)[j]->getOtherNode(node);
+            if (m_neighbourSearchDistances[otherNode->getId()] >= 0)
+                continue;
+            m_neighbourSearchDistances[otherNode->getId()] = distance + 1;
+            queue.push_back(otherNode);
+            labelNodeAsDrawn(otherNode);
+        }
+    }
+
+    finishNeighbourSearch(queue);
+}
+
+
+//This function labels as drawn all nodes which start within baseDistance
+//bases of any of the starting nodes.  A node's distance is the number of
+//bases between the nearest starting node and the node: passing through a
+//node adds its length, less the overlap of the edge used to leave it.  Edges
+//are followed in either direction.
+//It is a Dijkstra search from all of the starting nodes at once, which stops
+//at baseDistance, so its cost depends on the size of the region found and not
+//the size of the graph.
+void AssemblyGraph::labelNodesWithinBasesAsDrawn(const std::vector<DeBruijnNode *> & startingNodes,
+                                                 int baseDistance)
+{
+    prepareNeighbourSearch();
+    m_neighbourSearchHeap.clear();
+
+    std::vector<DeBruijnNode *> visitedNodes;
+    for (size_t i = 0; i < startingNodes.size(); ++i)
+    {
+        DeBruijnNode * node = startingNodes[i];
+        if (m_neighbourSearchDistances[node->getId()] == 0)
+            continue;
+        m_neighbourSearchDistances[node->getId()] = 0;
+        visitedNodes.push_back(node);
+    }
+
+    //The starting nodes' own lengths don't count, so their neighbours are all
+    //at a distance of zero.
+    for (size_t i = 0; i < startingNodes.size(); ++i)
+    {
+        DeBruijnNode * node = startingNodes[i];
+        const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+        for (size_t j = 0; j < edges->size(); ++j)
+        {
+            DeBruijnNode * otherNode = (*edges)[j]->getOtherNode(node);
+            if (m_neighbourSearchDistances[otherNode->getId()] == 0)
+                continue;
+            if (m_neighbourSearchDistances[otherNode->getId()] < 0)
+                visitedNodes.push_back(otherNode);
+            m_neighbourSearchDistances[otherNode->getId()] = 0;
+            m_neighbourSearchHeap.push(0, otherNode->getId());
+            labelNodeAsDrawn(otherNode);
+        }
+    }
+
+    while (!m_neighbourSearchHeap.empty())
+    {
+        std::pair<unsigned int, int> entry = m_neighbourSearchHeap.pop();
+        int distance = int(entry.first);
+        DeBruijnNode * node = m_nodeAttributes.m_nodes[entry.second];
+
+        //Skip entries which were superseded by a shorter distance.
+        if (distance != m_neighbourSearchDistances[node->getId()])
+            continue;
+
+        //The distance to the far side of this node.  If an edge's overlap is
+        //larger than the node, the next node is taken to be no closer than
+        //this one.
+        long long farDistance = (long long)distance + node->getLength();
+        const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+        for (size_t j = 0; j < edges->size(); ++j)
+        {
+            DeBruijnEdge * edge = (*edges)[j];
+            long long nextDistance = std::max((long long)distance, farDistance - edge->getOverlap());
+            if (nextDistance > baseDistance)
+                continue;
+
+            DeBruijnNode * otherNode = edge->getOtherNode(node);
+            int otherDistance = m_neighbourSearchDistances[otherNode->getId()];
+            if (otherDistance >= 0 && otherDistance <= nextDistance)
+                continue;
+            if (otherDistance < 0)
+                visitedNodes.push_back(otherNode);
+            m_neighbourSearchDistances[otherNode->getId()] = int(nextDistance);
+            m_neighbourSearchHeap.push((unsigned int)nextDistance, otherNode->getId());
+            labelNodeAsDrawn(otherNode);
+        }
+    }
+
+    finishNeighbourSearch(visitedNodes);
+}
+
+
+//The distance vector only needs to grow here, as every search puts back the
+//values it changes.
+void AssemblyGraph::prepareNeighbourSearch()
+{
+    if (int(m_neighbourSearchDistances.size()) < m_nodeAttributes.size())
+        m_neighbourSearchDistances.resize(m_nodeAttributes.size(), -1);
+}
+
+
+void AssemblyGraph::finishNeighbourSearch(const std::vector<DeBruijnNode *> & visitedNodes)
+{
+    for (size_t i = 0; i < visitedNodes.size(); ++i)
+        m_neighbourSearchDistances[visitedNodes[i]->getId()] = -1;
+}
+
+
+//In single mode, a negative node is drawn via its positive complement.
+void AssemblyGraph::labelNodeAsDrawn(DeBruijnNode * node)
+{
+    if (g_settings->doubleMode)
+        node->setAsDrawn();
+    else //single mode
+    {
+        if (node->isPositiveNode())
+            node->setAsDrawn();
+        else
+            node->getReverseComplement()->setAsDrawn();
+    }
+}
+
+
+//This function labels the nodes and edges which are in the graph scope as
+//drawn.  It doesn't make anything for OGDF, so it is all that is needed by
+//commands which use the drawn nodes but don't lay out the graph.
 //The startingNodes and nodeDistance parameters are only used if the graph scope
 //is not WHOLE_GRAPH.
-void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *> startingNodes, int nodeDistance)
+void AssemblyGraph::labelDrawnNodesAndEdges(std::vector<DeBruijnNode *> startingNodes, int nodeDistance)
 {
     if (g_settings->graphScope == WHOLE_GRAPH)
     {
@@ -1798,7 +2097,8 @@ void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>
     else //The scope is either around specified nodes, around nodes with BLAST hits or a depth range.
     {
         //Distance is only used for around nodes and around blast scopes, not
-        //for the depth range scope.
+        //for the depth range scope.  The around bases scope uses a distance
+        //in bases instead.
         if (g_settings->graphScope == DEPTH_RANGE)
             nodeDistance = 0;
 
@@ -1812,9 +2112,29 @@ void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>
 
             node->setAsDrawn();
             node->setAsSpecial();
-            node->labelNeighbouringNodesAsDrawn(nodeDistance, 0);
+            startingNodes[i] = node;
         }
+
+        if (g_settings->graphScope == AROUND_BASES)
+            labelNodesWithinBasesAsDrawn(startingNodes, g_settings->baseDistance);
+        else
+            labelNeighbouringNodesAsDrawn(startingNodes, nodeDistance);
+    }
+
+    QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(m_deBruijnGraphEdges);
+    while (j.hasNext())
+    {
+        j.next();
+        j.value()->determineIfDrawn();
     }
+}
+
+
+//The startingNodes and nodeDistance parameters are only used if the graph scope
+//is not WHOLE_GRAPH.
+void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *> startingNodes, int nodeDistance)
+{
+    labelDrawnNodesAndEdges(startingNodes, nodeDistance);
 
     // If performing a linear layout, we first sort the drawn nodes and add them left-to-right.
     if (g_settings->linearLayout) {
@@ -1865,9 +2185,9 @@ void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>
             DeBruijnNode * node = sortedDrawnNodes[i];
             if (node->thisOrReverseComplementInOgdf())
                 continue;
-            std::vector<DeBruijnNode *> upstreamNodes = node->getUpstreamNodes();
-            for (size_t j = 0; j < upstreamNodes.size(); ++j) {
-                DeBruijnNode * upstreamNode = upstreamNodes[j];
+            DeBruijnEdgeRange enteringEdges = node->getEnteringEdgeRange();
+            for (size_t j = 0; j < enteringEdges.size(); ++j) {
+                DeBruijnNode * upstreamNode = enteringEdges[j]->getStartingNode();
                 if (!upstreamNode->inOgdf())
                     continue;
                 ogdf::node upstreamEnd = upstreamNode->getOgdfNode()->getLast();
@@ -1903,13 +2223,12 @@ void AssemblyGraph::buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *>
         }
     }
 
-    //Then loop through each edge determining its drawn status and adding it to OGDF if it is drawn.
+    //Then add each drawn edge to OGDF.
     QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(m_deBruijnGraphEdges);
     while (j.hasNext())
     {
         j.next();
         DeBruijnEdge * edge = j.value();
-        edge->determineIfDrawn();
         if (edge->isDrawn())
             edge->addToOgdfGraph(m_ogdfGraph, m_edgeArray);
     }
@@ -1982,7 +2301,7 @@ std::vector<DeBruijnNode *> AssemblyGraph::getStartingNodes(QString * errorTitle
 {
     std::vector<DeBruijnNode *> startingNodes;
 
-    if (g_settings->graphScope == AROUND_NODE)
+    if (g_settings->graphScope == AROUND_NODE || g_settings->graphScope == AROUND_BASES)
     {
         if (checkIfStringHasNodes(nodesList))
         {
@@ -2041,7 +2360,7 @@ std::vector<DeBruijnNode *> AssemblyGraph::getStartingNodes(QString * errorTitle
     g_settings->doubleMode = doubleMode;
     clearOgdfGraphAndResetNodes();
 
-    if (g_settings->graphScope == AROUND_NODE)
+    if (g_settings->graphScope == AROUND_NODE || g_settings->graphScope == AROUND_BASES)
         startingNodes = getNodesFromString(nodesList, g_settings->startingNodesExactMatch);
     else if (g_settings->graphScope == AROUND_BLAST_HITS)
         startingNodes = getNodesFromBlastHits(blastQueryName);
@@ -2146,30 +2465,25 @@ std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromListExact(QStringList nod
     return returnVector;
 }
 
+//Given a list of node name parts, this function will return all nodes whose
+//names contain any of them.
 std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromListPartial(QStringList nodesList,
                                                                    std::vector<QString> * nodesNotInGraph)
 {
     std::vector<DeBruijnNode *> returnVector;
 
+    if (!m_nodeNameIndex.isUpToDate(m_nodeAttributes))
+        m_nodeNameIndex.build(m_deBruijnGraphNodes, m_nodeAttributes);
+
     for (int i = 0; i < nodesList.size(); ++i)
     {
         QString queryName = nodesList.at(i).simplified();
         if (queryName == "")
             continue;
 
-        bool found = false;
-        QMapIterator<QString, DeBruijnNode*> j(m_deBruijnGraphNodes);
-        while (j.hasNext())
-        {
-            j.next();
-            QString nodeName = j.value()->getName();
-
-            if (nodeName.contains(queryName))
-            {
-                found = true;
-                returnVector.push_back(j.value());
-            }
-        }
+        std::vector<DeBruijnNode *> matchingNodes = m_nodeNameIndex.findNodesContaining(queryName, m_nodeAttributes);
+        returnVector.insert(returnVector.end(), matchingNodes.begin(), matchingNodes.end());
+        bool found = !matchingNodes.empty();
 
         if (!found && nodesNotInGraph != 0)
             nodesNotInGraph->push_back(queryName.trimmed());
@@ -2209,20 +2523,28 @@ std::vector<DeBruijnNode *> AssemblyGraph::getNodesFromBlastHits(QString queryNa
     return returnVector;
 }
 
+static bool compareNodesByName(DeBruijnNode * a, DeBruijnNode * b)
+{
+    return a->getName() < b->getName();
+}
+
 std::vector<DeBruijnNode *> AssemblyGraph::getNodesInDepthRange(double min,
                                                                     double max)
 {
     std::vector<DeBruijnNode *> returnVector;
 
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
+    const double * depths = m_nodeAttributes.m_depths.data();
+    int nodeCount = m_nodeAttributes.size();
+    for (int i = 0; i < nodeCount; ++i)
     {
-        i.next();
-        DeBruijnNode * node = i.value();
-
-        if (node->isInDepthRange(min, max))
+        DeBruijnNode * node = m_nodeAttributes.m_nodes[i];
+        if (node != 0 && depths[i] >= min && depths[i] <= max)
             returnVector.push_back(node);
     }
+
+    //The column is in node ID order, but callers expect the nodes in name
+    //order (as they come from the node map), so only the hits are sorted.
+    std::sort(returnVector.begin(), returnVector.end(), compareNodesByName);
     return returnVector;
 }
 
@@ -2265,18 +2587,82 @@ void AssemblyGraph::setAllEdgesExactOverlap(int overlap)
 
 
 
+//The overlap search for one edge, which can be run in a separate thread.
+struct EdgeOverlapSearch
+{
+    DeBruijnEdge * edge;
+    QByteArray startingSequence;
+    QByteArray endingSequence;
+    bool searched;
+    int min;
+    int max;
+    int firstOverlap;
+    std::vector<int> overlaps;
+};
+
+static bool compareEdgesByNodeNames(DeBruijnEdge * a, DeBruijnEdge * b)
+{
+    QString aStart = a->getStartingNode()->getName();
+    QString bStart = b->getStartingNode()->getName();
+    if (aStart != bStart)
+        return aStart < bStart;
+    return a->getEndingNode()->getName() < b->getEndingNode()->getName();
+}
+
+static void findEdgeOverlaps(EdgeOverlapSearch & search)
+{
+    if (search.searched)
+        search.overlaps = DeBruijnEdge::findExactOverlaps(search.startingSequence,
+                                                          search.endingSequence,
+                                                          search.min, search.max);
+}
+
+
 void AssemblyGraph::autoDetermineAllEdgesExactOverlap()
 {
     int edgeCount = int(m_deBruijnGraphEdges.size());
     if (edgeCount == 0)
         return;
 
-    //Determine the overlap for each edge.
+    //Prepare the search for each edge.  The edges are sorted by their node
+    //names (the edge map is ordered by pointer) so that each edge gets the
+    //same pseudorandom starting overlap for a given random seed.
+    std::vector<DeBruijnEdge *> edges;
+    edges.reserve(edgeCount);
     QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> i(m_deBruijnGraphEdges);
     while (i.hasNext())
     {
         i.next();
-        i.value()->autoDetermineExactOverlap();
+        edges.push_back(i.value());
+    }
+    std::sort(edges.begin(), edges.end(), compareEdgesByNodeNames);
+
+    std::vector<EdgeOverlapSearch> searches(edgeCount);
+    for (int k = 0; k < edgeCount; ++k)
+    {
+        EdgeOverlapSearch & search = searches[k];
+        search.edge = edges[k];
+        search.searched = search.edge->getAutoOverlapSearchRange(&search.min, &search.max);
+        if (search.searched)
+        {
+            search.firstOverlap = search.min + (rand() % (search.max - search.min + 1));
+            search.startingSequence = search.edge->getStartingNode()->getSequence();
+            search.endingSequence = search.edge->getEndingNode()->getSequence();
+        }
+    }
+
+    //Find every matching overlap for each edge, in parallel.
+    QtConcurrent::blockingMap(searches, findEdgeOverlaps);
+
+    //Determine the overlap for each edge.
+    for (int k = 0; k < edgeCount; ++k)
+    {
+        EdgeOverlapSearch & search = searches[k];
+        search.edge->setOverlapType(AUTO_DETERMINED_EXACT_OVERLAP);
+        if (search.searched)
+            search.edge->setOverlap(DeBruijnEdge::chooseExactOverlap(search.overlaps, search.firstOverlap));
+        else
+            search.edge->setOverlap(0);
     }
 
     //The expectation here is that most overlaps will be
@@ -2317,19 +2703,26 @@ void AssemblyGraph::autoDetermineAllEdgesExactOverlap()
     }
 
     //For each edge, see if one of the more common overlaps also works.
-    //If so, use that instead.
-    QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(m_deBruijnGraphEdges);
-    while (j.hasNext())
+    //If so, use that instead.  Overlaps in the edge's search range were all
+    //found above, so only ones outside of it need to be tested.
+    for (int j = 0; j < edgeCount; ++j)
     {
-        j.next();
-        DeBruijnEdge * edge = j.value();
+        const EdgeOverlapSearch & search = searches[j];
+        DeBruijnEdge * edge = search.edge;
         for (size_t k = 0; k < sortedOverlaps.size(); ++k)
         {
-            if (edge->getOverlap() == sortedOverlaps[k])
+            int overlap = sortedOverlaps[k];
+            if (edge->getOverlap() == overlap)
                 break;
-            else if (edge->testExactOverlap(sortedOverlaps[k]))
+
+            bool overlapWorks;
+            if (search.searched && overlap >= search.min && overlap <= search.max)
+                overlapWorks = std::binary_search(search.overlaps.begin(), search.overlaps.end(), overlap);
+            else
+                overlapWorks = edge->testExactOverlap(overlap);
+            if (overlapWorks)
             {
-                edge->setOverlap(sortedOverlaps[k]);
+                edge->setOverlap(overlap);
                 break;
             }
         }
@@ -2375,70 +2768,46 @@ QString AssemblyGraph::getOppositeNodeName(QString nodeName)
 }
 
 
-void AssemblyGraph::readFastaFile(QString filename, std::vector<QString> * names, std::vector<QByteArray> *sequences)
+//This function reads all of the records in a FASTA (or FASTQ) file.  Only
+//records with a name are kept.  It returns false if the file couldn't be read
+//to its end, e.g. a compressed file which is corrupt.
+bool AssemblyGraph::readFastaFile(QString filename, std::vector<QString> * names, std::vector<QByteArray> *sequences)
 {
-    QFile inputFile(filename);
-    if (inputFile.open(QIODevice::ReadOnly))
-    {
-        QString name = "";
-        QByteArray sequence = "";
+    SequenceFileReader reader(filename);
+    if (!reader.open())
+        return false;
 
-        QTextStream in(&inputFile);
-        while (!in.atEnd())
-        {
+    int recordCount = 0;
+    while (reader.readNext())
+    {
+        if (++recordCount % 1000 == 0)
             QApplication::processEvents();
 
-            QString line = in.readLine();
-
-            if (line.length() == 0)
-                continue;
-
-            if (line.at(0) == '>')
-            {
-                //If there is a current sequence, add it to the vectors now.
-                if (name.length() > 0)
-                {
-                    names->push_back(name);
-                    sequences->push_back(sequence);
-                }
-
-                line.remove(0, 1); //Remove '>' from start
-                name = line;
-                sequence = "";
-            }
-
-            else //It's a sequence line
-                sequence += line.simplified();
-        }
-
-        //Add the last target to the results now.
-        if (name.length() > 0)
-        {
-            names->push_back(name);
-            sequences->push_back(sequence);
-        }
-
-        inputFile.close();
+        if (reader.getName().isEmpty())
+            continue;
+        //The sequence is copied at its exact size, so the reader can keep
+        //reusing its own buffer.
+        const QByteArray & sequence = reader.getSequence();
+        names->push_back(QString::fromUtf8(reader.getName()));
+        sequences->push_back(QByteArray(sequence.constData(), sequence.length()));
     }
+    return !reader.hasError();
 }
 
 
 void AssemblyGraph::recalculateAllDepthsRelativeToDrawnMean()
 {
     double meanDrawnDepth = getMeanDepth(true);
-    QMapIterator<QString, DeBruijnNode*> k(m_deBruijnGraphNodes);
-    while (k.hasNext())
-    {
-        k.next();
-        DeBruijnNode * node = k.value();
-
-        double depthRelativeToMeanDrawnDepth;
-        if (meanDrawnDepth == 0)
-            depthRelativeToMeanDrawnDepth = 1.0;
-        else
-            depthRelativeToMeanDrawnDepth = node->getDepth() / meanDrawnDepth;
+    const double * depths = m_nodeAttributes.m_depths.data();
+    double * relativeDepths = m_nodeAttributes.m_relativeDepths.data();
+    int nodeCount = m_nodeAttributes.size();
 
-        node->setDepthRelativeToMeanDrawnDepth(depthRelativeToMeanDrawnDepth);
+    if (meanDrawnDepth == 0)
+        std::fill(relativeDepths, relativeDepths + nodeCount, 1.0);
+    else
+    {
+        for (int i = 0; i < nodeCount; ++i)
+            relativeDepths[i] = depths[i] / meanDrawnDepth;
     }
 }
 
@@ -2465,6 +2834,7 @@ void AssemblyGraph::clearAllCsvData()
         i.next();
         i.value()->clearCsvData();
     }
+    m_csvData.clear();
 }
 
 
@@ -2486,88 +2856,117 @@ int AssemblyGraph::getDrawnNodeCount() const
 }
 
 
-void AssemblyGraph::deleteNodes(std::vector<DeBruijnNode *> * nodes)
+int AssemblyGraph::deleteNodes(std::vector<DeBruijnNode *> * nodes)
 {
-    //Build a list of nodes to delete.
-    QList<DeBruijnNode *> nodesToDelete;
-    for (size_t i = 0; i < nodes->size(); ++i)
-    {
-        DeBruijnNode * node = (*nodes)[i];
-        DeBruijnNode * rcNode = node->getReverseComplement();
+    return deleteNodesAndEdges(nodes, 0);
+}
 
-        if (!nodesToDelete.contains(node))
-            nodesToDelete.push_back(node);
-        if (!nodesToDelete.contains(rcNode))
-            nodesToDelete.push_back(rcNode);
-    }
+void AssemblyGraph::deleteEdges(std::vector<DeBruijnEdge *> * edges)
+{
+    deleteNodesAndEdges(0, edges);
+}
 
-    //Build a list of edges to delete.
-    std::vector<DeBruijnEdge *> edgesToDelete;
-    for (int i = 0; i < nodesToDelete.size(); ++i)
+
+//This function deletes the given nodes and edges (either can be null), along
+//with their reverse complements and any other edges that touch the deleted
+//nodes.  The deletions are collected first, then each remaining node which
+//lost edges has its edge vector compacted once, so the time taken depends on
+//the number of deleted nodes and edges, not on the size of the graph.
+//GFA paths through the deleted nodes are dropped, and the number dropped is
+//returned.
+int AssemblyGraph::deleteNodesAndEdges(std::vector<DeBruijnNode *> * nodes,
+                                       std::vector<DeBruijnEdge *> * edges)
+{
+    invalidateComponents();
+
+    //Build a set of nodes to delete.
+    QSet<DeBruijnNode *> nodesToDelete;
+    if (nodes != 0)
     {
-        DeBruijnNode * node = nodesToDelete[i];
-        const std::vector<DeBruijnEdge *> * nodeEdges = node->getEdgesPointer();
-        for (size_t j = 0; j < nodeEdges->size(); ++j)
+        for (size_t i = 0; i < nodes->size(); ++i)
         {
-            DeBruijnEdge * edge = (*nodeEdges)[j];
-            bool alreadyAdded = std::find(edgesToDelete.begin(), edgesToDelete.end(), edge) != edgesToDelete.end();
-            if (!alreadyAdded)
-                edgesToDelete.push_back(edge);
+            DeBruijnNode * node = (*nodes)[i];
+            nodesToDelete.insert(node);
+            nodesToDelete.insert(node->getReverseComplement());
         }
     }
 
-    //Build a list of node names to delete.
-    QStringList nodesNamesToDelete;
-    for (int i = 0; i < nodesToDelete.size(); ++i)
-    {
-        DeBruijnNode * node = nodesToDelete[i];
-        nodesNamesToDelete.push_back(node->getName());
-    }
-
-    //Remove the edges from the graph,
-    deleteEdges(&edgesToDelete);
-
-    //Remove the nodes from the graph.
-    for (int i = 0; i < nodesNamesToDelete.size(); ++i)
+    //Build a set of edges to delete: those given and those touching the
+    //deleted nodes.
+    QSet<DeBruijnEdge *> edgesToDelete;
+    if (edges != 0)
     {
-        QString nodeName = nodesNamesToDelete[i];
-        m_deBruijnGraphNodes.remove(nodeName);
+        for (size_t i = 0; i < edges->size(); ++i)
+        {
+            DeBruijnEdge * edge = (*edges)[i];
+            edgesToDelete.insert(edge);
+            edgesToDelete.insert(edge->getReverseComplement());
+        }
     }
-    for (int i = 0; i < nodesToDelete.size(); ++i)
+    QSetIterator<DeBruijnNode *> i(nodesToDelete);
+    while (i.hasNext())
     {
-        DeBruijnNode * node = nodesToDelete[i];
-        delete node;
+        const std::vector<DeBruijnEdge *> * nodeEdges = i.next()->getEdgesPointer();
+        for (size_t j = 0; j < nodeEdges->size(); ++j)
+            edgesToDelete.insert((*nodeEdges)[j]);
     }
-}
 
-void AssemblyGraph::deleteEdges(std::vector<DeBruijnEdge *> * edges)
-{
-    //Build a list of edges to delete.
-    QList<DeBruijnEdge *> edgesToDelete;
-    for (size_t i = 0; i < edges->size(); ++i)
-    {
-        DeBruijnEdge * edge = (*edges)[i];
-        DeBruijnEdge * rcEdge = edge->getReverseComplement();
-
-        if (!edgesToDelete.contains(edge))
-            edgesToDelete.push_back(edge);
-        if (!edgesToDelete.contains(rcEdge))
-            edgesToDelete.push_back(rcEdge);
-    }
-
-    //Remove the edges from the graph,
-    for (int i = 0; i < edgesToDelete.size(); ++i)
+    //Remove the edges from the graph.  Nodes which will be deleted don't need
+    //their edge vectors updated.
+    QSet<DeBruijnNode *> nodesLosingEdges;
+    QSetIterator<DeBruijnEdge *> j(edgesToDelete);
+    while (j.hasNext())
     {
-        DeBruijnEdge * edge = edgesToDelete[i];
+        DeBruijnEdge * edge = j.next();
         DeBruijnNode * startingNode = edge->getStartingNode();
         DeBruijnNode * endingNode = edge->getEndingNode();
-
         m_deBruijnGraphEdges.remove(QPair<DeBruijnNode*, DeBruijnNode*>(startingNode, endingNode));
-        startingNode->removeEdge(edge);
-        endingNode->removeEdge(edge);
+        if (!nodesToDelete.contains(startingNode))
+            nodesLosingEdges.insert(startingNode);
+        if (!nodesToDelete.contains(endingNode))
+            nodesLosingEdges.insert(endingNode);
+    }
+    QSetIterator<DeBruijnNode *> k(nodesLosingEdges);
+    while (k.hasNext())
+        k.next()->removeEdges(edgesToDelete);
+    qDeleteAll(edgesToDelete);
+
+    //The GFA paths refer to nodes by ID, so the nodes in the table are noted
+    //before any are deleted or renumbered.
+    bool renumberGfaPaths = m_gfaPaths.getPathCount() > 0 && !nodesToDelete.isEmpty();
+    std::vector<DeBruijnNode *> nodesBeforeDeletion;
+    if (renumberGfaPaths)
+    {
+        nodesBeforeDeletion = m_nodeAttributes.m_nodes;
+        QSetIterator<DeBruijnNode *> l(nodesToDelete);
+        while (l.hasNext())
+            nodesBeforeDeletion[l.next()->getId()] = 0;
+    }
 
-        delete edge;
+    //Remove the nodes from the graph.
+    QSetIterator<DeBruijnNode *> l(nodesToDelete);
+    while (l.hasNext())
+    {
+        DeBruijnNode * node = l.next();
+        m_deBruijnGraphNodes.remove(node->getName());
+        m_indexedSequences.remove(node);
+        delete node;
     }
+    m_nodeAttributes.compactIfSparse();
+
+    //Paths through the deleted nodes are dropped and the others are given
+    //the nodes' new IDs.
+    if (renumberGfaPaths)
+    {
+        std::vector<int> newIds(nodesBeforeDeletion.size(), -1);
+        for (size_t id = 0; id < nodesBeforeDeletion.size(); ++id)
+        {
+            if (nodesBeforeDeletion[id] != 0)
+                newIds[id] = nodesBeforeDeletion[id]->getId();
+        }
+        return m_gfaPaths.renumberNodes(newIds, m_nodeAttributes.size());
+    }
+    return 0;
 }
 
 
@@ -2577,6 +2976,8 @@ void AssemblyGraph::deleteEdges(std::vector<DeBruijnEdge *> * edges)
 //two, giving half to each node.
 void AssemblyGraph::duplicateNodePair(DeBruijnNode * node, MyGraphicsScene * scene)
 {
+    invalidateComponents();
+
     DeBruijnNode * originalPosNode = node;
     DeBruijnNode * originalNegNode = node->getReverseComplement();
 
@@ -2587,8 +2988,8 @@ void AssemblyGraph::duplicateNodePair(DeBruijnNode * node, MyGraphicsScene * sce
     double newDepth = node->getDepth() / 2.0;
 
     //Create the new nodes.
-    DeBruijnNode * newPosNode = new DeBruijnNode(newPosNodeName, newDepth, originalPosNode->getSequence());
-    DeBruijnNode * newNegNode = new DeBruijnNode(newNegNodeName, newDepth, originalNegNode->getSequence());
+    DeBruijnNode * newPosNode = new DeBruijnNode(&m_nodeAttributes, newPosNodeName, newDepth, originalPosNode->getSequence());
+    DeBruijnNode * newNegNode = new DeBruijnNode(&m_nodeAttributes, newNegNodeName, newDepth, originalNegNode->getSequence());
     newPosNode->setReverseComplement(newNegNode);
     newNegNode->setReverseComplement(newPosNode);
 
@@ -2597,8 +2998,8 @@ void AssemblyGraph::duplicateNodePair(DeBruijnNode * node, MyGraphicsScene * sce
     newNegNode->setCustomColour(originalNegNode->getCustomColour());
     newPosNode->setCustomLabel(originalPosNode->getCustomLabel());
     newNegNode->setCustomLabel(originalNegNode->getCustomLabel());
-    newPosNode->setCsvData(originalPosNode->getAllCsvData());
-    newNegNode->setCsvData(originalNegNode->getAllCsvData());
+    newPosNode->setCsvRow(originalPosNode->getCsvRow());
+    newNegNode->setCsvRow(originalNegNode->getCsvRow());
 
     m_deBruijnGraphNodes.insert(newPosNodeName, newPosNode);
     m_deBruijnGraphNodes.insert(newNegNodeName, newNegNode);
@@ -2694,6 +3095,26 @@ void AssemblyGraph::duplicateGraphicsNode(DeBruijnNode * originalNode, DeBruijnN
 }
 
 
+//This function notes, for each node in a chain being merged (and its reverse
+//complement), the merged node which replaces it and its place in that node's
+//chain, so the GFA paths can be moved onto the merged nodes.
+static void noteMergedChain(const QList<DeBruijnNode *> & nodes, DeBruijnNode * newPosNode,
+                            std::vector<int> * mergedIds, std::vector<int> * chainPositions)
+{
+    DeBruijnNode * newNegNode = newPosNode->getReverseComplement();
+    int lastPosition = nodes.size() - 1;
+    for (int i = 0; i < nodes.size(); ++i)
+    {
+        int posId = nodes[i]->getId();
+        int negId = nodes[i]->getReverseComplement()->getId();
+        (*mergedIds)[posId] = newPosNode->getId();
+        (*chainPositions)[posId] = i;
+        (*mergedIds)[negId] = newNegNode->getId();
+        (*chainPositions)[negId] = lastPosition - i;
+    }
+}
+
+
 //This function will merge the given nodes, if possible.  Nodes can only be
 //merged if they are in a simple, unbranching path with no extra edges.  If the
 //merge is successful, it returns true, otherwise false.
@@ -2786,8 +3207,8 @@ bool AssemblyGraph::mergeNodes(QList<DeBruijnNode *> nodes, MyGraphicsScene * sc
     QString newPosNodeName = newNodeBaseName + "+";
     QString newNegNodeName = newNodeBaseName + "-";
 
-    DeBruijnNode * newPosNode = new DeBruijnNode(newPosNodeName, mergedNodeDepth, mergedNodePosSequence);
-    DeBruijnNode * newNegNode = new DeBruijnNode(newNegNodeName, mergedNodeDepth, mergedNodeNegSequence);
+    DeBruijnNode * newPosNode = new DeBruijnNode(&m_nodeAttributes, newPosNodeName, mergedNodeDepth, mergedNodePosSequence);
+    DeBruijnNode * newNegNode = new DeBruijnNode(&m_nodeAttributes, newNegNodeName, mergedNodeDepth, mergedNodeNegSequence);
 
     newPosNode->setReverseComplement(newNegNode);
     newNegNode->setReverseComplement(newPosNode);
@@ -2831,6 +3252,14 @@ bool AssemblyGraph::mergeNodes(QList<DeBruijnNode *> nodes, MyGraphicsScene * sc
 
     mergeGraphicsNodes(&orderedList, &revCompOrderedList, newPosNode, scene);
 
+    if (m_gfaPaths.getPathCount() > 0)
+    {
+        std::vector<int> mergedIds(m_nodeAttributes.size(), -1);
+        std::vector<int> chainPositions(m_nodeAttributes.size(), -1);
+        noteMergedChain(orderedList, newPosNode, &mergedIds, &chainPositions);
+        m_gfaPaths.mergeNodeRuns(mergedIds, chainPositions, m_nodeAttributes.size());
+    }
+
     std::vector<DeBruijnNode *> nodesToDelete;
     for (int i = 0; i < orderedList.size(); ++i)
         nodesToDelete.push_back(orderedList[i]);
@@ -2844,8 +3273,8 @@ bool AssemblyGraph::canAddNodeToStartOfMergeList(QList<DeBruijnNode *> * mergeLi
                                                  DeBruijnNode * potentialNode)
 {
     DeBruijnNode * firstNode = mergeList->front();
-    std::vector<DeBruijnEdge *> edgesEnteringFirstNode = firstNode->getEnteringEdges();
-    std::vector<DeBruijnEdge *> edgesLeavingPotentialNode = potentialNode->getLeavingEdges();
+    DeBruijnEdgeRange edgesEnteringFirstNode = firstNode->getEnteringEdgeRange();
+    DeBruijnEdgeRange edgesLeavingPotentialNode = potentialNode->getLeavingEdgeRange();
     return (edgesEnteringFirstNode.size() == 1 &&
             edgesLeavingPotentialNode.size() == 1 &&
             edgesEnteringFirstNode[0]->getStartingNode() == potentialNode &&
@@ -2857,8 +3286,8 @@ bool AssemblyGraph::canAddNodeToEndOfMergeList(QList<DeBruijnNode *> * mergeList
                                                DeBruijnNode * potentialNode)
 {
     DeBruijnNode * lastNode = mergeList->back();
-    std::vector<DeBruijnEdge *> edgesLeavingLastNode = lastNode->getLeavingEdges();
-    std::vector<DeBruijnEdge *> edgesEnteringPotentialNode = potentialNode->getEnteringEdges();
+    DeBruijnEdgeRange edgesLeavingLastNode = lastNode->getLeavingEdgeRange();
+    DeBruijnEdgeRange edgesEnteringPotentialNode = potentialNode->getEnteringEdgeRange();
     return (edgesLeavingLastNode.size() == 1 &&
             edgesEnteringPotentialNode.size() == 1 &&
             edgesLeavingLastNode[0]->getEndingNode() == potentialNode &&
@@ -2893,13 +3322,19 @@ void AssemblyGraph::mergeGraphicsNodes(QList<DeBruijnNode *> * originalNodes,
 {
     bool success = mergeGraphicsNodes2(originalNodes, newNode, scene);
     if (success)
+    {
         newNode->setAsDrawn();
+        addGraphicsItemEdges(newNode, scene);
+    }
 
     if (g_settings->doubleMode) {
         DeBruijnNode * newRevComp = newNode->getReverseComplement();
         bool revCompSuccess = mergeGraphicsNodes2(revCompOriginalNodes, newRevComp, scene);
         if (revCompSuccess)
+        {
             newRevComp->setAsDrawn();
+            addGraphicsItemEdges(newRevComp, scene);
+        }
     }
 
     std::vector<DeBruijnNode *> nodesToRemove;
@@ -2963,113 +3398,207 @@ bool AssemblyGraph::mergeGraphicsNodes2(QList<DeBruijnNode *> * originalNodes,
         newGraphicsItemNode->setNodeColour();
 
         scene->addItem(newGraphicsItemNode);
-
-        const std::vector<DeBruijnEdge *> * newEdges = newNode->getEdgesPointer();
-        for (size_t i = 0; i < newEdges->size(); ++i)
-        {
-            DeBruijnEdge * newEdge = (*newEdges)[i];
-            GraphicsItemEdge * graphicsItemEdge = new GraphicsItemEdge(newEdge);
-            graphicsItemEdge->setZValue(-1.0);
-            newEdge->setGraphicsItemEdge(graphicsItemEdge);
-            graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
-            scene->addItem(graphicsItemEdge);
-        }
     }
     return success;
 }
 
 
+//This function makes graphics items for the node's edges.  If onlyMissing is
+//true, it skips edges which already have one or which shouldn't be drawn.
+void AssemblyGraph::addGraphicsItemEdges(DeBruijnNode * node, MyGraphicsScene * scene,
+                                         bool onlyMissing)
+{
+    const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+    for (size_t i = 0; i < edges->size(); ++i)
+    {
+        DeBruijnEdge * edge = (*edges)[i];
+        if (onlyMissing && (edge->getGraphicsItemEdge() != 0 || !edge->edgeIsVisible()))
+            continue;
+        GraphicsItemEdge * graphicsItemEdge = new GraphicsItemEdge(edge);
+        graphicsItemEdge->setZValue(-1.0);
+        edge->setGraphicsItemEdge(graphicsItemEdge);
+        graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
+        scene->addItem(graphicsItemEdge);
+    }
+}
+
+
 
 //If reverseComplement is true, this function will also remove the graphics items for reverse complements of the nodes.
 void AssemblyGraph::removeGraphicsItemNodes(const std::vector<DeBruijnNode *> * nodes,
                                             bool reverseComplement,
                                             MyGraphicsScene * scene)
 {
-    QSet<GraphicsItemNode *> graphicsItemNodesToDelete;
-    for (size_t i = 0; i < nodes->size(); ++i)
-    {
-        DeBruijnNode * node = (*nodes)[i];
-        removeAllGraphicsEdgesFromNode(node, reverseComplement, scene);
+    removeGraphicsItems(nodes, 0, reverseComplement, scene);
+}
 
-        GraphicsItemNode * graphicsItemNode = node->getGraphicsItemNode();
-        if (graphicsItemNode != 0 && !graphicsItemNodesToDelete.contains(graphicsItemNode))
-            graphicsItemNodesToDelete.insert(graphicsItemNode);
-        node->setGraphicsItemNode(0);
 
-        if (reverseComplement)
+void AssemblyGraph::removeGraphicsItemEdges(const std::vector<DeBruijnEdge *> * edges,
+                                            bool reverseComplement,
+                                            MyGraphicsScene * scene)
+{
+    removeGraphicsItems(0, edges, reverseComplement, scene);
+}
+
+
+//This function removes the graphics items for the given nodes (and all of
+//their edges) and the given edges.  Either can be null.  The items are
+//collected first and then taken out of the scene together, with the scene's
+//signals blocked only once.
+void AssemblyGraph::removeGraphicsItems(const std::vector<DeBruijnNode *> * nodes,
+                                        const std::vector<DeBruijnEdge *> * edges,
+                                        bool reverseComplement,
+                                        MyGraphicsScene * scene)
+{
+    QSet<GraphicsItemNode *> graphicsItemNodesToDelete;
+    QSet<GraphicsItemEdge *> graphicsItemEdgesToDelete;
+    if (nodes != 0)
+    {
+        for (size_t i = 0; i < nodes->size(); ++i)
         {
-            DeBruijnNode * rcNode = node->getReverseComplement();
-            GraphicsItemNode * rcGraphicsItemNode = rcNode->getGraphicsItemNode();
-            if (rcGraphicsItemNode != 0 && !graphicsItemNodesToDelete.contains(rcGraphicsItemNode))
-                graphicsItemNodesToDelete.insert(rcGraphicsItemNode);
-            rcNode->setGraphicsItemNode(0);
+            DeBruijnNode * node = (*nodes)[i];
+            collectGraphicsItemNode(node, &graphicsItemNodesToDelete, &graphicsItemEdgesToDelete, reverseComplement);
+            if (reverseComplement)
+                collectGraphicsItemNode(node->getReverseComplement(), &graphicsItemNodesToDelete, &graphicsItemEdgesToDelete, reverseComplement);
         }
     }
+    if (edges != 0)
+    {
+        for (size_t i = 0; i < edges->size(); ++i)
+            collectGraphicsItemEdge((*edges)[i], &graphicsItemEdgesToDelete, reverseComplement);
+    }
 
     if (scene != 0)
         scene->blockSignals(true);
-    QSetIterator<GraphicsItemNode *> i(graphicsItemNodesToDelete);
+    QSetIterator<GraphicsItemEdge *> i(graphicsItemEdgesToDelete);
     while (i.hasNext())
     {
-        GraphicsItemNode * graphicsItemNode = i.next();
-        if (graphicsItemNode != 0)
-        {
-            if (scene != 0)
-                scene->removeItem(graphicsItemNode);
-            delete graphicsItemNode;
-        }
+        GraphicsItemEdge * graphicsItemEdge = i.next();
+        if (scene != 0)
+            scene->removeItem(graphicsItemEdge);
+        delete graphicsItemEdge;
+    }
+    QSetIterator<GraphicsItemNode *> j(graphicsItemNodesToDelete);
+    while (j.hasNext())
+    {
+        GraphicsItemNode * graphicsItemNode = j.next();
+        if (scene != 0)
+            scene->removeItem(graphicsItemNode);
+        delete graphicsItemNode;
     }
     if (scene != 0)
         scene->blockSignals(false);
 }
 
 
-void AssemblyGraph::removeAllGraphicsEdgesFromNode(DeBruijnNode * node, bool reverseComplement,
-                                                   MyGraphicsScene * scene)
+void AssemblyGraph::collectGraphicsItemNode(DeBruijnNode * node,
+                                            QSet<GraphicsItemNode *> * graphicsItemNodes,
+                                            QSet<GraphicsItemEdge *> * graphicsItemEdges,
+                                            bool reverseComplement)
 {
     const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
-    removeGraphicsItemEdges(edges, reverseComplement, scene);
+    for (size_t i = 0; i < edges->size(); ++i)
+        collectGraphicsItemEdge((*edges)[i], graphicsItemEdges, reverseComplement);
+
+    GraphicsItemNode * graphicsItemNode = node->getGraphicsItemNode();
+    if (graphicsItemNode != 0)
+        graphicsItemNodes->insert(graphicsItemNode);
+    node->setGraphicsItemNode(0);
 }
 
-void AssemblyGraph::removeGraphicsItemEdges(const std::vector<DeBruijnEdge *> * edges,
-                                            bool reverseComplement,
-                                            MyGraphicsScene * scene)
+
+void AssemblyGraph::collectGraphicsItemEdge(DeBruijnEdge * edge,
+                                            QSet<GraphicsItemEdge *> * graphicsItemEdges,
+                                            bool reverseComplement)
 {
-    QSet<GraphicsItemEdge *> graphicsItemEdgesToDelete;
-    for (size_t i = 0; i < edges->size(); ++i)
+    GraphicsItemEdge * graphicsItemEdge = edge->getGraphicsItemEdge();
+    if (graphicsItemEdge != 0)
+        graphicsItemEdges->insert(graphicsItemEdge);
+    edge->setGraphicsItemEdge(0);
+
+    if (reverseComplement)
     {
-        DeBruijnEdge * edge = (*edges)[i];
+        DeBruijnEdge * rcEdge = edge->getReverseComplement();
+        GraphicsItemEdge * rcGraphicsItemEdge = rcEdge->getGraphicsItemEdge();
+        if (rcGraphicsItemEdge != 0)
+            graphicsItemEdges->insert(rcGraphicsItemEdge);
+        rcEdge->setGraphicsItemEdge(0);
+    }
+}
 
-        GraphicsItemEdge * graphicsItemEdge = edge->getGraphicsItemEdge();
-        if (graphicsItemEdge != 0 && !graphicsItemEdgesToDelete.contains(graphicsItemEdge))
-            graphicsItemEdgesToDelete.insert(graphicsItemEdge);
-        edge->setGraphicsItemEdge(0);
 
+//One chain of nodes for mergeAllPossible to merge.  The overlaps are those of
+//the edges between consecutive nodes.
+struct UnitigMerge
+{
+    QList<DeBruijnNode *> nodes;
+    QList<int> overlaps;
+    QByteArray posSequence;
+    QByteArray negSequence;
+    DeBruijnNode * newPosNode;
+};
+
+
+//This function joins the sequences of a chain of nodes in the same way as
+//Path::getPathSequence: positive overlaps are trimmed from the start of each
+//node after the first and negative overlaps are filled with Ns.  The length
+//is worked out first so the sequence is only allocated once.
+static QByteArray joinChainSequences(const QList<DeBruijnNode *> & nodes, const QList<int> & overlaps,
+                                     bool reverseComplement)
+{
+    int nodeCount = nodes.size();
+    std::vector<QByteArray> sequences(nodeCount);
+    std::vector<int> chainOverlaps(nodeCount, 0);
+    for (int i = 0; i < nodeCount; ++i)
+    {
         if (reverseComplement)
         {
-            DeBruijnEdge * rcEdge = edge->getReverseComplement();
-            GraphicsItemEdge * rcGraphicsItemEdge = rcEdge->getGraphicsItemEdge();
-            if (rcGraphicsItemEdge != 0 && !graphicsItemEdgesToDelete.contains(rcGraphicsItemEdge))
-                graphicsItemEdgesToDelete.insert(rcGraphicsItemEdge);
-            rcEdge->setGraphicsItemEdge(0);
+            sequences[i] = nodes[nodeCount - 1 - i]->getReverseComplement()->getSequence();
+            if (i > 0)
+                chainOverlaps[i] = overlaps[nodeCount - 1 - i];
+        }
+        else
+        {
+            sequences[i] = nodes[i]->getSequence();
+            if (i > 0)
+                chainOverlaps[i] = overlaps[i - 1];
         }
     }
 
-    if (scene != 0)
-        scene->blockSignals(true);
-    QSetIterator<GraphicsItemEdge *> i(graphicsItemEdgesToDelete);
-    while (i.hasNext())
+    long long length = 0;
+    for (int i = 0; i < nodeCount; ++i)
     {
-        GraphicsItemEdge * graphicsItemEdge = i.next();
-        if (graphicsItemEdge != 0)
+        int overlap = chainOverlaps[i];
+        length += sequences[i].length();
+        if (overlap > 0 && sequences[i].length() >= overlap)
+            length -= overlap;
+        else if (overlap < 0)
+            length -= overlap;
+    }
+
+    QByteArray sequence;
+    sequence.reserve(int(length));
+    for (int i = 0; i < nodeCount; ++i)
+    {
+        const QByteArray & nodeSequence = sequences[i];
+        int overlap = chainOverlaps[i];
+        if (overlap > 0 && nodeSequence.length() >= overlap)
+            sequence.append(nodeSequence.constData() + overlap, nodeSequence.length() - overlap);
+        else
         {
-            if (scene != 0)
-                scene->removeItem(graphicsItemEdge);
-            delete graphicsItemEdge;
+            if (overlap < 0)
+                sequence.append(QByteArray(-overlap, 'N'));
+            sequence.append(nodeSequence);
         }
     }
-    if (scene != 0)
-        scene->blockSignals(false);
+    return sequence;
+}
+
+
+static void buildUnitigSequences(UnitigMerge & merge)
+{
+    merge.posSequence = joinChainSequences(merge.nodes, merge.overlaps, false);
+    merge.negSequence = joinChainSequences(merge.nodes, merge.overlaps, true);
 }
 
 
@@ -3077,211 +3606,570 @@ void AssemblyGraph::removeGraphicsItemEdges(const std::vector<DeBruijnEdge *> *
 //line.  It returns the number of merges that it did.
 //It gets a pointer to the progress dialog as well so it can check to see if the
 //user has cancelled the merge.
+//The chains are found in one pass using edge counts by node ID, the merged
+//sequences are built in parallel, and then the new nodes and edges are added
+//and the old nodes deleted all together.  The scene is only updated at the
+//end.
 int AssemblyGraph::mergeAllPossible(MyGraphicsScene * scene,
                                     MyProgressDialog * progressDialog)
 {
-    //Create a set of all nodes.
-    QSet<DeBruijnNode *> uncheckedNodes;
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
+    //Count each node's entering and leaving edges.  When a node has only one
+    //leaving edge, that edge is kept.
+    int idCount = m_nodeAttributes.size();
+    std::vector<int> leavingCounts(idCount, 0);
+    std::vector<int> enteringCounts(idCount, 0);
+    std::vector<DeBruijnEdge *> leavingEdges(idCount, 0);
+    std::vector<DeBruijnEdge *> enteringEdges(idCount, 0);
+    QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> k(m_deBruijnGraphEdges);
+    while (k.hasNext())
     {
-        i.next();
-        uncheckedNodes.insert(i.value());
+        k.next();
+        DeBruijnEdge * edge = k.value();
+        int startingId = edge->getStartingNode()->getId();
+        int endingId = edge->getEndingNode()->getId();
+        ++leavingCounts[startingId];
+        leavingEdges[startingId] = edge;
+        ++enteringCounts[endingId];
+        enteringEdges[endingId] = edge;
     }
 
-    //Create a list of all merges to be done.
-    QList< QList<DeBruijnNode *> > allMerges;
+    //Find the longest possible mergeable chain containing each node not yet
+    //in a chain.
+    std::vector<char> checked(idCount, false);
+    std::vector<UnitigMerge> merges;
     QMapIterator<QString, DeBruijnNode*> j(m_deBruijnGraphNodes);
     while (j.hasNext())
     {
         j.next();
         DeBruijnNode * node = j.value();
+        if (checked[node->getId()])
+            continue;
+
+        UnitigMerge merge;
+        merge.nodes.push_back(node);
+        merge.newPosNode = 0;
+        checked[node->getId()] = true;
+        checked[node->getReverseComplement()->getId()] = true;
 
-        //If the current node isn't checked, then we will find the longest
-        //possible mergable sequence containing this node.
-        if (uncheckedNodes.contains(node))
+        //Extend forward as much as possible.
+        while (true)
         {
-            QList<DeBruijnNode *> nodesToMerge;
-            nodesToMerge.push_back(node);
+            int lastId = merge.nodes.back()->getId();
+            if (leavingCounts[lastId] != 1)
+                break;
+            DeBruijnEdge * potentialEdge = leavingEdges[lastId];
+            DeBruijnNode * potentialNode = potentialEdge->getEndingNode();
+            int potentialId = potentialNode->getId();
+            if (enteringCounts[potentialId] != 1 || checked[potentialId])
+                break;
+            merge.nodes.push_back(potentialNode);
+            merge.overlaps.push_back(potentialEdge->getOverlap());
+            checked[potentialId] = true;
+            checked[potentialNode->getReverseComplement()->getId()] = true;
+        }
 
-            uncheckedNodes.remove(node);
-            uncheckedNodes.remove(node->getReverseComplement());
+        //Extend backward as much as possible.
+        while (true)
+        {
+            int firstId = merge.nodes.front()->getId();
+            if (enteringCounts[firstId] != 1)
+                break;
+            DeBruijnEdge * potentialEdge = enteringEdges[firstId];
+            DeBruijnNode * potentialNode = potentialEdge->getStartingNode();
+            int potentialId = potentialNode->getId();
+            if (leavingCounts[potentialId] != 1 || checked[potentialId])
+                break;
+            merge.nodes.push_front(potentialNode);
+            merge.overlaps.push_front(potentialEdge->getOverlap());
+            checked[potentialId] = true;
+            checked[potentialNode->getReverseComplement()->getId()] = true;
+        }
 
-            //Extend forward as much as possible.
-            bool extended;
-            do
-            {
-                extended = false;
-                DeBruijnNode * last = nodesToMerge.back();
-                std::vector<DeBruijnEdge *> outgoingEdges = last->getLeavingEdges();
-                if (outgoingEdges.size() == 1)
-                {
-                    DeBruijnEdge * potentialEdge = outgoingEdges[0];
-                    DeBruijnNode * potentialNode = potentialEdge->getEndingNode();
-                    std::vector<DeBruijnEdge *> edgesEnteringPotentialNode = potentialNode->getEnteringEdges();
-                    if (edgesEnteringPotentialNode.size() == 1 &&
-                            edgesEnteringPotentialNode[0] == potentialEdge &&
-                            !nodesToMerge.contains(potentialNode) &&
-                            uncheckedNodes.contains(potentialNode))
-                    {
-                        nodesToMerge.push_back(potentialNode);
-                        uncheckedNodes.remove(potentialNode);
-                        uncheckedNodes.remove(potentialNode->getReverseComplement());
-                        extended = true;
-                    }
-                }
-            } while (extended);
+        if (merge.nodes.size() > 1)
+            merges.push_back(merge);
+    }
+    std::vector<int>().swap(leavingCounts);
+    std::vector<int>().swap(enteringCounts);
+    std::vector<DeBruijnEdge *>().swap(leavingEdges);
+    std::vector<DeBruijnEdge *>().swap(enteringEdges);
+    std::vector<char>().swap(checked);
 
-            //Extend backward as much as possible.
-            do
-            {
-                extended = false;
-                DeBruijnNode * first = nodesToMerge.front();
-                std::vector<DeBruijnEdge *> incomingEdges = first->getEnteringEdges();
-                if (incomingEdges.size() == 1)
-                {
-                    DeBruijnEdge * potentialEdge = incomingEdges[0];
-                    DeBruijnNode * potentialNode = potentialEdge->getStartingNode();
-                    std::vector<DeBruijnEdge *> edgesLeavingPotentialNode = potentialNode->getLeavingEdges();
-                    if (edgesLeavingPotentialNode.size() == 1 &&
-                            edgesLeavingPotentialNode[0] == potentialEdge &&
-                            !nodesToMerge.contains(potentialNode) &&
-                            uncheckedNodes.contains(potentialNode))
-                    {
-                        nodesToMerge.push_front(potentialNode);
-                        uncheckedNodes.remove(potentialNode);
-                        uncheckedNodes.remove(potentialNode->getReverseComplement());
-                        extended = true;
-                    }
-                }
-            } while (extended);
+    int mergeCount = int(merges.size());
+    QApplication::processEvents();
+    emit setMergeTotalCount(mergeCount);
+    if (mergeCount == 0)
+        return 0;
 
-            if (nodesToMerge.size() > 1)
-                allMerges.push_back(nodesToMerge);
+    //Every node in the chains (and its reverse complement) has its sequence
+    //read by the threads, so each one is checked for a missing sequence.
+    std::vector<DeBruijnNode *> chainNodes;
+    for (int i = 0; i < mergeCount; ++i)
+    {
+        for (int n = 0; n < merges[i].nodes.size(); ++n)
+        {
+            chainNodes.push_back(merges[i].nodes[n]);
+            chainNodes.push_back(merges[i].nodes[n]->getReverseComplement());
         }
     }
-
-    //Now do the actual merges.
-    QApplication::processEvents();
-    emit setMergeTotalCount(allMerges.size());
-    for (int i = 0; i < allMerges.size(); ++i)
+    loadSequencesBeforeThreads(chainNodes);
+    std::vector<DeBruijnNode *>().swap(chainNodes);
+    QtConcurrent::blockingMap(merges, buildUnitigSequences);
+
+    //Make the merged nodes.  The original end nodes (and their reverse
+    //complements) are mapped to the new nodes so the new edges can be made
+    //after all of the new nodes exist.
+    QHash<DeBruijnNode *, DeBruijnNode *> replacements;
+    int committedCount = 0;
+    for (int i = 0; i < mergeCount; ++i)
     {
         if (progressDialog != 0 && progressDialog->wasCancelled())
             break;
 
-        mergeNodes(allMerges[i], scene, false);
-        emit setMergeCompletedCount(i+1);
-        QApplication::processEvents();
+        UnitigMerge & merge = merges[i];
+        double mergedNodeDepth = getMeanDepth(merge.nodes);
+
+        QString newNodeBaseName;
+        for (int n = 0; n < merge.nodes.size(); ++n)
+        {
+            newNodeBaseName += merge.nodes[n]->getNameWithoutSign();
+            if (n < merge.nodes.size() - 1)
+                newNodeBaseName += "_";
+        }
+        newNodeBaseName = getUniqueNodeName(newNodeBaseName);
+        QString newPosNodeName = newNodeBaseName + "+";
+        QString newNegNodeName = newNodeBaseName + "-";
+
+        DeBruijnNode * newPosNode = new DeBruijnNode(&m_nodeAttributes, newPosNodeName, mergedNodeDepth, merge.posSequence);
+        DeBruijnNode * newNegNode = new DeBruijnNode(&m_nodeAttributes, newNegNodeName, mergedNodeDepth, merge.negSequence);
+        merge.posSequence = QByteArray();
+        merge.negSequence = QByteArray();
+
+        newPosNode->setReverseComplement(newNegNode);
+        newNegNode->setReverseComplement(newPosNode);
+        newPosNode->setDepthRelativeToMeanDrawnDepth(1.0);
+        newNegNode->setDepthRelativeToMeanDrawnDepth(1.0);
+
+        m_deBruijnGraphNodes.insert(newPosNodeName, newPosNode);
+        m_deBruijnGraphNodes.insert(newNegNodeName, newNegNode);
+        merge.newPosNode = newPosNode;
+
+        replacements[merge.nodes.front()] = newPosNode;
+        replacements[merge.nodes.back()] = newPosNode;
+        replacements[merge.nodes.front()->getReverseComplement()] = newNegNode;
+        replacements[merge.nodes.back()->getReverseComplement()] = newNegNode;
+
+        ++committedCount;
+        if (committedCount % 1000 == 0)
+        {
+            emit setMergeCompletedCount(committedCount);
+            QApplication::processEvents();
+        }
+    }
+
+    //Give the new nodes the edges that entered the start and left the end of
+    //their chains.  An edge between two chains is made from both sides, but
+    //createDeBruijnEdge skips an edge that already exists.
+    for (int i = 0; i < committedCount; ++i)
+    {
+        const UnitigMerge & merge = merges[i];
+        QString newPosNodeName = merge.newPosNode->getName();
+
+        const std::vector<DeBruijnEdge *> * lastNodeEdges = merge.nodes.back()->getEdgesPointer();
+        for (size_t e = 0; e < lastNodeEdges->size(); ++e)
+        {
+            DeBruijnEdge * leavingEdge = (*lastNodeEdges)[e];
+            if (leavingEdge->getStartingNode() != merge.nodes.back())
+                continue;
+            DeBruijnNode * endingNode = replacements.value(leavingEdge->getEndingNode(), leavingEdge->getEndingNode());
+            createDeBruijnEdge(newPosNodeName, endingNode->getName(), leavingEdge->getOverlap(),
+                               leavingEdge->getOverlapType());
+        }
+
+        const std::vector<DeBruijnEdge *> * firstNodeEdges = merge.nodes.front()->getEdgesPointer();
+        for (size_t e = 0; e < firstNodeEdges->size(); ++e)
+        {
+            DeBruijnEdge * enteringEdge = (*firstNodeEdges)[e];
+            if (enteringEdge->getEndingNode() != merge.nodes.front())
+                continue;
+            DeBruijnNode * startingNode = replacements.value(enteringEdge->getStartingNode(), enteringEdge->getStartingNode());
+            createDeBruijnEdge(startingNode->getName(), newPosNodeName, enteringEdge->getOverlap(),
+                               enteringEdge->getOverlapType());
+        }
+    }
+
+    //The GFA paths are moved onto the merged nodes before the original nodes
+    //are deleted.
+    if (m_gfaPaths.getPathCount() > 0)
+    {
+        std::vector<int> mergedIds(m_nodeAttributes.size(), -1);
+        std::vector<int> chainPositions(m_nodeAttributes.size(), -1);
+        for (int i = 0; i < committedCount; ++i)
+            noteMergedChain(merges[i].nodes, merges[i].newPosNode, &mergedIds, &chainPositions);
+        m_gfaPaths.mergeNodeRuns(mergedIds, chainPositions, m_nodeAttributes.size());
     }
 
+    //Update the scene: the merged graphics items are made from the original
+    //ones, the original items are removed and then the new nodes' edges are
+    //drawn.
+    std::vector<DeBruijnNode *> nodesToDelete;
+    for (int i = 0; i < committedCount; ++i)
+        nodesToDelete.insert(nodesToDelete.end(), merges[i].nodes.begin(), merges[i].nodes.end());
+    if (scene != 0)
+    {
+        for (int i = 0; i < committedCount; ++i)
+        {
+            UnitigMerge & merge = merges[i];
+            if (mergeGraphicsNodes2(&merge.nodes, merge.newPosNode, scene))
+                merge.newPosNode->setAsDrawn();
+            if (g_settings->doubleMode)
+            {
+                QList<DeBruijnNode *> revCompNodes;
+                for (int n = 0; n < merge.nodes.size(); ++n)
+                    revCompNodes.push_front(merge.nodes[n]->getReverseComplement());
+                DeBruijnNode * newNegNode = merge.newPosNode->getReverseComplement();
+                if (mergeGraphicsNodes2(&revCompNodes, newNegNode, scene))
+                    newNegNode->setAsDrawn();
+            }
+        }
+        removeGraphicsItems(&nodesToDelete, 0, true, scene);
+        for (int i = 0; i < committedCount; ++i)
+        {
+            addGraphicsItemEdges(merges[i].newPosNode, scene, true);
+            addGraphicsItemEdges(merges[i].newPosNode->getReverseComplement(), scene, true);
+        }
+    }
+
+    deleteNodes(&nodesToDelete);
+    emit setMergeCompletedCount(committedCount);
+
     recalculateAllDepthsRelativeToDrawnMean();
     recalculateAllNodeWidths();
 
-    return allMerges.size();
+    return committedCount;
 }
 
-void AssemblyGraph::saveEntireGraphToFasta(QString filename)
+//The records written to FASTA and GFA files.
+enum RecordFormat {FASTA_RECORD, FASTA_RECORD_WITHOUT_SIGN, GFA_SEGMENT_LINE, GFA_LINK_LINE};
+
+//A run of records for the file writers to format in a separate thread.  A
+//chunk holds either nodes or edges, depending on its format.
+struct RecordChunk
+{
+    RecordFormat format;
+    const std::vector<DeBruijnNode *> * nodes;
+    const std::vector<DeBruijnEdge *> * edges;
+    int begin;
+    int end;
+    QString depthTag;
+    QByteArray text;
+};
+
+static void formatRecordChunk(RecordChunk & chunk)
 {
-    QFile file(filename);
-    file.open(QIODevice::WriteOnly | QIODevice::Text);
-    QTextStream out(&file);
+    for (int i = chunk.begin; i < chunk.end; ++i)
+    {
+        if (chunk.format == FASTA_RECORD)
+            chunk.text += (*chunk.nodes)[i]->getFasta(true);
+        else if (chunk.format == FASTA_RECORD_WITHOUT_SIGN)
+            chunk.text += (*chunk.nodes)[i]->getFasta(false);
+        else if (chunk.format == GFA_SEGMENT_LINE)
+            chunk.text += (*chunk.nodes)[i]->getGfaSegmentLine(chunk.depthTag);
+        else
+            chunk.text += (*chunk.edges)[i]->getGfaLinkLine();
+    }
+}
 
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
+
+//This function formats the nodes (or edges, for GFA links) in chunks of about
+//a megabyte, in parallel, and writes the chunks in order.  Only a few chunks
+//per thread are held at once, so the memory used doesn't grow with the graph.
+static void writeRecords(RecordFileWriter * writer, RecordFormat format,
+                         const std::vector<DeBruijnNode *> & nodes,
+                         const std::vector<DeBruijnEdge *> & edges,
+                         QString depthTag = QString())
+{
+    int recordCount = int(format == GFA_LINK_LINE ? edges.size() : nodes.size());
+
+    std::vector<RecordChunk> chunks;
+    RecordChunk chunk;
+    chunk.format = format;
+    chunk.nodes = &nodes;
+    chunk.edges = &edges;
+    chunk.begin = 0;
+    chunk.depthTag = depthTag;
+    long long chunkBytes = 0;
+    for (int i = 0; i < recordCount; ++i)
     {
-        i.next();
-        out << i.value()->getFasta(true);
+        chunkBytes += (format == GFA_LINK_LINE) ? 32 : nodes[i]->getLength() + 64;
+        if (chunkBytes >= (1 << 20) || i == recordCount - 1)
+        {
+            chunk.end = i + 1;
+            chunks.push_back(chunk);
+            chunk.begin = i + 1;
+            chunkBytes = 0;
+        }
+    }
+
+    size_t batchSize = size_t(4 * std::max(1, QThread::idealThreadCount()));
+    for (size_t i = 0; i < chunks.size(); i += batchSize)
+    {
+        size_t batchEnd = std::min(chunks.size(), i + batchSize);
+        QtConcurrent::blockingMap(chunks.begin() + i, chunks.begin() + batchEnd, formatRecordChunk);
+        for (size_t j = i; j < batchEnd; ++j)
+        {
+            writer->write(chunks[j].text);
+            chunks[j].text = QByteArray();
+        }
     }
 }
 
-void AssemblyGraph::saveEntireGraphToFastaOnlyPositiveNodes(QString filename)
+
+//Saved edges are sorted by their node names, as numbers if the names are
+//numbers.  When every name is a number (the usual case), the numbers are found
+//once for each edge instead of for every comparison.
+static void sortEdgesForSaving(std::vector<DeBruijnEdge *> * edges)
+{
+    std::vector<std::pair<std::pair<long long, long long>, DeBruijnEdge *> > keyedEdges;
+    keyedEdges.reserve(edges->size());
+    for (size_t i = 0; i < edges->size(); ++i)
+    {
+        DeBruijnEdge * edge = (*edges)[i];
+        bool ok1, ok2;
+        long long startNumber = edge->getStartingNode()->getNameWithoutSign().toLongLong(&ok1);
+        long long endNumber = edge->getEndingNode()->getNameWithoutSign().toLongLong(&ok2);
+        if (!ok1 || !ok2)
+        {
+            std::sort(edges->begin(), edges->end(), DeBruijnEdge::compareEdgePointers);
+            return;
+        }
+        keyedEdges.push_back(std::make_pair(std::make_pair(startNumber, endNumber), edge));
+    }
+
+    std::stable_sort(keyedEdges.begin(), keyedEdges.end(),
+                     [](const std::pair<std::pair<long long, long long>, DeBruijnEdge *> & a,
+                        const std::pair<std::pair<long long, long long>, DeBruijnEdge *> & b) {return a.first < b.first;});
+    for (size_t i = 0; i < keyedEdges.size(); ++i)
+        (*edges)[i] = keyedEdges[i].second;
+}
+
+
+//Sequences from a separate FASTA file must be loaded before any threads read
+//the nodes' sequences (e.g. the file writers' threads), as loading them changes
+//the graph.
+void AssemblyGraph::loadSequencesBeforeThreads(const std::vector<DeBruijnNode *> & nodes)
 {
-    QFile file(filename);
-    file.open(QIODevice::WriteOnly | QIODevice::Text);
-    QTextStream out(&file);
+    if (m_sequencesLoadedFromFasta != NOT_TRIED)
+        return;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (nodes[i]->storedSequenceIsMissing())
+        {
+            attemptToLoadSequencesFromFasta();
+            return;
+        }
+    }
+}
+
 
+//The FASTA and GFA files are compressed (BGZF) if their name ends in .gz.
+bool AssemblyGraph::saveGraphToFasta(QString filename, bool positiveNodesOnly)
+{
+    std::vector<DeBruijnNode *> nodes;
     QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
     while (i.hasNext())
     {
         i.next();
-        DeBruijnNode * node = i.value();
-        if (node->isPositiveNode())
-            out << node->getFasta(false);
+        if (!positiveNodesOnly || i.value()->isPositiveNode())
+            nodes.push_back(i.value());
     }
-}
+    loadSequencesBeforeThreads(nodes);
 
-bool AssemblyGraph::saveEntireGraphToGfa(QString filename)
-{
-    QFile file(filename);
-    bool success = file.open(QIODevice::WriteOnly | QIODevice::Text);
-    if (!success)
+    RecordFileWriter writer(filename, RecordFileWriter::isCompressedFilename(filename));
+    if (!writer.open())
         return false;
+    writeRecords(&writer, positiveNodesOnly ? FASTA_RECORD_WITHOUT_SIGN : FASTA_RECORD,
+                 nodes, std::vector<DeBruijnEdge *>());
+    return writer.close();
+}
 
-    QTextStream out(&file);
-
+bool AssemblyGraph::saveGraphToGfa(QString filename, bool visibleOnly)
+{
+    std::vector<DeBruijnNode *> nodes;
     QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
     while (i.hasNext())
     {
         i.next();
         DeBruijnNode * node = i.value();
-        if (node->isPositiveNode())
-            out << node->getGfaSegmentLine(m_depthTag);
+        if (node->isPositiveNode() && (!visibleOnly || node->thisNodeOrReverseComplementIsDrawn()))
+            nodes.push_back(node);
     }
 
-    QList<DeBruijnEdge*> edgesToSave;
+    std::vector<DeBruijnEdge *> edges;
     QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(m_deBruijnGraphEdges);
     while (j.hasNext())
     {
         j.next();
         DeBruijnEdge * edge = j.value();
-        if (edge->isPositiveEdge())
-            edgesToSave.push_back(edge);
+        if (edge->isPositiveEdge() &&
+                (!visibleOnly || (edge->getStartingNode()->thisNodeOrReverseComplementIsDrawn() &&
+                                  edge->getEndingNode()->thisNodeOrReverseComplementIsDrawn())))
+            edges.push_back(edge);
     }
+    sortEdgesForSaving(&edges);
 
-    std::sort(edgesToSave.begin(), edgesToSave.end(), DeBruijnEdge::compareEdgePointers);
+    RecordFileWriter writer(filename, RecordFileWriter::isCompressedFilename(filename));
+    if (!writer.open())
+        return false;
+    writeRecords(&writer, GFA_SEGMENT_LINE, nodes, edges, m_depthTag);
+    writeRecords(&writer, GFA_LINK_LINE, nodes, edges);
+    return writer.close();
+}
 
-    for (int i = 0; i < edgesToSave.size(); ++i)
-        out << edgesToSave[i]->getGfaLinkLine();
+void AssemblyGraph::saveEntireGraphToFasta(QString filename)
+{
+    saveGraphToFasta(filename, false);
+}
 
-    return true;
+void AssemblyGraph::saveEntireGraphToFastaOnlyPositiveNodes(QString filename)
+{
+    saveGraphToFasta(filename, true);
+}
+
+bool AssemblyGraph::saveEntireGraphToGfa(QString filename)
+{
+    return saveGraphToGfa(filename, false);
 }
 
 bool AssemblyGraph::saveVisibleGraphToGfa(QString filename)
 {
-    QFile file(filename);
-    bool success = file.open(QIODevice::WriteOnly | QIODevice::Text);
-    if (!success)
-        return false;
+    return saveGraphToGfa(filename, true);
+}
+
+
+//A GFA path is made into a Path from its nodes.  The Path is empty if
+//consecutive nodes in the GFA path aren't joined by an edge.
+Path AssemblyGraph::makePathFromGfaPath(int gfaPath) const
+{
+    std::vector<DeBruijnNode *> nodes = m_gfaPaths.getPathNodes(gfaPath, m_nodeAttributes);
+    QList<DeBruijnNode *> nodeList;
+    nodeList.reserve(int(nodes.size()));
+    for (size_t i = 0; i < nodes.size(); ++i)
+        nodeList.push_back(nodes[i]);
+    return Path::makeFromOrderedNodes(nodeList, false);
+}
+
+
+//A run of GFA paths which can have their FASTA records made in a separate
+//thread.
+struct GfaPathChunk
+{
+    const AssemblyGraph * graph;
+    int begin;
+    int end;
+    QByteArray text;
+};
 
-    QTextStream out(&file);
+static void formatGfaPathChunk(GfaPathChunk & chunk)
+{
+    for (int i = chunk.begin; i < chunk.end; ++i)
+    {
+        Path path = chunk.graph->makePathFromGfaPath(i);
+        if (path.isEmpty())
+            continue;
+        chunk.text += ">";
+        chunk.text += chunk.graph->m_gfaPaths.getPathName(i).toUtf8();
+        chunk.text += "\n";
+        chunk.text += path.getPathSequence(70);
+    }
+}
 
+
+//This function saves the sequence of each GFA path as a FASTA record named
+//for the path.  Like the graph's FASTA files, the records are made in chunks
+//in parallel and the file is compressed if its name ends in .gz.  Paths
+//which don't follow the graph's edges are left out.
+bool AssemblyGraph::saveGfaPathsToFasta(QString filename)
+{
+    std::vector<DeBruijnNode *> nodes;
     QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
     while (i.hasNext())
     {
         i.next();
-        DeBruijnNode * node = i.value();
-        if (node->thisNodeOrReverseComplementIsDrawn() && node->isPositiveNode())
-            out << node->getGfaSegmentLine(m_depthTag);
+        nodes.push_back(i.value());
     }
+    loadSequencesBeforeThreads(nodes);
 
-    QList<DeBruijnEdge*> edgesToSave;
-    QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> j(m_deBruijnGraphEdges);
-    while (j.hasNext())
+    RecordFileWriter writer(filename, RecordFileWriter::isCompressedFilename(filename));
+    if (!writer.open())
+        return false;
+
+    std::vector<GfaPathChunk> chunks;
+    GfaPathChunk chunk;
+    chunk.graph = this;
+    chunk.begin = 0;
+    long long chunkBytes = 0;
+    int pathCount = m_gfaPaths.getPathCount();
+    for (int j = 0; j < pathCount; ++j)
     {
-        j.next();
-        DeBruijnEdge * edge = j.value();
-        if (edge->getStartingNode()->thisNodeOrReverseComplementIsDrawn() &&
-                edge->getEndingNode()->thisNodeOrReverseComplementIsDrawn() &&
-                edge->isPositiveEdge())
-            edgesToSave.push_back(edge);
+        const int * steps = m_gfaPaths.getSteps(j);
+        int stepCount = m_gfaPaths.getStepCount(j);
+        for (int k = 0; k < stepCount; ++k)
+            chunkBytes += m_nodeAttributes.m_lengths[steps[k]];
+        if (chunkBytes >= (1 << 20) || j == pathCount - 1)
+        {
+            chunk.end = j + 1;
+            chunks.push_back(chunk);
+            chunk.begin = j + 1;
+            chunkBytes = 0;
+        }
     }
 
-    std::sort(edgesToSave.begin(), edgesToSave.end(), DeBruijnEdge::compareEdgePointers);
+    size_t batchSize = size_t(4 * std::max(1, QThread::idealThreadCount()));
+    for (size_t j = 0; j < chunks.size(); j += batchSize)
+    {
+        size_t batchEnd = std::min(chunks.size(), j + batchSize);
+        QtConcurrent::blockingMap(chunks.begin() + j, chunks.begin() + batchEnd, formatGfaPathChunk);
+        for (size_t k = j; k < batchEnd; ++k)
+        {
+            writer.write(chunks[k].text);
+            chunks[k].text = QByteArray();
+        }
+    }
+    return writer.close();
+}
 
-    for (int i = 0; i < edgesToSave.size(); ++i)
-        out << edgesToSave[i]->getGfaLinkLine();
 
-    return true;
+//Each of the given GFA paths is given its own hue, spread around the colour
+//wheel, and the nodes it passes through get that hue as their custom colour
+//(using the random colour scheme's saturation and lightness for each strand).
+//A node on more than one of the paths takes the colour of the first.  Nodes
+//on none of the paths keep their custom colours.
+void AssemblyGraph::colourNodesByGfaPaths(const std::vector<int> & gfaPaths)
+{
+    std::vector<char> coloured(m_nodeAttributes.size(), false);
+    for (size_t i = 0; i < gfaPaths.size(); ++i)
+    {
+        int hue = int(360 * i / gfaPaths.size());
+        QColor posColour, negColour;
+        posColour.setHsl(hue, g_settings->randomColourPositiveSaturation,
+                         g_settings->randomColourPositiveLightness);
+        negColour.setHsl(hue, g_settings->randomColourNegativeSaturation,
+                         g_settings->randomColourNegativeLightness);
+
+        const int * steps = m_gfaPaths.getSteps(gfaPaths[i]);
+        int stepCount = m_gfaPaths.getStepCount(gfaPaths[i]);
+        for (int j = 0; j < stepCount; ++j)
+        {
+            if (coloured[steps[j]])
+                continue;
+            DeBruijnNode * node = m_nodeAttributes.m_nodes[steps[j]];
+            DeBruijnNode * revCompNode = node->getReverseComplement();
+            coloured[node->getId()] = true;
+            coloured[revCompNode->getId()] = true;
+            node->setCustomColour(node->isPositiveNode() ? posColour : negColour);
+            revCompNode->setCustomColour(revCompNode->isPositiveNode() ? posColour : negColour);
+        }
+    }
 }
 
 
@@ -3347,6 +4235,8 @@ NodeNameStatus AssemblyGraph::checkNodeNameValidity(QString nodeName)
 void AssemblyGraph::changeNodeDepth(std::vector<DeBruijnNode *> * nodes,
                                         double newDepth)
 {
+    invalidateComponents();
+
     if (nodes->size() == 0)
         return;
 
@@ -3372,17 +4262,18 @@ QByteArray AssemblyGraph::addNewlinesToSequence(QByteArray sequence,
                                                 int interval)
 {
     QByteArray output;
+    output.reserve(sequence.length() + sequence.length() / interval + 1);
 
     int charactersRemaining = sequence.length();
     int currentIndex = 0;
     while (charactersRemaining > interval)
     {
-        output += sequence.mid(currentIndex, interval);
+        output.append(sequence.constData() + currentIndex, interval);
         output += "\n";
         charactersRemaining -= interval;
         currentIndex += interval;
     }
-    output += sequence.mid(currentIndex);
+    output.append(sequence.constData() + currentIndex, charactersRemaining);
     output += "\n";
 
     return output;
@@ -3419,13 +4310,11 @@ void AssemblyGraph::getNodeStats(int * n50, int * shortestNode, int * firstQuart
         return;
 
     std::vector<int> nodeLengths;
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
+    nodeLengths.reserve(m_nodeAttributes.size() / 2);
+    for (int i = 0; i < m_nodeAttributes.size(); ++i)
     {
-        i.next();
-        DeBruijnNode * node = i.value();
-        if (node->isPositiveNode())
-            nodeLengths.push_back(node->getLength());
+        if (m_nodeAttributes.m_positive[i])
+            nodeLengths.push_back(m_nodeAttributes.m_lengths[i]);
     }
 
     if (nodeLengths.size() == 0)
@@ -3459,130 +4348,84 @@ void AssemblyGraph::getNodeStats(int * n50, int * shortestNode, int * firstQuart
 
 
 
-//This function uses an algorithm adapted from: http://math.hws.edu/eck/cs327_s04/chapter9.pdf
 void AssemblyGraph::getGraphComponentCountAndLargestComponentSize(int * componentCount, int * largestComponentLength) const
 {
-    *componentCount = 0;
+    const GraphComponents * components = getComponents();
+    *componentCount = components->getComponentCount();
     *largestComponentLength = 0;
 
-    QSet<DeBruijnNode *> visitedNodes;
-    QList< QList<DeBruijnNode *> > connectedComponents;
-    
-    //Loop through all positive nodes.
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
-    {
-        i.next();
-        DeBruijnNode * v = i.value();
-        if (v->isNegativeNode())
-            continue;
-        
-        //If the node has not yet been visited, then it must be the start of a new connected component.
-        if (!visitedNodes.contains(v))
-        {
-            QList<DeBruijnNode *> connectedComponent;
-            
-            QQueue<DeBruijnNode *> q;
-            q.enqueue(v);
-            visitedNodes.insert(v);
-
-            while (!q.isEmpty())
-            {
-                DeBruijnNode * w = q.dequeue();
-                connectedComponent.push_back(w);
-
-                std::vector<DeBruijnNode *> connectedNodes = w->getAllConnectedPositiveNodes();
-                for (size_t j = 0; j < connectedNodes.size(); ++j)
-                {
-                    DeBruijnNode * k = connectedNodes[j];
-                    if (!visitedNodes.contains(k))
-                    {
-                        visitedNodes.insert(k);
-                        q.enqueue(k);
-                    }
-                }
-            }
-
-            connectedComponents.push_back(connectedComponent);
-        }  
-    }
-    
-    //Now that the list of connected components is built, we look for the
-    //largest one (as measured by total node length).
-    *componentCount = connectedComponents.size();
-    for (int i = 0; i < *componentCount; ++i)
-    {
-        int componentLength = 0;
-        for (int j = 0; j < connectedComponents[i].size(); ++j)
-            componentLength += connectedComponents[i][j]->getLength();
-
-        if (componentLength > *largestComponentLength)
-            *largestComponentLength = componentLength;
-    }
+    int largestComponentId = components->getLargestComponentId();
+    if (largestComponentId >= 0)
+        *largestComponentLength = components->getComponent(largestComponentId).totalLength;
 }
 
-bool compareNodeDepth(DeBruijnNode * a, DeBruijnNode * b) {return (a->getDepth() < b->getDepth());}
-
 
+//The connected components are found when first needed and kept until the
+//graph changes.
+const GraphComponents * AssemblyGraph::getComponents() const
+{
+    if (!m_components.isBuilt())
+        m_components.build(&m_nodeAttributes, true);
+    return &m_components;
+}
 
 double AssemblyGraph::getMedianDepthByBase() const
 {
     if (m_totalLength == 0)
         return 0.0;
 
-    //Make a list of all nodes.
+    //Make a list of the depth and length of all positive nodes.
     long long totalLength = 0;
-    QList<DeBruijnNode *> nodeList;
-    QMapIterator<QString, DeBruijnNode*> i(m_deBruijnGraphNodes);
-    while (i.hasNext())
+    std::vector<QPair<double, int> > depthsAndLengths;
+    depthsAndLengths.reserve(m_nodeAttributes.size() / 2);
+    for (int i = 0; i < m_nodeAttributes.size(); ++i)
     {
-        i.next();
-        DeBruijnNode * node = i.value();
-        if (node->isPositiveNode())
+        if (m_nodeAttributes.m_positive[i])
         {
-            nodeList.push_back(node);
-            totalLength += node->getLength();
+            int length = m_nodeAttributes.m_lengths[i];
+            depthsAndLengths.push_back(QPair<double, int>(m_nodeAttributes.m_depths[i], length));
+            totalLength += length;
         }
     }
 
     //If there is only one node, then its depth is the median.
-    if (nodeList.size() == 1)
-        return nodeList[0]->getDepth();
+    if (depthsAndLengths.size() == 1)
+        return depthsAndLengths[0].first;
 
-    //Sort the node list from low to high depth.
-    std::sort(nodeList.begin(), nodeList.end(), compareNodeDepth);
+    //Sort the list from low to high depth.
+    std::sort(depthsAndLengths.begin(), depthsAndLengths.end());
 
     if (totalLength % 2 == 0) //Even total length
     {
         long long medianIndex2 = totalLength / 2;
         long long medianIndex1 = medianIndex2 - 1;
-        double depth1 = findDepthAtIndex(&nodeList, medianIndex1);
-        double depth2 = findDepthAtIndex(&nodeList, medianIndex2);
+        double depth1 = findDepthAtIndex(&depthsAndLengths, medianIndex1);
+        double depth2 = findDepthAtIndex(&depthsAndLengths, medianIndex2);
         return (depth1 + depth2) / 2.0;
     }
     else //Odd total length
     {
         long long medianIndex = (totalLength - 1) / 2;
-        return findDepthAtIndex(&nodeList, medianIndex);
+        return findDepthAtIndex(&depthsAndLengths, medianIndex);
     }
 }
 
 
 
-//This function takes a node list sorted by depth and a target index (in terms of
-//the whole sequence length).  It returns the depth at that index.
-double AssemblyGraph::findDepthAtIndex(QList<DeBruijnNode *> * nodeList, long long targetIndex) const
+//This function takes a list of depths and lengths sorted by depth and a target
+//index (in terms of the whole sequence length).  It returns the depth at that
+//index.
+double AssemblyGraph::findDepthAtIndex(std::vector<QPair<double, int> > * depthsAndLengths,
+                                       long long targetIndex) const
 {
     long long lengthSoFar = 0;
-    for (int i = 0; i < nodeList->size(); ++i)
+    for (size_t i = 0; i < depthsAndLengths->size(); ++i)
     {
-        DeBruijnNode * node = (*nodeList)[i];
-
-        lengthSoFar += node->getLength();
+        lengthSoFar += (*depthsAndLengths)[i].second;
         long long currentIndex = lengthSoFar - 1;
 
         if (currentIndex >= targetIndex)
-            return node->getDepth();
+            return (*depthsAndLengths)[i].first;
     }
     return 0.0;
 }
@@ -3672,10 +4515,24 @@ QPair<int, int> AssemblyGraph::getOverlapRange() const
 
 
 
+//This function gives the node name (without a sign) for a FASTA record,
+//using only the first word of its header.  Canu names are simplified in the
+//same way as the GFA's segment names, which have a sign added first.
+static QString getNodeNameFromFastaName(QString fastaName)
+{
+    QString name = fastaName.split(QRegExp("\\s+"), QString::SkipEmptyParts).value(0);
+    name = AssemblyGraph::simplifyCanuNodeName(name + "+");
+    name.chop(1);
+    return name;
+}
+
+
 //This function will look to see if there is a FASTA file (.fa or .fasta) with
 //the same base name as the graph. If so, it will load it and give its
 //sequences to the graph nodes with matching names. This is useful for GFA
 //files which have no sequences (just '*') like ABySS makes.
+//If the FASTA file is uncompressed, it is indexed and the nodes are only
+//given their FASTA records - the sequences are read later when needed.
 //Returns true if any sequences were loaded (doesn't have to be all sequences
 //in the graph).
 bool AssemblyGraph::attemptToLoadSequencesFromFasta()
@@ -3685,33 +4542,54 @@ bool AssemblyGraph::attemptToLoadSequencesFromFasta()
 
     m_sequencesLoadedFromFasta = TRIED;
 
-    QFileInfo gfaFileInfo(m_filename);
+    //The FASTA file may be compressed, as may the graph file.
+    QFileInfo gfaFileInfo(CompressedFile::removeCompressionExtension(m_filename));
     QString baseName = gfaFileInfo.completeBaseName();
-    QString fastaName = gfaFileInfo.dir().filePath(baseName + ".fa");
-    QFileInfo fastaFileInfo(fastaName);
-    if (!fastaFileInfo.exists())
-    {
-        fastaName = gfaFileInfo.dir().filePath(baseName + ".fasta");
-        fastaFileInfo = QFileInfo(fastaName);
-    }
-    if (!fastaFileInfo.exists())
+    QStringList fastaExtensions;
+    fastaExtensions << ".fa" << ".fasta" << ".contigs.fasta"
+                    << ".fa.gz" << ".fasta.gz" << ".contigs.fasta.gz";
+    QString fastaName;
+    for (int i = 0; i < fastaExtensions.size() && fastaName == ""; ++i)
     {
-        fastaName = gfaFileInfo.dir().filePath(baseName + ".contigs.fasta");
-        fastaFileInfo = QFileInfo(fastaName);
+        QString possibleFastaName = gfaFileInfo.dir().filePath(baseName + fastaExtensions[i]);
+        if (QFileInfo(possibleFastaName).exists())
+            fastaName = possibleFastaName;
     }
-    if (!fastaFileInfo.exists())
+    if (fastaName == "")
         return false;
 
     bool atLeastOneNodeSequenceLoaded = false;
+    if (CompressedFile::getCompressionFromFile(fastaName) == NO_COMPRESSION)
+    {
+        QSharedPointer<FastaIndex> sequenceIndex(new FastaIndex(fastaName));
+        if (sequenceIndex->load())
+        {
+            for (int i = 0; i < sequenceIndex->getRecordCount(); ++i)
+            {
+                QString name = getNodeNameFromFastaName(sequenceIndex->getRecord(i).name);
+                if (m_deBruijnGraphNodes.contains(name + "+"))
+                {
+                    DeBruijnNode * posNode = m_deBruijnGraphNodes[name + "+"];
+                    if (posNode->sequenceIsMissing())
+                    {
+                        atLeastOneNodeSequenceLoaded = true;
+                        m_indexedSequences.insert(posNode, i);
+                        m_indexedSequences.insert(m_deBruijnGraphNodes[name + "-"], i);
+                    }
+                }
+            }
+            m_sequenceIndex = sequenceIndex;
+            return atLeastOneNodeSequenceLoaded;
+        }
+    }
+
     std::vector<QString> names;
     std::vector<QByteArray> sequences;
     readFastaFile(fastaName, &names, &sequences);
 
     for (size_t i = 0; i < names.size(); ++i)
     {
-        QString name = names[i];
-        name = simplifyCanuNodeName(name);
-        name = name.split(QRegExp("\\s+"))[0];
+        QString name = getNodeNameFromFastaName(names[i]);
         if (m_deBruijnGraphNodes.contains(name + "+"))
         {
             DeBruijnNode * posNode = m_deBruijnGraphNodes[name + "+"];
@@ -3728,6 +4606,22 @@ bool AssemblyGraph::attemptToLoadSequencesFromFasta()
     return atLeastOneNodeSequenceLoaded;
 }
 
+//This function reads a node's sequence from the indexed FASTA file.  Negative
+//nodes get the reverse complement of their FASTA record.  It returns a null
+//QByteArray if the node has no indexed sequence.
+QByteArray AssemblyGraph::getIndexedSequence(const DeBruijnNode * node) const
+{
+    QHash<const DeBruijnNode *, int>::const_iterator i = m_indexedSequences.find(node);
+    if (i == m_indexedSequences.end() || m_sequenceIndex.isNull())
+        return QByteArray();
+
+    QByteArray sequence = m_sequenceIndex->getSequence(i.value());
+    if (sequence.isNull() || node->isPositiveNode())
+        return sequence;
+    return getReverseComplement(sequence);
+}
+
+
 // Returns true if every node name in the graph starts with the string.
 bool AssemblyGraph::allNodesStartWith(QString start) const
 {
@@ -3743,7 +4637,7 @@ bool AssemblyGraph::allNodesStartWith(QString start) const
 }
 
 
-QString AssemblyGraph::simplifyCanuNodeName(QString oldName) const
+QString AssemblyGraph::simplifyCanuNodeName(QString oldName)
 {
     QString newName;
 
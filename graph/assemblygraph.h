@@ -29,11 +29,23 @@
 #include "../program/globals.h"
 #include "../ui/mygraphicsscene.h"
 #include "path.h"
+#include "csvtable.h"
+#include "nodeattributes.h"
+#include "graphcomponents.h"
+#include "gfapathstore.h"
+#include "nodenameindex.h"
+#include "radixheap.h"
 #include <QPair>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
 
 class DeBruijnNode;
 class DeBruijnEdge;
+class GraphicsItemNode;
+class GraphicsItemEdge;
 class MyProgressDialog;
+class FastaIndex;
 
 class AssemblyGraph : public QObject
 {
@@ -43,6 +55,10 @@ public:
     AssemblyGraph();
     ~AssemblyGraph();
 
+    //The attributes used in whole-graph passes are stored by node ID.  This
+    //must be declared before the nodes, which refer to it.
+    NodeAttributes m_nodeAttributes;
+
     //Nodes are stored in a map with a key of the node's name.
     QMap<QString, DeBruijnNode*> m_deBruijnGraphNodes;
 
@@ -69,6 +85,8 @@ public:
     QString m_filename;
     QString m_depthTag;
     SequencesLoadedFromFasta m_sequencesLoadedFromFasta;
+    CsvTable m_csvData;
+    GfaPathStore m_gfaPaths;
 
     void cleanUp();
     void createDeBruijnEdge(QString node1Name, QString node2Name,
@@ -105,11 +123,22 @@ public:
     bool checkFirstLineOfFile(QString fullFileName, QString regExp);
 
     bool loadGraphFromFile(QString filename);
+    void labelDrawnNodesAndEdges(std::vector<DeBruijnNode *> startingNodes,
+                                 int nodeDistance);
     void buildOgdfGraphFromNodesAndEdges(std::vector<DeBruijnNode *> startingNodes,
                                          int nodeDistance);
+    void labelNeighbouringNodesAsDrawn(const std::vector<DeBruijnNode *> & startingNodes,
+                                       int nodeDistance);
+    void labelNodesWithinBasesAsDrawn(const std::vector<DeBruijnNode *> & startingNodes,
+                                      int baseDistance);
     void addGraphicsItemsToScene(MyGraphicsScene * scene);
 
-    QStringList splitCsv(QString line, QString sep=",");
+    static int splitCsv(const QByteArray & line, char sep, std::vector<QByteArray> * fields);
+    static int getLengthFromCigar(QString cigar);
+    static int getCigarCount(QString cigarCode, QString cigar);
+    static QString simplifyCanuNodeName(QString oldName);
+    static QByteArray removeLineEnding(QByteArray line);
+    static QString getOppositeNodeName(QString nodeName);
     bool loadCSV(QString filename, QStringList * columns, QString * errormsg, bool * coloursLoaded);
     std::vector<DeBruijnNode *> getStartingNodes(QString * errorTitle,
                                                  QString * errorMessage,
@@ -128,12 +157,14 @@ public:
     void setAllEdgesExactOverlap(int overlap);
     void autoDetermineAllEdgesExactOverlap();
 
-    static void readFastaFile(QString filename, std::vector<QString> * names,
+    static bool readFastaFile(QString filename, std::vector<QString> * names,
                               std::vector<QByteArray> * sequences);
 
     int getDrawnNodeCount() const;
-    void deleteNodes(std::vector<DeBruijnNode *> * nodes);
+    int deleteNodes(std::vector<DeBruijnNode *> * nodes);
     void deleteEdges(std::vector<DeBruijnEdge *> * edges);
+    int deleteNodesAndEdges(std::vector<DeBruijnNode *> * nodes,
+                            std::vector<DeBruijnEdge *> * edges);
     void duplicateNodePair(DeBruijnNode * node, MyGraphicsScene * scene);
     bool mergeNodes(QList<DeBruijnNode *> nodes, MyGraphicsScene * scene,
                     bool recalulateDepth);
@@ -143,6 +174,10 @@ public:
     void removeGraphicsItemNodes(const std::vector<DeBruijnNode *> * nodes,
                                  bool reverseComplement,
                                  MyGraphicsScene * scene);
+    void removeGraphicsItems(const std::vector<DeBruijnNode *> * nodes,
+                             const std::vector<DeBruijnEdge *> * edges,
+                             bool reverseComplement,
+                             MyGraphicsScene * scene);
     int mergeAllPossible(MyGraphicsScene * scene = 0,
                          MyProgressDialog * progressDialog = 0);
 
@@ -150,6 +185,9 @@ public:
     void saveEntireGraphToFastaOnlyPositiveNodes(QString filename);
     bool saveEntireGraphToGfa(QString filename);
     bool saveVisibleGraphToGfa(QString filename);
+    bool saveGfaPathsToFasta(QString filename);
+    Path makePathFromGfaPath(int gfaPath) const;
+    void colourNodesByGfaPaths(const std::vector<int> & gfaPaths);
     void changeNodeName(QString oldName, QString newName);
     NodeNameStatus checkNodeNameValidity(QString nodeName);
     void changeNodeDepth(std::vector<DeBruijnNode *> * nodes,
@@ -159,17 +197,45 @@ public:
     int getDeadEndCount() const;
     void getNodeStats(int * n50, int * shortestNode, int * firstQuartile, int * median, int * thirdQuartile, int * longestNode) const;
     void getGraphComponentCountAndLargestComponentSize(int * componentCount, int * largestComponentLength) const;
+    const GraphComponents * getComponents() const;
+    void invalidateComponents() {m_components.clear();}
     double getMedianDepthByBase() const;
     long long getEstimatedSequenceLength() const;
     long long getEstimatedSequenceLength(double medianDepthByBase) const;
     long long getTotalLengthMinusEdgeOverlaps() const;
     QPair<int, int> getOverlapRange() const;
     bool attemptToLoadSequencesFromFasta();
+    bool hasIndexedSequence(const DeBruijnNode * node) const {return m_indexedSequences.contains(node);}
+    QByteArray getIndexedSequence(const DeBruijnNode * node) const;
     long long getTotalLengthOrphanedNodes() const;
     bool useLinearLayout() const;
 
 
 private:
+    //Node sequences from a separate FASTA file are read when needed using
+    //this index.  The hash gives the FASTA record for each node.
+    QSharedPointer<FastaIndex> m_sequenceIndex;
+    QHash<const DeBruijnNode *, int> m_indexedSequences;
+
+    //The connected components, which are built when needed.  Anything which
+    //changes the graph's nodes, edges or depths must invalidate them.
+    mutable GraphComponents m_components;
+
+    //The distance of each node (by ID) from the starting nodes in a
+    //neighbour search, or -1 for nodes the search hasn't reached.  Each search
+    //puts back the -1 values it changed, so a search only costs as much as the
+    //part of the graph it explores.
+    std::vector<int> m_neighbourSearchDistances;
+    RadixHeap m_neighbourSearchHeap;
+
+    //Partial node name searches use this index, which is rebuilt by the
+    //first search after the graph's nodes change.
+    NodeNameIndex m_nodeNameIndex;
+
+    void prepareNeighbourSearch();
+    void finishNeighbourSearch(const std::vector<DeBruijnNode *> & visitedNodes);
+    static void labelNodeAsDrawn(DeBruijnNode * node);
+
     template<typename T> double getValueUsingFractionalIndex(std::vector<T> * v, double index) const;
     QString convertNormalNumberStringToBandageNodeName(QString number);
     void makeReverseComplementNodeIfNecessary(DeBruijnNode * node);
@@ -182,9 +248,6 @@ private:
     std::vector<int> makeOverlapCountVector();
     bool cigarContainsOnlyM(QString cigar);
     int getLengthFromSimpleCigar(QString cigar);
-    int getLengthFromCigar(QString cigar);
-    int getCigarCount(QString cigarCode, QString cigar);
-    QString getOppositeNodeName(QString nodeName);
     void clearAllCsvData();
     QString getNodeNameFromString(QString string);
     QString getNewNodeName(QString oldNodeName);
@@ -199,13 +262,21 @@ private:
                             DeBruijnNode * newNode, MyGraphicsScene * scene);
     bool mergeGraphicsNodes2(QList<DeBruijnNode *> * originalNodes,
                              DeBruijnNode * newNode, MyGraphicsScene * scene);
-    void removeAllGraphicsEdgesFromNode(DeBruijnNode * node,
-                                        bool reverseComplement,
-                                        MyGraphicsScene * scene);
+    void addGraphicsItemEdges(DeBruijnNode * node, MyGraphicsScene * scene,
+                              bool onlyMissing = false);
+    void collectGraphicsItemNode(DeBruijnNode * node,
+                                 QSet<GraphicsItemNode *> * graphicsItemNodes,
+                                 QSet<GraphicsItemEdge *> * graphicsItemEdges,
+                                 bool reverseComplement);
+    void collectGraphicsItemEdge(DeBruijnEdge * edge,
+                                 QSet<GraphicsItemEdge *> * graphicsItemEdges,
+                                 bool reverseComplement);
     QString cleanNodeName(QString name);
-    double findDepthAtIndex(QList<DeBruijnNode *> * nodeList, long long targetIndex) const;
+    double findDepthAtIndex(std::vector<QPair<double, int> > * depthsAndLengths, long long targetIndex) const;
     bool allNodesStartWith(QString start) const;
-    QString simplifyCanuNodeName(QString oldName) const;
+    bool saveGraphToFasta(QString filename, bool positiveNodesOnly);
+    bool saveGraphToGfa(QString filename, bool visibleOnly);
+    void loadSequencesBeforeThreads(const std::vector<DeBruijnNode *> & nodes);
 
 signals:
     void setMergeTotalCount(int totalCount);
@@ -0,0 +1,161 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "csvtable.h"
+#include <QtGlobal>
+#include <limits>
+
+void CsvTable::clear()
+{
+    m_columnNames.clear();
+    m_columns.clear();
+    m_rowCount = 0;
+}
+
+
+void CsvTable::setColumnNames(QStringList columnNames)
+{
+    clear();
+    m_columnNames = columnNames;
+    m_columns.resize(columnNames.size());
+    for (size_t i = 0; i < m_columns.size(); ++i)
+        m_columns[i].numeric = true;
+}
+
+
+//This function adds a row to the table and returns its index.  Values past the
+//number of columns are ignored and missing values are left empty.
+int CsvTable::addRow(const QByteArray * values, int valueCount)
+{
+    for (size_t i = 0; i < m_columns.size(); ++i)
+    {
+        CsvColumn * column = &m_columns[i];
+        if (int(i) < valueCount)
+            addValue(column, values[i]);
+        else if (column->numeric)
+            column->numbers.push_back(std::numeric_limits<double>::quiet_NaN());
+        else
+            column->codes.push_back(-1);
+    }
+    return m_rowCount++;
+}
+
+
+void CsvTable::addValue(CsvColumn * column, const QByteArray & value)
+{
+    if (column->numeric)
+    {
+        double number;
+        if (value.isEmpty())
+        {
+            column->numbers.push_back(std::numeric_limits<double>::quiet_NaN());
+            return;
+        }
+        if (getNumberFromValue(value, &number))
+        {
+            column->numbers.push_back(number);
+            return;
+        }
+        convertToDictionary(column);
+    }
+    addToDictionary(column, value);
+}
+
+
+void CsvTable::addToDictionary(CsvColumn * column, const QByteArray & value)
+{
+    QHash<QByteArray, int>::const_iterator i = column->dictionaryCodes.find(value);
+    if (i != column->dictionaryCodes.end())
+    {
+        column->codes.push_back(i.value());
+        return;
+    }
+    int code = column->dictionary.size();
+    column->dictionary.push_back(QString::fromUtf8(value));
+    column->dictionaryCodes.insert(value, code);
+    column->codes.push_back(code);
+}
+
+
+//This function changes a numeric column to a dictionary-encoded one.  The
+//numbers can be turned back into their original text because they were only
+//stored as numbers if that was possible.
+void CsvTable::convertToDictionary(CsvColumn * column)
+{
+    column->numeric = false;
+    column->codes.reserve(column->numbers.size());
+    for (size_t i = 0; i < column->numbers.size(); ++i)
+    {
+        double number = column->numbers[i];
+        if (qIsNaN(number))
+            column->codes.push_back(-1);
+        else
+            addToDictionary(column, QByteArray::number(number, 'g', 15));
+    }
+    std::vector<double>().swap(column->numbers);
+}
+
+
+//A value is only treated as a number if the number gives back exactly the
+//same text, so the CSV's values are always displayed as they were written.
+bool CsvTable::getNumberFromValue(const QByteArray & value, double * number)
+{
+    bool ok;
+    *number = value.toDouble(&ok);
+    return ok && qIsFinite(*number) && QByteArray::number(*number, 'g', 15) == value;
+}
+
+
+QString CsvTable::getValue(int row, int column) const
+{
+    if (row < 0 || row >= m_rowCount || column < 0 || column >= getColumnCount())
+        return "";
+
+    const CsvColumn & csvColumn = m_columns[column];
+    if (csvColumn.numeric)
+    {
+        double number = csvColumn.numbers[row];
+        if (qIsNaN(number))
+            return "";
+        return QString::number(number, 'g', 15);
+    }
+
+    int code = csvColumn.codes[row];
+    if (code < 0)
+        return "";
+    return csvColumn.dictionary[code];
+}
+
+
+//This function returns the value as a number, or NaN if it is not one.
+double CsvTable::getNumber(int row, int column) const
+{
+    if (row < 0 || row >= m_rowCount || column < 0 || column >= getColumnCount())
+        return std::numeric_limits<double>::quiet_NaN();
+
+    const CsvColumn & csvColumn = m_columns[column];
+    if (csvColumn.numeric)
+        return csvColumn.numbers[row];
+
+    bool ok;
+    double number = getValue(row, column).toDouble(&ok);
+    if (ok)
+        return number;
+    return std::numeric_limits<double>::quiet_NaN();
+}
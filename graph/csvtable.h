@@ -0,0 +1,73 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef CSVTABLE_H
+#define CSVTABLE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <vector>
+
+//This class holds the data loaded from a CSV file, stored by column instead
+//of as a list of strings for each node.  A column is numeric as long as every
+//value in it is a number which can be turned back into the same text.  Once
+//a column has any other value, it is changed to a dictionary-encoded column:
+//a list of the distinct strings and an index into that list for each row.
+//This suits columns of categories (e.g. taxonomy or bin) which have many
+//repeated values.  Nodes refer to their row in the table.
+
+struct CsvColumn
+{
+    bool numeric;
+    std::vector<double> numbers;
+    std::vector<int> codes;
+    QStringList dictionary;
+    QHash<QByteArray, int> dictionaryCodes;
+};
+
+class CsvTable
+{
+public:
+    CsvTable() : m_rowCount(0) {}
+
+    void clear();
+    void setColumnNames(QStringList columnNames);
+    int addRow(const QByteArray * values, int valueCount);
+
+    int getRowCount() const {return m_rowCount;}
+    int getColumnCount() const {return m_columnNames.size();}
+    QStringList getColumnNames() const {return m_columnNames;}
+    bool isNumericColumn(int column) const {return m_columns[column].numeric;}
+    QString getValue(int row, int column) const;
+    double getNumber(int row, int column) const;
+
+private:
+    QStringList m_columnNames;
+    std::vector<CsvColumn> m_columns;
+    int m_rowCount;
+
+    static void addValue(CsvColumn * column, const QByteArray & value);
+    static void addToDictionary(CsvColumn * column, const QByteArray & value);
+    static void convertToDictionary(CsvColumn * column);
+    static bool getNumberFromValue(const QByteArray & value, double * number);
+};
+
+#endif // CSVTABLE_H
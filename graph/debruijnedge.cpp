@@ -18,6 +18,7 @@
 
 #include "debruijnedge.h"
 #include <math.h>
+#include <algorithm>
 #include "../program/settings.h"
 #include "ogdfnode.h"
 #include <QApplication>
@@ -169,7 +170,7 @@ void DeBruijnEdge::tracePaths(bool forward,
 
     //If the code got here, then more steps remain.
     //Find the edges that are in the correct direction.
-    std::vector<DeBruijnEdge *> nextEdges = findNextEdgesInPath(nextNode, forward);
+    DeBruijnEdgeRange nextEdges = findNextEdgesInPath(nextNode, forward);
 
     //If there are no next edges, then we are finished with the
     //path search, even though steps remain.
@@ -267,7 +268,7 @@ bool DeBruijnEdge::leadsOnlyToNode(bool forward,
 
     //If the code got here, then more steps remain.
     //Find the edges that are in the correct direction.
-    std::vector<DeBruijnEdge *> nextEdges = findNextEdgesInPath(nextNode, forward);
+    DeBruijnEdgeRange nextEdges = findNextEdgesInPath(nextNode, forward);
 
     //If there are no next edges, then the search failed, even
     //though steps remain.
@@ -304,24 +305,18 @@ bool DeBruijnEdge::leadsOnlyToNode(bool forward,
 }
 
 
-std::vector<DeBruijnEdge *> DeBruijnEdge::findNextEdgesInPath(DeBruijnNode * nextNode,
-                                                              bool forward) const
+//The edges are returned as a range over nextNode's edges, not a copy.  The
+//path searches which use this don't change any edges.
+DeBruijnEdgeRange DeBruijnEdge::findNextEdgesInPath(DeBruijnNode * nextNode,
+                                                    bool forward) const
 {
-    std::vector<DeBruijnEdge *> nextEdges;
-    const std::vector<DeBruijnEdge *> * nextNodeEdges = nextNode->getEdgesPointer();
-    for (size_t i = 0; i < nextNodeEdges->size(); ++i)
-    {
-        DeBruijnEdge * edge = (*nextNodeEdges)[i];
-
-        //If forward, we're looking for edges that lead away from
-        //nextNode.  If backward, we're looking for edges that lead
-        //into nextNode.
-        if ((forward && edge->m_startingNode == nextNode) ||
-                (!forward && edge->m_endingNode == nextNode))
-            nextEdges.push_back(edge);
-    }
-
-    return nextEdges;
+    //If forward, we're looking for edges that lead away from
+    //nextNode.  If backward, we're looking for edges that lead
+    //into nextNode.
+    if (forward)
+        return nextNode->getLeavingEdgeRange();
+    else
+        return nextNode->getEnteringEdgeRange();
 }
 
 
@@ -333,47 +328,121 @@ void DeBruijnEdge::autoDetermineExactOverlap()
     m_overlap = 0;
     m_overlapType = AUTO_DETERMINED_EXACT_OVERLAP;
 
-    //Find an appropriate search range
+    int min, max;
+    if (!getAutoOverlapSearchRange(&min, &max))
+        return;
+
+    //We don't want the search to be biased towards larger or smaller
+    //overlaps, so start with a pseudorandom value and loop.
+    int firstOverlap = min + (rand() % (max - min + 1));
+    std::vector<int> overlaps = findExactOverlaps(m_startingNode->getSequence(),
+                                                  m_endingNode->getSequence(),
+                                                  min, max);
+    m_overlap = chooseExactOverlap(overlaps, firstOverlap);
+}
+
+
+//This function gets the range of overlaps to search for this edge.  It
+//returns false if the nodes are too short to search.
+bool DeBruijnEdge::getAutoOverlapSearchRange(int * min, int * max) const
+{
     int minPossibleOverlap = std::min(m_startingNode->getLength(), m_endingNode->getLength());
     if (minPossibleOverlap < g_settings->minAutoFindEdgeOverlap)
-        return;
-    int min = std::min(minPossibleOverlap, g_settings->minAutoFindEdgeOverlap);
-    int max = std::min(minPossibleOverlap, g_settings->maxAutoFindEdgeOverlap);
-
-    //Try each overlap in the range and set the first one found.
-    //However, we don't want the search to be biased towards larger
-    //or smaller overlaps, so start with a pseudorandom value and loop.
-    int testOverlap = min + (rand() % (max - min + 1));
-    for (int i = min; i <= max; ++i)
+        return false;
+    *min = std::min(minPossibleOverlap, g_settings->minAutoFindEdgeOverlap);
+    *max = std::min(minPossibleOverlap, g_settings->maxAutoFindEdgeOverlap);
+    return true;
+}
+
+
+//This function finds every overlap in the range for which the end of the
+//starting sequence exactly matches the start of the ending sequence.  It
+//does this in one pass using the Z-function of the ending sequence's prefix
+//followed by the starting sequence's suffix: the suffix of length L matches
+//when its Z value reaches the end of the string.  The overlaps are returned
+//in increasing order.
+std::vector<int> DeBruijnEdge::findExactOverlaps(const QByteArray & startingSequence,
+                                                 const QByteArray & endingSequence,
+                                                 int min, int max)
+{
+    std::vector<int> overlaps;
+    max = std::min(max, std::min(startingSequence.length(), endingSequence.length()));
+    if (max < min)
+        return overlaps;
+    if (min <= 0)
+        overlaps.push_back(0);
+    if (max <= 0)
+        return overlaps;
+
+    QByteArray s = endingSequence.left(max) + startingSequence.right(max);
+    const char * data = s.constData();
+    int n = s.length();
+    std::vector<int> z(n, 0);
+    int left = 0, right = 0;
+    for (int i = 1; i < n; ++i)
     {
-        if (testExactOverlap(testOverlap))
+        if (i < right)
+            z[i] = std::min(right - i, z[i - left]);
+        while (i + z[i] < n && data[z[i]] == data[i + z[i]])
+            ++z[i];
+        if (i + z[i] > right)
         {
-            m_overlap = testOverlap;
-            return;
+            left = i;
+            right = i + z[i];
         }
+    }
 
-        ++testOverlap;
-        if (testOverlap > max)
-            testOverlap = min;
+    for (int overlap = std::max(min, 1); overlap <= max; ++overlap)
+    {
+        if (z[n - overlap] == overlap)
+            overlaps.push_back(overlap);
     }
+    return overlaps;
 }
 
 
+//This function gives the same overlap as trying each overlap in turn,
+//starting from firstOverlap and wrapping around to the bottom of the range:
+//the smallest overlap at or above firstOverlap, otherwise the smallest one.
+int DeBruijnEdge::chooseExactOverlap(const std::vector<int> & overlaps, int firstOverlap)
+{
+    if (overlaps.empty())
+        return 0;
+    std::vector<int>::const_iterator i = std::lower_bound(overlaps.begin(), overlaps.end(), firstOverlap);
+    if (i == overlaps.end())
+        return overlaps.front();
+    return *i;
+}
+
+
+
+
+static char getBaseAt(const QByteArray & sequence, int i)
+{
+    if (i >= 0 && i < sequence.length())
+        return sequence.at(i);
+    else
+        return '\0';
+}
 
 
 //This function tries the given overlap between the two nodes.
 //If the overlap works perfectly, it returns true.
+//The sequences are got once, as a node's sequence may have to be read from
+//an indexed FASTA file.
 bool DeBruijnEdge::testExactOverlap(int overlap) const
 {
     bool mismatchFound = false;
 
+    QByteArray startingSequence = m_startingNode->getSequence();
+    QByteArray endingSequence = m_endingNode->getSequence();
     int seq1Offset = m_startingNode->getLength() - overlap;
 
     //Look at each position in the overlap
     for (int j = 0; j < overlap && !mismatchFound; ++j)
     {
-        char a = m_startingNode->getBaseAt(seq1Offset + j);
-        char b = m_endingNode->getBaseAt(j);
+        char a = getBaseAt(startingSequence, seq1Offset + j);
+        char b = getBaseAt(endingSequence, j);
         if (a != b)
             mismatchFound = true;
     }
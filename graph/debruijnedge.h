@@ -21,6 +21,8 @@
 
 #include "../ogdf/basic/Graph.h"
 #include "debruijnnode.h"
+#include <QByteArray>
+#include <vector>
 
 class GraphicsItemEdge;
 
@@ -41,6 +43,7 @@ public:
     EdgeOverlapType getOverlapType() const {return m_overlapType;}
     DeBruijnNode * getOtherNode(const DeBruijnNode * node) const;
     bool testExactOverlap(int overlap) const;
+    bool getAutoOverlapSearchRange(int * min, int * max) const;
     void tracePaths(bool forward,
                     int stepsRemaining,
                     std::vector<std::vector<DeBruijnNode *> > * allPaths,
@@ -68,6 +71,12 @@ public:
     void autoDetermineExactOverlap();
     void addToOgdfGraph(ogdf::Graph * ogdfGraph, ogdf::EdgeArray<double> * edgeArray) const;
 
+    //STATIC
+    static std::vector<int> findExactOverlaps(const QByteArray & startingSequence,
+                                              const QByteArray & endingSequence,
+                                              int min, int max);
+    static int chooseExactOverlap(const std::vector<int> & overlaps, int firstOverlap);
+
 private:
     DeBruijnNode * m_startingNode;
     DeBruijnNode * m_endingNode;
@@ -79,8 +88,8 @@ private:
 
     bool edgeIsVisible() const;
     int timesNodeInPath(DeBruijnNode * node, std::vector<DeBruijnNode *> * path) const;
-    std::vector<DeBruijnEdge *> findNextEdgesInPath(DeBruijnNode * nextNode,
-                                                    bool forward) const;
+    DeBruijnEdgeRange findNextEdgesInPath(DeBruijnNode * nextNode,
+                                          bool forward) const;
 };
 
 #endif // DEBRUIJNEDGE_H
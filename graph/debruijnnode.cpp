@@ -25,29 +25,31 @@
 #include "../blast/blastquery.h"
 #include "assemblygraph.h"
 #include <set>
+#include <algorithm>
 #include <QApplication>
 #include <QSet>
 
 
 //The length parameter is optional.  If it is set, then the node will use that
 //for its length.  If not set, it will just use the sequence length.
-DeBruijnNode::DeBruijnNode(QString name, double depth, QByteArray sequence, int length) :
+//The node is added to the attribute table, which gives the node its ID.
+DeBruijnNode::DeBruijnNode(NodeAttributes * attributes, QString name, double depth,
+                           QByteArray sequence, int length) :
+    m_attributes(attributes),
     m_name(name),
-    m_depth(depth),
-    m_depthRelativeToMeanDrawnDepth(1.0),
     m_sequence(sequence),
-    m_length(sequence.length()),
     m_contiguityStatus(NOT_CONTIGUOUS),
     m_reverseComplement(0),
     m_ogdfNode(0),
     m_graphicsItemNode(0),
+    m_leavingOnlyCount(0),
+    m_selfLoopCount(0),
     m_specialNode(false),
-    m_drawn(false),
-    m_highestDistanceInNeighbourSearch(0),
-    m_csvData()
+    m_csvRow(-1)
 {
-    if (length > 0)
-        m_length = length;
+    if (length <= 0)
+        length = sequence.length();
+    m_id = m_attributes->addNode(this, depth, length, name.endsWith("+"));
 }
 
 
@@ -55,23 +57,87 @@ DeBruijnNode::~DeBruijnNode()
 {
     if (m_ogdfNode != 0)
         delete m_ogdfNode;
+    m_attributes->removeNode(m_id);
 }
 
 
+void DeBruijnNode::setName(QString newName)
+{
+    m_name = newName;
+    m_attributes->m_positive[m_id] = isPositiveNode();
+    m_attributes->nodeRenamed();
+}
+
 
-//This function adds an edge to the Node, but only if the edge hasn't already
-//been added.
+
+//This function adds an edge to the node, placing it in the leaving,
+//self-looping or entering group.  The caller is responsible for not adding
+//the same edge twice (AssemblyGraph::createDeBruijnEdge ensures this), so no
+//search of the existing edges is needed.
+//The edge is added to the end and then swapped into its group: the first
+//edge of each later group is moved to that group's end.  This keeps adding an
+//edge constant time, even for a node with many edges, but the edges in a
+//group are not kept in the order they were added.
 void DeBruijnNode::addEdge(DeBruijnEdge * edge)
 {
-    if (std::find(m_edges.begin(), m_edges.end(), edge) == m_edges.end())
-        m_edges.push_back(edge);
+    bool leaving = (edge->getStartingNode() == this);
+    bool entering = (edge->getEndingNode() == this);
+    if (!leaving && !entering)
+        return;
+
+    m_edges.push_back(edge);
+    if (!leaving)
+        return;
+
+    int selfLoopEnd = m_leavingOnlyCount + m_selfLoopCount;
+    std::swap(m_edges[selfLoopEnd], m_edges.back());
+    if (entering)
+    {
+        ++m_selfLoopCount;
+        return;
+    }
+    std::swap(m_edges[m_leavingOnlyCount], m_edges[selfLoopEnd]);
+    ++m_leavingOnlyCount;
 }
 
 
 //This function deletes an edge from the node, if it exists.
 void DeBruijnNode::removeEdge(DeBruijnEdge * edge)
 {
-    m_edges.erase(std::remove(m_edges.begin(), m_edges.end(), edge), m_edges.end());
+    std::vector<DeBruijnEdge *>::iterator i = std::find(m_edges.begin(), m_edges.end(), edge);
+    if (i == m_edges.end())
+        return;
+
+    int index = int(i - m_edges.begin());
+    if (index < m_leavingOnlyCount)
+        --m_leavingOnlyCount;
+    else if (index < m_leavingOnlyCount + m_selfLoopCount)
+        --m_selfLoopCount;
+    m_edges.erase(i);
+}
+
+
+//This function deletes any of the given edges from the node in one pass.
+//The order of the remaining edges is kept, so the groups only need their
+//sizes adjusting.
+void DeBruijnNode::removeEdges(const QSet<DeBruijnEdge *> & edges)
+{
+    int leavingOnlyCount = 0;
+    int selfLoopCount = 0;
+    std::vector<DeBruijnEdge *>::iterator newEnd = m_edges.begin();
+    for (size_t i = 0; i < m_edges.size(); ++i)
+    {
+        if (edges.contains(m_edges[i]))
+            continue;
+        if (int(i) < m_leavingOnlyCount)
+            ++leavingOnlyCount;
+        else if (int(i) < m_leavingOnlyCount + m_selfLoopCount)
+            ++selfLoopCount;
+        *newEnd++ = m_edges[i];
+    }
+    m_edges.erase(newEnd, m_edges.end());
+    m_leavingOnlyCount = leavingOnlyCount;
+    m_selfLoopCount = selfLoopCount;
 }
 
 
@@ -86,7 +152,6 @@ void DeBruijnNode::resetNode()
     resetContiguityStatus();
     setAsNotDrawn();
     setAsNotSpecial();
-    m_highestDistanceInNeighbourSearch = 0;
 }
 
 
@@ -440,13 +505,13 @@ QByteArray DeBruijnNode::getSequenceForGfa() const
 
 QByteArray DeBruijnNode::getUpstreamSequence(int upstreamSequenceLength) const
 {
-    std::vector<DeBruijnNode*> upstreamNodes = getUpstreamNodes();
+    DeBruijnEdgeRange enteringEdges = getEnteringEdgeRange();
 
     QByteArray bestUpstreamNodeSequence;
 
-    for (size_t i = 0; i < upstreamNodes.size(); ++i)
+    for (size_t i = 0; i < enteringEdges.size(); ++i)
     {
-        DeBruijnNode * upstreamNode = upstreamNodes[i];
+        DeBruijnNode * upstreamNode = enteringEdges[i]->getStartingNode();
         QByteArray upstreamNodeFullSequence = upstreamNode->getSequence();
         QByteArray upstreamNodeSequence;
 
@@ -488,7 +553,7 @@ int DeBruijnNode::getFullLength() const
 int DeBruijnNode::getLengthWithoutTrailingOverlap() const
 {
     int length = getLength();
-    std::vector<DeBruijnEdge *> leavingEdges = getLeavingEdges();
+    DeBruijnEdgeRange leavingEdges = getLeavingEdgeRange();
 
     if (leavingEdges.size() == 0)
         return length;
@@ -529,41 +594,6 @@ QString DeBruijnNode::getNodeNameForFasta(bool sign) const
 }
 
 
-//This function recursively labels all nodes as drawn that are within a
-//certain distance of this node.  Whichever node called this will
-//definitely be drawn, so that one is excluded from the recursive call.
-void DeBruijnNode::labelNeighbouringNodesAsDrawn(int nodeDistance, DeBruijnNode * callingNode)
-{
-    if (m_highestDistanceInNeighbourSearch > nodeDistance)
-        return;
-    m_highestDistanceInNeighbourSearch = nodeDistance;
-
-    if (nodeDistance == 0)
-        return;
-
-    DeBruijnNode * otherNode;
-    for (size_t i = 0; i < m_edges.size(); ++i)
-    {
-        otherNode = m_edges[i]->getOtherNode(this);
-
-        if (otherNode == callingNode)
-            continue;
-
-        if (g_settings->doubleMode)
-            otherNode->m_drawn = true;
-        else //single mode
-        {
-            if (otherNode->isPositiveNode())
-                otherNode->m_drawn = true;
-            else
-                otherNode->getReverseComplement()->m_drawn = true;
-        }
-        otherNode->labelNeighbouringNodesAsDrawn(nodeDistance-1, this);
-    }
-}
-
-
-
 std::vector<BlastHitPart> DeBruijnNode::getBlastHitPartsForThisNode(double scaledNodeLength) const
 {
     std::vector<BlastHitPart> returnVector;
@@ -623,10 +653,11 @@ bool DeBruijnNode::isNegativeNode() const
 //it returns a null pointer.
 DeBruijnEdge * DeBruijnNode::doesNodeLeadIn(DeBruijnNode * node) const
 {
-    for (size_t i = 0; i < m_edges.size(); ++i)
+    DeBruijnEdgeRange enteringEdges = getEnteringEdgeRange();
+    for (size_t i = 0; i < enteringEdges.size(); ++i)
     {
-        DeBruijnEdge * edge = m_edges[i];
-        if (edge->getStartingNode() == node && edge->getEndingNode() == this)
+        DeBruijnEdge * edge = enteringEdges[i];
+        if (edge->getStartingNode() == node)
             return edge;
     }
     return 0;
@@ -637,10 +668,11 @@ DeBruijnEdge * DeBruijnNode::doesNodeLeadIn(DeBruijnNode * node) const
 //it returns a null pointer.
 DeBruijnEdge * DeBruijnNode::doesNodeLeadAway(DeBruijnNode * node) const
 {
-    for (size_t i = 0; i < m_edges.size(); ++i)
+    DeBruijnEdgeRange leavingEdges = getLeavingEdgeRange();
+    for (size_t i = 0; i < leavingEdges.size(); ++i)
     {
-        DeBruijnEdge * edge = m_edges[i];
-        if (edge->getStartingNode() == this && edge->getEndingNode() == node)
+        DeBruijnEdge * edge = leavingEdges[i];
+        if (edge->getEndingNode() == node)
             return edge;
     }
     return 0;
@@ -660,36 +692,27 @@ bool DeBruijnNode::isNodeConnected(DeBruijnNode * node) const
 
 
 
+//These functions return copies of the edge ranges.  Code in loops should use
+//getEnteringEdgeRange and getLeavingEdgeRange instead, which don't allocate.
 std::vector<DeBruijnEdge *> DeBruijnNode::getEnteringEdges() const
 {
-    std::vector<DeBruijnEdge *> returnVector;
-    for (size_t i = 0; i < m_edges.size(); ++i)
-    {
-        DeBruijnEdge * edge = m_edges[i];
-        if (this == edge->getEndingNode())
-            returnVector.push_back(edge);
-    }
-    return returnVector;
+    DeBruijnEdgeRange enteringEdges = getEnteringEdgeRange();
+    return std::vector<DeBruijnEdge *>(enteringEdges.begin(), enteringEdges.end());
 }
 std::vector<DeBruijnEdge *> DeBruijnNode::getLeavingEdges() const
 {
-    std::vector<DeBruijnEdge *> returnVector;
-    for (size_t i = 0; i < m_edges.size(); ++i)
-    {
-        DeBruijnEdge * edge = m_edges[i];
-        if (this == edge->getStartingNode())
-            returnVector.push_back(edge);
-    }
-    return returnVector;
+    DeBruijnEdgeRange leavingEdges = getLeavingEdgeRange();
+    return std::vector<DeBruijnEdge *>(leavingEdges.begin(), leavingEdges.end());
 }
 
 
 
 std::vector<DeBruijnNode *> DeBruijnNode::getDownstreamNodes() const
 {
-    std::vector<DeBruijnEdge *> leavingEdges = getLeavingEdges();
+    DeBruijnEdgeRange leavingEdges = getLeavingEdgeRange();
 
     std::vector<DeBruijnNode *> returnVector;
+    returnVector.reserve(leavingEdges.size());
     for (size_t i = 0; i < leavingEdges.size(); ++i)
         returnVector.push_back(leavingEdges[i]->getEndingNode());
 
@@ -699,9 +722,10 @@ std::vector<DeBruijnNode *> DeBruijnNode::getDownstreamNodes() const
 
 std::vector<DeBruijnNode *> DeBruijnNode::getUpstreamNodes() const
 {
-    std::vector<DeBruijnEdge *> enteringEdges = getEnteringEdges();
+    DeBruijnEdgeRange enteringEdges = getEnteringEdgeRange();
 
     std::vector<DeBruijnNode *> returnVector;
+    returnVector.reserve(enteringEdges.size());
     for (size_t i = 0; i < enteringEdges.size(); ++i)
         returnVector.push_back(enteringEdges[i]->getStartingNode());
 
@@ -722,27 +746,69 @@ double DeBruijnNode::getNodeLengthPerMegabase() const
 
 bool DeBruijnNode::isInDepthRange(double min, double max) const
 {
-    return m_depth >= min && m_depth <= max;
+    double depth = getDepth();
+    return depth >= min && depth <= max;
 }
 
 
+//The node's CSV data is held in the graph's CSV table.
+QString DeBruijnNode::getCsvLine(int i) const
+{
+    return g_assemblyGraph->m_csvData.getValue(m_csvRow, i);
+}
+
+
+//A node's sequence isn't missing if it can be read from an indexed FASTA file,
+//even though the node itself doesn't store it.
 bool DeBruijnNode::sequenceIsMissing() const
 {
-    return m_sequence == "*" || (m_sequence == "" && m_length > 0);
+    return storedSequenceIsMissing() && !g_assemblyGraph->hasIndexedSequence(this);
+}
+
+
+bool DeBruijnNode::storedSequenceIsMissing() const
+{
+    return m_sequence == "*" || (m_sequence == "" && getLength() > 0);
 }
 
 
 QByteArray DeBruijnNode::getSequence() const
 {
-    if (sequenceIsMissing() && g_assemblyGraph->m_sequencesLoadedFromFasta == NOT_TRIED)
+    if (!storedSequenceIsMissing())
+        return m_sequence;
+
+    if (g_assemblyGraph->m_sequencesLoadedFromFasta == NOT_TRIED)
         g_assemblyGraph->attemptToLoadSequencesFromFasta();
+    if (!storedSequenceIsMissing())
+        return m_sequence;
+
+    QByteArray indexedSequence = g_assemblyGraph->getIndexedSequence(this);
+    if (!indexedSequence.isNull())
+        return indexedSequence;
 
     //If the sequence is still missing, return a string of Ns equal to the
     //sequence length.
-    if (sequenceIsMissing())
-        return QByteArray(m_length, 'N');
+    return QByteArray(getLength(), 'N');
+}
+
+
+//An indexed node's sequence is read from the FASTA file for each call, so
+//code which looks at many of a node's bases should get its sequence once
+//instead.
+char DeBruijnNode::getBaseAt(int i) const
+{
+    if (storedSequenceIsMissing() && g_assemblyGraph->hasIndexedSequence(this))
+    {
+        QByteArray sequence = getSequence();
+        if (i >= 0 && i < sequence.length())
+            return sequence.at(i);
+        return '\0';
+    }
+
+    if (i >= 0 && i < m_sequence.length())
+        return m_sequence.at(i);
     else
-        return m_sequence;  
+        return '\0';
 }
 
 
@@ -751,12 +817,8 @@ QByteArray DeBruijnNode::getSequence() const
 //will return it.  Otherwise, it returns 0.
 DeBruijnEdge * DeBruijnNode::getSelfLoopingEdge() const
 {
-    for (size_t i = 0; i < m_edges.size(); ++i)
-    {
-        DeBruijnEdge * edge = m_edges[i];
-        if (edge->getStartingNode() == this && edge->getEndingNode() == this)
-            return edge;
-    }
+    if (m_selfLoopCount > 0)
+        return m_edges[m_leavingOnlyCount];
 
     return 0;
 }
@@ -770,10 +832,7 @@ int DeBruijnNode::getDeadEndCount() const
     if (m_edges.size() == 0)
         return 2;
 
-    std::vector<DeBruijnEdge *> enteringEdges = getEnteringEdges();
-    std::vector<DeBruijnEdge *> leavingEdges = getLeavingEdges();
-
-    if (enteringEdges.size() > 0 && leavingEdges.size() > 0)
+    if (getEnteringEdgeCount() > 0 && getLeavingEdgeCount() > 0)
         return 0;
     else
         return 1;
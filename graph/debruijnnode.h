@@ -25,35 +25,58 @@
 #include "../ogdf/basic/GraphAttributes.h"
 #include "../program/globals.h"
 #include <QColor>
+#include <QSet>
 #include "../blast/blasthitpart.h"
 #include "../program/settings.h"
+#include "nodeattributes.h"
 
 class OgdfNode;
 class DeBruijnEdge;
 class GraphicsItemNode;
 class BlastHit;
 
+//A view of a contiguous run of a node's edges, e.g. all of its leaving edges.
+//It does not copy the edges, so it is only valid until the node's edges are
+//next changed.
+class DeBruijnEdgeRange
+{
+public:
+    DeBruijnEdgeRange(DeBruijnEdge * const * begin, DeBruijnEdge * const * end) :
+        m_begin(begin), m_end(end) {}
+    DeBruijnEdge * const * begin() const {return m_begin;}
+    DeBruijnEdge * const * end() const {return m_end;}
+    size_t size() const {return m_end - m_begin;}
+    bool empty() const {return m_begin == m_end;}
+    DeBruijnEdge * operator[](size_t i) const {return m_begin[i];}
+
+private:
+    DeBruijnEdge * const * m_begin;
+    DeBruijnEdge * const * m_end;
+};
+
 class DeBruijnNode
 {
 public:
     //CREATORS
-    DeBruijnNode(QString name, double depth, QByteArray sequence, int length = 0);
+    DeBruijnNode(NodeAttributes * attributes, QString name, double depth,
+                 QByteArray sequence, int length = 0);
     ~DeBruijnNode();
 
     //ACCESSORS
     QString getName() const {return m_name;}
     QString getNameWithoutSign() const {return m_name.left(m_name.length() - 1);}
     QString getSign() const {if (m_name.length() > 0) return m_name.right(1); else return "+";}
-    double getDepth() const {return m_depth;}
-    double getDepthRelativeToMeanDrawnDepth() const {return m_depthRelativeToMeanDrawnDepth;}
+    int getId() const {return m_id;}
+    double getDepth() const {return m_attributes->m_depths[m_id];}
+    double getDepthRelativeToMeanDrawnDepth() const {return m_attributes->m_relativeDepths[m_id];}
     QByteArray getSequence() const;
-    int getLength() const {return m_length;}
+    int getLength() const {return m_attributes->m_lengths[m_id];}
     QByteArray getSequenceForGfa() const;
     int getFullLength() const;
     int getLengthWithoutTrailingOverlap() const;
     QByteArray getFasta(bool sign, bool newLines = true, bool evenIfEmpty = true) const;
     QByteArray getGfaSegmentLine(QString depthTag) const;
-    char getBaseAt(int i) const {if (i >= 0 && i < m_sequence.length()) return m_sequence.at(i); else return '\0';}
+    char getBaseAt(int i) const;
     ContiguityStatus getContiguityStatus() const {return m_contiguityStatus;}
     DeBruijnNode * getReverseComplement() const {return m_reverseComplement;}
     OgdfNode * getOgdfNode() const {return m_ogdfNode;}
@@ -61,15 +84,19 @@ public:
     bool thisOrReverseComplementHasGraphicsItemNode() const {return (m_graphicsItemNode != 0 || getReverseComplement()->m_graphicsItemNode != 0);}
     bool hasGraphicsItem() const {return m_graphicsItemNode != 0;}
     const std::vector<DeBruijnEdge *> * getEdgesPointer() const {return &m_edges;}
+    DeBruijnEdgeRange getLeavingEdgeRange() const {return DeBruijnEdgeRange(m_edges.data(), m_edges.data() + m_leavingOnlyCount + m_selfLoopCount);}
+    DeBruijnEdgeRange getEnteringEdgeRange() const {return DeBruijnEdgeRange(m_edges.data() + m_leavingOnlyCount, m_edges.data() + m_edges.size());}
+    int getLeavingEdgeCount() const {return m_leavingOnlyCount + m_selfLoopCount;}
+    int getEnteringEdgeCount() const {return int(m_edges.size()) - m_leavingOnlyCount;}
     std::vector<DeBruijnEdge *> getEnteringEdges() const;
     std::vector<DeBruijnEdge *> getLeavingEdges() const;
     std::vector<DeBruijnNode *> getDownstreamNodes() const;
     std::vector<DeBruijnNode *> getUpstreamNodes() const;
     std::vector<DeBruijnNode *> getAllConnectedPositiveNodes() const;
     bool isSpecialNode() const {return m_specialNode;}
-    bool isDrawn() const {return m_drawn;}
+    bool isDrawn() const {return m_attributes->m_drawn[m_id];}
     bool thisNodeOrReverseComplementIsDrawn() const {return isDrawn() || getReverseComplement()->isDrawn();}
-    bool isNotDrawn() const {return !m_drawn;}
+    bool isNotDrawn() const {return !m_attributes->m_drawn[m_id];}
     QColor getCustomColour() const {return m_customColour;}
     QColor getCustomColourForDisplay() const;
     QString getCustomLabel() const {return m_customLabel;}
@@ -89,62 +116,70 @@ public:
     DeBruijnEdge * doesNodeLeadAway(DeBruijnNode * node) const;
     std::vector<BlastHitPart> getBlastHitPartsForThisNode(double scaledNodeLength) const;
     std::vector<BlastHitPart> getBlastHitPartsForThisNodeOrReverseComplement(double scaledNodeLength) const;
-    bool hasCsvData() const {return !m_csvData.isEmpty();}
-    QStringList getAllCsvData() const {return m_csvData;}
-    QString getCsvLine(int i) const {if (i < m_csvData.length()) return m_csvData[i]; else return "";}
+    bool hasCsvData() const {return m_csvRow >= 0;}
+    int getCsvRow() const {return m_csvRow;}
+    QString getCsvLine(int i) const;
     bool isInDepthRange(double min, double max) const;
     bool sequenceIsMissing() const;
+    bool storedSequenceIsMissing() const;
     DeBruijnEdge *getSelfLoopingEdge() const;
     int getDeadEndCount() const;
     int getNumberOfOgdfGraphEdges(double drawnNodeLength) const;
     double getDrawnNodeLength() const;
 
     //MODIFERS
-    void setDepthRelativeToMeanDrawnDepth(double newVal) {m_depthRelativeToMeanDrawnDepth = newVal;}
-    void setSequence(QByteArray newSeq) {m_sequence = newSeq; m_length = m_sequence.length();}
-    void appendToSequence(QByteArray additionalSeq) {m_sequence.append(additionalSeq); m_length = m_sequence.length();}
+    void setDepthRelativeToMeanDrawnDepth(double newVal) {m_attributes->m_relativeDepths[m_id] = newVal;}
+    void setSequence(QByteArray newSeq) {m_sequence = newSeq; m_attributes->m_lengths[m_id] = m_sequence.length();}
+    void appendToSequence(QByteArray additionalSeq) {m_sequence.append(additionalSeq); m_attributes->m_lengths[m_id] = m_sequence.length();}
     void upgradeContiguityStatus(ContiguityStatus newStatus);
     void resetContiguityStatus() {m_contiguityStatus = NOT_CONTIGUOUS;}
     void setReverseComplement(DeBruijnNode * rc) {m_reverseComplement = rc;}
     void setGraphicsItemNode(GraphicsItemNode * gin) {m_graphicsItemNode = gin;}
     void setAsSpecial() {m_specialNode = true;}
     void setAsNotSpecial() {m_specialNode = false;}
-    void setAsDrawn() {m_drawn = true;}
-    void setAsNotDrawn() {m_drawn = false;}
+    void setAsDrawn() {m_attributes->m_drawn[m_id] = true;}
+    void setAsNotDrawn() {m_attributes->m_drawn[m_id] = false;}
     void setCustomColour(QColor newColour) {m_customColour = newColour;}
     void setCustomLabel(QString newLabel);
     void resetNode();
     void addEdge(DeBruijnEdge * edge);
     void removeEdge(DeBruijnEdge * edge);
+    void removeEdges(const QSet<DeBruijnEdge *> & edges);
     void addToOgdfGraph(ogdf::Graph * ogdfGraph, ogdf::GraphAttributes * graphAttributes,
                         ogdf::EdgeArray<double> * edgeArray, double xPos, double yPos);
     void determineContiguity();
     void clearBlastHits() {m_blastHits.clear();}
     void addBlastHit(BlastHit * newHit) {m_blastHits.push_back(newHit);}
-    void labelNeighbouringNodesAsDrawn(int nodeDistance, DeBruijnNode * callingNode);
-    void setCsvData(QStringList csvData) {m_csvData = csvData;}
-    void clearCsvData() {m_csvData.clear();}
-    void setDepth(double newDepth) {m_depth = newDepth;}
-    void setName(QString newName) {m_name = newName;}
+    void setCsvRow(int csvRow) {m_csvRow = csvRow;}
+    void clearCsvData() {m_csvRow = -1;}
+    void setDepth(double newDepth) {m_attributes->m_depths[m_id] = newDepth;}
+    void setName(QString newName);
+    void setId(int id) {m_id = id;}
 
 private:
+    //The depth, length and drawn status are stored by ID in the graph's
+    //NodeAttributes.
+    NodeAttributes * m_attributes;
+    int m_id;
     QString m_name;
-    double m_depth;
-    double m_depthRelativeToMeanDrawnDepth;
     QByteArray m_sequence;
-    int m_length;
     ContiguityStatus m_contiguityStatus;
     DeBruijnNode * m_reverseComplement;
     OgdfNode * m_ogdfNode;
     GraphicsItemNode * m_graphicsItemNode;
+
+    //The edges are kept grouped by direction: first the edges which only
+    //leave this node, then any self-looping edges, then the edges which only
+    //enter this node.  That makes the leaving and entering edges each one
+    //contiguous range, so they can be read without filtering or copying.
     std::vector<DeBruijnEdge *> m_edges;
+    int m_leavingOnlyCount;
+    int m_selfLoopCount;
     bool m_specialNode;
-    bool m_drawn;
-    int m_highestDistanceInNeighbourSearch;
     QColor m_customColour;
     QString m_customLabel;
     std::vector<BlastHit *> m_blastHits;
-    QStringList m_csvData;
+    int m_csvRow;
     QString getNodeNameForFasta(bool sign) const;
     QByteArray getUpstreamSequence(int upstreamSequenceLength) const;
 
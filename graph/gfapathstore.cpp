@@ -0,0 +1,327 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gfapathstore.h"
+#include "assemblygraph.h"
+#include "debruijnnode.h"
+#include "nodeattributes.h"
+#include <QtConcurrentMap>
+
+
+void GfaPathStore::clear()
+{
+    m_pendingPaths.clear();
+    m_names.clear();
+    m_pathIds.clear();
+    m_pathStarts.clear();
+    m_steps.clear();
+    m_nodePathStarts.clear();
+    m_nodePaths.clear();
+}
+
+
+//A P line has the path name in part 1 and the steps in part 2, e.g.
+//"11+,12-,13+".
+void GfaPathStore::addPathLine(const QStringList & lineParts)
+{
+    if (lineParts.size() < 3)
+        return;
+    PendingPath path;
+    path.name = lineParts.at(1);
+    path.steps = lineParts.at(2);
+    path.walk = false;
+    m_pendingPaths.push_back(path);
+}
+
+
+//A W line has a sample, haplotype index, sequence ID, start, end and the
+//steps, e.g. ">11<12>13".  The path is named sample#haplotype#sequence, with
+//the start and end added (":start-end") when they are given.
+void GfaPathStore::addWalkLine(const QStringList & lineParts)
+{
+    if (lineParts.size() < 7)
+        return;
+    PendingPath path;
+    path.name = lineParts.at(1) + "#" + lineParts.at(2) + "#" + lineParts.at(3);
+    if (lineParts.at(4) != "*" && lineParts.at(5) != "*")
+        path.name += ":" + lineParts.at(4) + "-" + lineParts.at(5);
+    path.steps = lineParts.at(6);
+    path.walk = true;
+    m_pendingPaths.push_back(path);
+}
+
+
+//One pending path for resolvePaths, which can be resolved in a separate
+//thread.
+struct PathResolutionJob
+{
+    const QString * steps;
+    bool walk;
+    const QHash<QString, int> * nodeIds;
+    std::vector<int> stepIds;
+    bool resolved;
+};
+
+static void resolvePathSteps(PathResolutionJob & job)
+{
+    const QString & steps = *job.steps;
+    int length = steps.length();
+    job.resolved = false;
+
+    int i = 0;
+    while (i < length)
+    {
+        QString nodeName;
+        if (job.walk)
+        {
+            //Walk steps start with '>' (forward) or '<' (reverse).
+            QChar orientation = steps.at(i);
+            if (orientation != '>' && orientation != '<')
+                return;
+            int nameEnd = i + 1;
+            while (nameEnd < length && steps.at(nameEnd) != '>' && steps.at(nameEnd) != '<')
+                ++nameEnd;
+            nodeName = steps.mid(i + 1, nameEnd - i - 1) + (orientation == '>' ? "+" : "-");
+            i = nameEnd;
+        }
+        else
+        {
+            //Path steps are separated by commas and end with + or -.
+            int nameEnd = steps.indexOf(',', i);
+            if (nameEnd < 0)
+                nameEnd = length;
+            nodeName = steps.mid(i, nameEnd - i);
+            i = nameEnd + 1;
+            if (!nodeName.endsWith('+') && !nodeName.endsWith('-'))
+                return;
+        }
+
+        int id = job.nodeIds->value(AssemblyGraph::simplifyCanuNodeName(nodeName), -1);
+        if (id < 0)
+            return;
+        job.stepIds.push_back(id);
+    }
+    job.resolved = !job.stepIds.empty();
+}
+
+
+//This function turns the pending P and W lines into steps of node IDs, in
+//parallel, and then builds the reverse index.  Paths with no steps or with
+//segments that aren't in the graph are dropped, as are paths with a name
+//that has already been used.  It returns the number of dropped paths.
+int GfaPathStore::resolvePaths(const QMap<QString, DeBruijnNode *> & nodes, int nodeIdCount)
+{
+    QHash<QString, int> nodeIds;
+    nodeIds.reserve(nodes.size());
+    QMapIterator<QString, DeBruijnNode*> i(nodes);
+    while (i.hasNext())
+    {
+        i.next();
+        nodeIds.insert(i.key(), i.value()->getId());
+    }
+
+    std::vector<PathResolutionJob> jobs(m_pendingPaths.size());
+    for (size_t j = 0; j < m_pendingPaths.size(); ++j)
+    {
+        jobs[j].steps = &m_pendingPaths[j].steps;
+        jobs[j].walk = m_pendingPaths[j].walk;
+        jobs[j].nodeIds = &nodeIds;
+    }
+    QtConcurrent::blockingMap(jobs, resolvePathSteps);
+
+    if (m_pathStarts.empty())
+        m_pathStarts.push_back(0);
+    long long stepCount = m_steps.size();
+    for (size_t j = 0; j < jobs.size(); ++j)
+    {
+        if (jobs[j].resolved)
+            stepCount += jobs[j].stepIds.size();
+    }
+    m_steps.reserve(stepCount);
+
+    int droppedCount = 0;
+    for (size_t j = 0; j < jobs.size(); ++j)
+    {
+        const QString & name = m_pendingPaths[j].name;
+        if (!jobs[j].resolved || m_pathIds.contains(name))
+        {
+            ++droppedCount;
+            continue;
+        }
+        m_pathIds.insert(name, m_names.size());
+        m_names.push_back(name);
+        m_steps.insert(m_steps.end(), jobs[j].stepIds.begin(), jobs[j].stepIds.end());
+        m_pathStarts.push_back(m_steps.size());
+        std::vector<int>().swap(jobs[j].stepIds);
+    }
+    m_pendingPaths.clear();
+
+    buildNodeIndex(nodeIdCount);
+    return droppedCount;
+}
+
+
+//This function is used after nodes are deleted.  newIds gives, for each old
+//node ID, the node's new ID or -1 if it was deleted.  Paths through a deleted
+//node are dropped, and the other paths keep their order.  It returns the
+//number of dropped paths.
+int GfaPathStore::renumberNodes(const std::vector<int> & newIds, int nodeIdCount)
+{
+    QStringList names;
+    std::vector<long long> pathStarts(1, 0);
+    long long stepCount = 0;
+    for (int path = 0; path < getPathCount(); ++path)
+    {
+        long long start = m_pathStarts[path];
+        long long end = m_pathStarts[path + 1];
+        bool keep = true;
+        for (long long j = start; j < end && keep; ++j)
+            keep = newIds[m_steps[j]] >= 0;
+        if (!keep)
+            continue;
+
+        //The kept steps are moved down over those of the dropped paths.
+        for (long long j = start; j < end; ++j)
+            m_steps[stepCount++] = newIds[m_steps[j]];
+        pathStarts.push_back(stepCount);
+        names.push_back(m_names[path]);
+    }
+    int droppedCount = getPathCount() - names.size();
+
+    m_steps.resize(stepCount);
+    m_pathStarts.swap(pathStarts);
+    m_names = names;
+    m_pathIds.clear();
+    for (int path = 0; path < m_names.size(); ++path)
+        m_pathIds.insert(m_names[path], path);
+
+    buildNodeIndex(nodeIdCount);
+    return droppedCount;
+}
+
+
+//This function is used when chains of nodes are merged, before the original
+//nodes are deleted.  mergedIds gives, for each node ID in a chain, the ID of
+//the new merged node (or -1 for nodes which weren't merged), and
+//chainPositions gives the node's place in the merged node's chain.  A run of
+//steps along one chain (each at the next place in the chain) is replaced by a
+//single step through the merged node.
+void GfaPathStore::mergeNodeRuns(const std::vector<int> & mergedIds, const std::vector<int> & chainPositions,
+                                 int nodeIdCount)
+{
+    long long stepCount = 0;
+    long long end = 0;
+    for (int path = 0; path < getPathCount(); ++path)
+    {
+        long long start = end;
+        end = m_pathStarts[path + 1];
+        int previousMergedId = -1;
+        int previousPosition = -1;
+        for (long long j = start; j < end; ++j)
+        {
+            int id = m_steps[j];
+            int mergedId = mergedIds[id];
+            if (mergedId < 0)
+            {
+                m_steps[stepCount++] = id;
+                previousMergedId = -1;
+                continue;
+            }
+
+            int position = chainPositions[id];
+            if (mergedId != previousMergedId || position != previousPosition + 1)
+                m_steps[stepCount++] = mergedId;
+            previousMergedId = mergedId;
+            previousPosition = position;
+        }
+
+        //The steps only move down, so the path's end can be updated now (its
+        //old end was kept as the next path's start).
+        m_pathStarts[path + 1] = stepCount;
+    }
+    m_steps.resize(stepCount);
+
+    buildNodeIndex(nodeIdCount);
+}
+
+
+//The reverse index is built with two passes over the steps: one to count
+//each node's paths and one to fill them in.  A node which a path passes
+//through more than once only lists that path once.
+void GfaPathStore::buildNodeIndex(int nodeIdCount)
+{
+    m_nodePathStarts.assign(nodeIdCount + 1, 0);
+    std::vector<int> lastPath(nodeIdCount, -1);
+    for (int path = 0; path < getPathCount(); ++path)
+    {
+        for (long long j = m_pathStarts[path]; j < m_pathStarts[path + 1]; ++j)
+        {
+            int id = m_steps[j];
+            if (lastPath[id] != path)
+            {
+                lastPath[id] = path;
+                ++m_nodePathStarts[id + 1];
+            }
+        }
+    }
+    for (int id = 0; id < nodeIdCount; ++id)
+        m_nodePathStarts[id + 1] += m_nodePathStarts[id];
+
+    m_nodePaths.resize(m_nodePathStarts[nodeIdCount]);
+    std::vector<long long> nextPosition(m_nodePathStarts.begin(), m_nodePathStarts.end() - 1);
+    lastPath.assign(nodeIdCount, -1);
+    for (int path = 0; path < getPathCount(); ++path)
+    {
+        for (long long j = m_pathStarts[path]; j < m_pathStarts[path + 1]; ++j)
+        {
+            int id = m_steps[j];
+            if (lastPath[id] != path)
+            {
+                lastPath[id] = path;
+                m_nodePaths[nextPosition[id]++] = path;
+            }
+        }
+    }
+}
+
+
+std::vector<DeBruijnNode *> GfaPathStore::getPathNodes(int path, const NodeAttributes & attributes) const
+{
+    std::vector<DeBruijnNode *> nodes;
+    nodes.reserve(getStepCount(path));
+    for (long long j = m_pathStarts[path]; j < m_pathStarts[path + 1]; ++j)
+        nodes.push_back(attributes.m_nodes[m_steps[j]]);
+    return nodes;
+}
+
+
+int GfaPathStore::getPathCountThroughNode(int nodeId) const
+{
+    if (nodeId < 0 || nodeId + 1 >= int(m_nodePathStarts.size()))
+        return 0;
+    return int(m_nodePathStarts[nodeId + 1] - m_nodePathStarts[nodeId]);
+}
+
+
+std::vector<int> GfaPathStore::getPathsThroughNode(int nodeId) const
+{
+    if (nodeId < 0 || nodeId + 1 >= int(m_nodePathStarts.size()))
+        return std::vector<int>();
+    return std::vector<int>(m_nodePaths.begin() + m_nodePathStarts[nodeId],
+                            m_nodePaths.begin() + m_nodePathStarts[nodeId + 1]);
+}
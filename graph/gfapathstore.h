@@ -0,0 +1,95 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GFAPATHSTORE_H
+#define GFAPATHSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMap>
+#include <vector>
+
+class DeBruijnNode;
+class NodeAttributes;
+
+//This class holds the paths from a GFA file's P (path) and W (walk) lines.
+//Each path is stored as a run of node IDs (the IDs in the graph's
+//NodeAttributes) in one step array.  Each strand of a segment is its own
+//node, so a step's ID also gives the orientation.  A reverse index gives,
+//for each node ID, the paths which pass through that node.
+//
+//The P and W lines are added as they are read from the file, but their
+//steps are only resolved to node IDs once the graph's nodes have been made
+//(paths can come before the segments they use).  Paths which use a segment
+//that isn't in the graph are dropped.
+//
+//When nodes are merged, each run of steps through a merged chain becomes one
+//step through the new node.  When nodes are deleted, the paths through them
+//are dropped and the others are given the remaining nodes' new IDs.
+
+class GfaPathStore
+{
+public:
+    GfaPathStore() {}
+
+    void clear();
+    void addPathLine(const QStringList & lineParts);
+    void addWalkLine(const QStringList & lineParts);
+    int resolvePaths(const QMap<QString, DeBruijnNode *> & nodes, int nodeIdCount);
+    int renumberNodes(const std::vector<int> & newIds, int nodeIdCount);
+    void mergeNodeRuns(const std::vector<int> & mergedIds, const std::vector<int> & chainPositions,
+                       int nodeIdCount);
+
+    int getPathCount() const {return m_names.size();}
+    QString getPathName(int path) const {return m_names[path];}
+    int findPath(const QString & name) const {return m_pathIds.value(name, -1);}
+    int getStepCount(int path) const {return int(m_pathStarts[path + 1] - m_pathStarts[path]);}
+    const int * getSteps(int path) const {return m_steps.data() + m_pathStarts[path];}
+    std::vector<DeBruijnNode *> getPathNodes(int path, const NodeAttributes & attributes) const;
+
+    int getPathCountThroughNode(int nodeId) const;
+    std::vector<int> getPathsThroughNode(int nodeId) const;
+
+private:
+    //Lines waiting for the graph's nodes.  The steps are given as node
+    //names, in the order they are walked.
+    struct PendingPath
+    {
+        QString name;
+        QString steps;
+        bool walk;
+    };
+    std::vector<PendingPath> m_pendingPaths;
+
+    QStringList m_names;
+    QHash<QString, int> m_pathIds;
+
+    //The steps of path i are at [m_pathStarts[i], m_pathStarts[i+1]).
+    std::vector<long long> m_pathStarts;
+    std::vector<int> m_steps;
+
+    //The paths through node ID i (each once, in order) are at
+    //[m_nodePathStarts[i], m_nodePathStarts[i+1]).
+    std::vector<long long> m_nodePathStarts;
+    std::vector<int> m_nodePaths;
+
+    void buildNodeIndex(int nodeIdCount);
+};
+
+#endif // GFAPATHSTORE_H
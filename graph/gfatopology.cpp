@@ -0,0 +1,429 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "gfatopology.h"
+#include "assemblygraph.h"
+#include "radixheap.h"
+#include "../program/compressedfile.h"
+#include "../program/recordfilewriter.h"
+#include <QStringList>
+#include <algorithm>
+#include <string.h>
+
+//This function reads the segments and links of a GFA file.  Only the length
+//of each segment's sequence is kept.  Links to segments which are not in the
+//file are dropped, as they are when Bandage loads the graph.
+bool GfaTopology::load(QString filename)
+{
+    m_names.clear();
+    m_lengths.clear();
+    m_segmentIds.clear();
+    m_linkCount = 0;
+    m_linkStarts.clear();
+    m_linkTargets.clear();
+    m_linkOverlaps.clear();
+
+    CompressedFile inputFile(filename);
+    if (!inputFile.open(QIODevice::ReadOnly))
+        return false;
+
+    //Links are kept by name until the end of the file, as they can come
+    //before the segments they join.
+    std::vector<QByteArray> linkStartNames;
+    std::vector<QByteArray> linkEndNames;
+    std::vector<int> linkOverlaps;
+
+    std::vector<int> fieldStarts;
+    while (!inputFile.atEnd())
+    {
+        QByteArray line = AssemblyGraph::removeLineEnding(inputFile.readLine());
+        if (line.length() < 2 || line[1] != '\t')
+            continue;
+
+        findFieldStarts(line, &fieldStarts);
+        int fieldCount = int(fieldStarts.size()) - 1;
+
+        if (line[0] == 'S')
+        {
+            if (fieldCount < 3)
+                return false;
+
+            QByteArray name = line.mid(fieldStarts[1], fieldStarts[2] - fieldStarts[1] - 1);
+            if (m_segmentIds.contains(name))
+                continue;
+
+            //As when loading the graph, the LN tag is only used when the
+            //sequence is not in the file.
+            int sequenceLength = fieldStarts[3] - fieldStarts[2] - 1;
+            int length = sequenceLength;
+            if (sequenceLength == 0 || (sequenceLength == 1 && line[fieldStarts[2]] == '*'))
+            {
+                length = 0;
+                for (int i = 3; i < fieldCount; ++i)
+                {
+                    const char * tag = line.constData() + fieldStarts[i];
+                    if (fieldStarts[i + 1] - fieldStarts[i] - 1 >= 6 &&
+                            strncmp(tag, "LN:i:", 5) == 0)
+                        length = line.mid(fieldStarts[i] + 5, fieldStarts[i + 1] - fieldStarts[i] - 6).toInt();
+                }
+            }
+
+            QString nodeName = QString::fromLocal8Bit(name);
+            if (nodeName.isEmpty())
+                nodeName = "node";
+            QString lastChar = nodeName.right(1);
+            if (lastChar != "+" && lastChar != "-")
+                nodeName += "+";
+            nodeName = AssemblyGraph::simplifyCanuNodeName(nodeName);
+
+            m_segmentIds.insert(name, int(m_names.size()));
+            m_names.push_back(nodeName);
+            m_lengths.push_back(length);
+        }
+
+        else if (line[0] == 'L')
+        {
+            if (fieldCount < 6)
+                return false;
+
+            linkStartNames.push_back(line.mid(fieldStarts[1], fieldStarts[2] - fieldStarts[1] - 1));
+            linkEndNames.push_back(line.mid(fieldStarts[3], fieldStarts[4] - fieldStarts[3] - 1));
+            linkOverlaps.push_back(getOverlapFromCigar(line.mid(fieldStarts[5], fieldStarts[6] - fieldStarts[5] - 1)));
+        }
+    }
+
+    if (inputFile.hasError() || m_names.empty())
+        return false;
+
+    //The links are put into a compressed adjacency list, with each link
+    //stored once for each of its segments.
+    int segmentCount = int(m_names.size());
+    std::vector<int> linkStarts(linkStartNames.size());
+    std::vector<int> linkEnds(linkStartNames.size());
+    m_linkStarts.assign(segmentCount + 1, 0);
+    for (size_t i = 0; i < linkStartNames.size(); ++i)
+    {
+        linkStarts[i] = m_segmentIds.value(linkStartNames[i], -1);
+        linkEnds[i] = m_segmentIds.value(linkEndNames[i], -1);
+        if (linkStarts[i] < 0 || linkEnds[i] < 0)
+            continue;
+        ++m_linkCount;
+        ++m_linkStarts[linkStarts[i] + 1];
+        ++m_linkStarts[linkEnds[i] + 1];
+    }
+    for (int i = 0; i < segmentCount; ++i)
+        m_linkStarts[i + 1] += m_linkStarts[i];
+
+    m_linkTargets.resize(m_linkStarts[segmentCount]);
+    m_linkOverlaps.resize(m_linkStarts[segmentCount]);
+    std::vector<int> nextLink(m_linkStarts.begin(), m_linkStarts.end() - 1);
+    for (size_t i = 0; i < linkStarts.size(); ++i)
+    {
+        if (linkStarts[i] < 0 || linkEnds[i] < 0)
+            continue;
+        int j = nextLink[linkStarts[i]]++;
+        m_linkTargets[j] = linkEnds[i];
+        m_linkOverlaps[j] = linkOverlaps[i];
+        j = nextLink[linkEnds[i]]++;
+        m_linkTargets[j] = linkStarts[i];
+        m_linkOverlaps[j] = linkOverlaps[i];
+    }
+
+    return true;
+}
+
+
+//This function finds the segments for a comma-separated list of node names,
+//in the same way as AssemblyGraph::getNodesFromString.  A name may be for
+//either node in a segment's pair, and a name without a +/- on the end is for
+//both.
+std::vector<int> GfaTopology::findSegments(QString nodesList, bool exactMatch,
+                                           std::vector<QString> * nodesNotFound) const
+{
+    std::vector<int> segments;
+    QStringList queries = nodesList.simplified().split(",");
+
+    QHash<QString, int> nodeNames;
+    if (exactMatch)
+    {
+        for (size_t i = 0; i < m_names.size(); ++i)
+        {
+            nodeNames.insert(m_names[i], int(i));
+            nodeNames.insert(AssemblyGraph::getOppositeNodeName(m_names[i]), int(i));
+        }
+    }
+
+    for (int i = 0; i < queries.size(); ++i)
+    {
+        QString query = queries.at(i).simplified();
+        if (query == "")
+            continue;
+
+        bool found = false;
+        if (exactMatch)
+        {
+            QChar lastChar = query.at(query.length() - 1);
+            QStringList names;
+            if (lastChar == '+' || lastChar == '-')
+                names << query;
+            else
+                names << query + "+" << query + "-";
+            for (int j = 0; j < names.size(); ++j)
+            {
+                int segment = nodeNames.value(names.at(j), -1);
+                if (segment >= 0)
+                {
+                    segments.push_back(segment);
+                    found = true;
+                }
+            }
+        }
+        else
+        {
+            for (size_t j = 0; j < m_names.size(); ++j)
+            {
+                if (m_names[j].contains(query) || AssemblyGraph::getOppositeNodeName(m_names[j]).contains(query))
+                {
+                    segments.push_back(int(j));
+                    found = true;
+                }
+            }
+        }
+
+        if (!found && nodesNotFound != 0)
+            nodesNotFound->push_back(queries.at(i).trimmed());
+    }
+
+    return segments;
+}
+
+
+//This function selects the segments within the given number of steps of any
+//of the starting segments, with a breadth-first search like
+//AssemblyGraph::labelNeighbouringNodesAsDrawn.
+std::vector<char> GfaTopology::selectWithinSteps(const std::vector<int> & startingSegments,
+                                                 int steps) const
+{
+    std::vector<char> selected(m_names.size(), 0);
+    std::vector<int> distances(m_names.size(), -1);
+
+    std::vector<int> queue;
+    for (size_t i = 0; i < startingSegments.size(); ++i)
+    {
+        int segment = startingSegments[i];
+        if (distances[segment] >= 0)
+            continue;
+        distances[segment] = 0;
+        selected[segment] = 1;
+        queue.push_back(segment);
+    }
+
+    for (size_t i = 0; i < queue.size(); ++i)
+    {
+        int segment = queue[i];
+        int distance = distances[segment];
+        if (distance >= steps)
+            continue;
+
+        for (int j = m_linkStarts[segment]; j < m_linkStarts[segment + 1]; ++j)
+        {
+            int otherSegment = m_linkTargets[j];
+            if (distances[otherSegment] >= 0)
+                continue;
+            distances[otherSegment] = distance + 1;
+            selected[otherSegment] = 1;
+            queue.push_back(otherSegment);
+        }
+    }
+
+    return selected;
+}
+
+
+//This function selects the segments which start within the given number of
+//bases of any of the starting segments, with a Dijkstra search like
+//AssemblyGraph::labelNodesWithinBasesAsDrawn.
+std::vector<char> GfaTopology::selectWithinBases(const std::vector<int> & startingSegments,
+                                                 int bases) const
+{
+    std::vector<char> selected(m_names.size(), 0);
+    std::vector<int> distances(m_names.size(), -1);
+    RadixHeap heap;
+
+    for (size_t i = 0; i < startingSegments.size(); ++i)
+    {
+        distances[startingSegments[i]] = 0;
+        selected[startingSegments[i]] = 1;
+    }
+
+    //The starting segments' own lengths don't count, so their neighbours are
+    //all at a distance of zero.
+    for (size_t i = 0; i < startingSegments.size(); ++i)
+    {
+        int segment = startingSegments[i];
+        for (int j = m_linkStarts[segment]; j < m_linkStarts[segment + 1]; ++j)
+        {
+            int otherSegment = m_linkTargets[j];
+            if (distances[otherSegment] == 0)
+                continue;
+            distances[otherSegment] = 0;
+            selected[otherSegment] = 1;
+            heap.push(0, otherSegment);
+        }
+    }
+
+    while (!heap.empty())
+    {
+        std::pair<unsigned int, int> entry = heap.pop();
+        int distance = int(entry.first);
+        int segment = entry.second;
+        if (distance != distances[segment])
+            continue;
+
+        long long farDistance = (long long)distance + m_lengths[segment];
+        for (int j = m_linkStarts[segment]; j < m_linkStarts[segment + 1]; ++j)
+        {
+            long long nextDistance = std::max((long long)distance, farDistance - m_linkOverlaps[j]);
+            if (nextDistance > bases)
+                continue;
+
+            int otherSegment = m_linkTargets[j];
+            if (distances[otherSegment] >= 0 && distances[otherSegment] <= nextDistance)
+                continue;
+            distances[otherSegment] = int(nextDistance);
+            selected[otherSegment] = 1;
+            heap.push((unsigned int)nextDistance, otherSegment);
+        }
+    }
+
+    return selected;
+}
+
+
+//This function copies the header lines, the S lines of the selected segments
+//and the L lines between selected segments from the input GFA to a new file.
+//Other lines are left out, as are links to segments not in the file.  The
+//output is block-gzipped if its name ends in .gz.
+bool GfaTopology::writeSubgraph(QString inputFilename, QString outputFilename,
+                                const std::vector<char> & selected) const
+{
+    CompressedFile inputFile(inputFilename);
+    if (!inputFile.open(QIODevice::ReadOnly))
+        return false;
+
+    RecordFileWriter writer(outputFilename, RecordFileWriter::isCompressedFilename(outputFilename));
+    if (!writer.open())
+        return false;
+
+    //Like load, only the first S line for each segment name is used, so any
+    //later duplicates are left out of the subgraph.
+    std::vector<char> segmentWritten(m_names.size(), 0);
+
+    std::vector<int> fieldStarts;
+    while (!inputFile.atEnd())
+    {
+        QByteArray line = AssemblyGraph::removeLineEnding(inputFile.readLine());
+        if (line.length() < 2 || line[1] != '\t')
+            continue;
+
+        bool keep = false;
+        if (line[0] == 'H')
+            keep = true;
+        else if (line[0] == 'S' || line[0] == 'L')
+        {
+            //Only the name fields are needed, so the end of the line (which
+            //holds the sequence for S lines) isn't searched.
+            int nameEnd = line.indexOf('\t', 2);
+            if (nameEnd < 0)
+                continue;
+            int segment = m_segmentIds.value(line.mid(2, nameEnd - 2), -1);
+            if (segment < 0 || !selected[segment])
+                continue;
+
+            if (line[0] == 'S')
+            {
+                if (segmentWritten[segment])
+                    continue;
+                segmentWritten[segment] = 1;
+                keep = true;
+            }
+            else
+            {
+                findFieldStarts(line, &fieldStarts);
+                if (fieldStarts.size() < 5)
+                    continue;
+                int otherSegment = m_segmentIds.value(line.mid(fieldStarts[3], fieldStarts[4] - fieldStarts[3] - 1), -1);
+                keep = (otherSegment >= 0 && selected[otherSegment]);
+            }
+        }
+
+        if (!keep)
+            continue;
+        line += '\n';
+        writer.write(line);
+    }
+
+    if (inputFile.hasError())
+    {
+        writer.close();
+        return false;
+    }
+    return writer.close();
+}
+
+
+//This function finds where each tab-separated field in the line starts.  One
+//more entry is added past the end of the line, so field i is always from
+//(*fieldStarts)[i] to (*fieldStarts)[i + 1] - 1.
+void GfaTopology::findFieldStarts(const QByteArray & line, std::vector<int> * fieldStarts)
+{
+    fieldStarts->clear();
+    fieldStarts->push_back(0);
+
+    const char * data = line.constData();
+    int length = line.length();
+    int position = 0;
+    while (position < length)
+    {
+        const char * tab = (const char *)memchr(data + position, '\t', length - position);
+        if (tab == 0)
+            break;
+        position = int(tab - data) + 1;
+        fieldStarts->push_back(position);
+    }
+    fieldStarts->push_back(length + 1);
+}
+
+
+//A "*" means the overlap is unspecified, so it is taken to be 0.  Simple
+//CIGARs (digits followed by "M") are read directly and anything else uses the
+//same crude handling as the graph loader.
+int GfaTopology::getOverlapFromCigar(const QByteArray & cigar)
+{
+    if (cigar.isEmpty() || cigar == "*")
+        return 0;
+
+    bool simple = cigar.endsWith('M') && cigar.length() > 1;
+    for (int i = 0; simple && i < cigar.length() - 1; ++i)
+        simple = (cigar[i] >= '0' && cigar[i] <= '9');
+    if (simple)
+        return cigar.left(cigar.length() - 1).toInt();
+
+    return AssemblyGraph::getLengthFromCigar(QString::fromLocal8Bit(cigar));
+}
+
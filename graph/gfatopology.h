@@ -0,0 +1,82 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef GFATOPOLOGY_H
+#define GFATOPOLOGY_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <vector>
+
+//This class holds just the topology of a GFA file: segment names, lengths
+//and links.  Sequences are never stored, so a subgraph of a very large GFA
+//can be chosen without loading the whole graph into an AssemblyGraph.  The
+//selected S and L lines are then copied from the file as they are.
+//
+//The topology has one entry per segment, i.e. per complementary node pair.
+//Every GFA link touches each strand of its two segments through exactly one
+//of the link's two edges, so distances between pairs here are the same as
+//the distances Bandage finds between its nodes when it draws the graph.
+//
+//Usage:
+//    GfaTopology topology;
+//    if (topology.load(filename))
+//        topology.writeSubgraph(filename, outputFilename,
+//                               topology.selectWithinSteps(startingSegments, 10));
+
+class GfaTopology
+{
+public:
+    GfaTopology() : m_linkCount(0) {}
+
+    bool load(QString filename);
+
+    int getSegmentCount() const {return int(m_lengths.size());}
+    int getLinkCount() const {return m_linkCount;}
+    QString getSegmentName(int segment) const {return m_names[segment];}
+    int getSegmentLength(int segment) const {return m_lengths[segment];}
+
+    std::vector<int> findSegments(QString nodesList, bool exactMatch,
+                                  std::vector<QString> * nodesNotFound) const;
+    std::vector<char> selectWithinSteps(const std::vector<int> & startingSegments,
+                                        int steps) const;
+    std::vector<char> selectWithinBases(const std::vector<int> & startingSegments,
+                                        int bases) const;
+    bool writeSubgraph(QString inputFilename, QString outputFilename,
+                       const std::vector<char> & selected) const;
+
+private:
+    //Segment names are those Bandage would give the positive node, so
+    //they end in +/-.
+    std::vector<QString> m_names;
+    std::vector<int> m_lengths;
+    QHash<QByteArray, int> m_segmentIds;
+    int m_linkCount;
+
+    //Links are stored in both directions, grouped by segment: the links of
+    //segment i are at [m_linkStarts[i], m_linkStarts[i+1]).
+    std::vector<int> m_linkStarts;
+    std::vector<int> m_linkTargets;
+    std::vector<int> m_linkOverlaps;
+
+    static void findFieldStarts(const QByteArray & line, std::vector<int> * fieldStarts);
+    static int getOverlapFromCigar(const QByteArray & cigar);
+};
+
+#endif // GFATOPOLOGY_H
@@ -0,0 +1,258 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "graphcomponents.h"
+#include "nodeattributes.h"
+#include "debruijnnode.h"
+#include "debruijnedge.h"
+#include <QAtomicInt>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <algorithm>
+#include <limits>
+
+//The nodes to join for one range of node IDs in the parallel union-find.
+struct ComponentUnionRange
+{
+    const NodeAttributes * attributes;
+    std::vector<QAtomicInt> * parents;
+    int begin;
+    int end;
+};
+
+
+//This union-find is lock-free, so threads can join nodes at the same time.
+//A root is only ever attached to a root with a lower ID, which is done with a
+//compare-and-swap that fails (and is retried) if another thread changed the
+//root first.  Path halving during finds is also done with a compare-and-swap,
+//but it is only a shortcut, so a failure is ignored.
+static int findRoot(std::vector<QAtomicInt> * parents, int i)
+{
+    while (true)
+    {
+        int parent = (*parents)[i].load();
+        if (parent == i)
+            return i;
+        int grandparent = (*parents)[parent].load();
+        if (grandparent != parent)
+            (*parents)[i].testAndSetRelaxed(parent, grandparent);
+        i = grandparent;
+    }
+}
+
+static void unite(std::vector<QAtomicInt> * parents, int a, int b)
+{
+    while (true)
+    {
+        a = findRoot(parents, a);
+        b = findRoot(parents, b);
+        if (a == b)
+            return;
+        if (a < b)
+            std::swap(a, b);
+        if ((*parents)[a].testAndSetOrdered(a, b))
+            return;
+    }
+}
+
+
+//Each positive node is joined to the positive version of each node it shares
+//an edge with.
+static void uniteNodeRange(ComponentUnionRange & range)
+{
+    const NodeAttributes * attributes = range.attributes;
+    for (int i = range.begin; i < range.end; ++i)
+    {
+        if (!attributes->m_positive[i])
+            continue;
+        DeBruijnNode * node = attributes->m_nodes[i];
+        const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+        for (size_t j = 0; j < edges->size(); ++j)
+        {
+            DeBruijnNode * otherNode = (*edges)[j]->getOtherNode(node);
+            if (otherNode->isNegativeNode())
+                otherNode = otherNode->getReverseComplement();
+            unite(range.parents, i, otherNode->getId());
+        }
+    }
+}
+
+
+
+GraphComponents::GraphComponents() :
+    m_built(false)
+{
+}
+
+
+void GraphComponents::clear()
+{
+    m_built = false;
+    m_nodeComponents.clear();
+    m_components.clear();
+    m_componentNodes.clear();
+    m_componentStarts.clear();
+}
+
+
+void GraphComponents::build(const NodeAttributes * attributes, bool parallel)
+{
+    clear();
+    int idCount = attributes->size();
+
+    std::vector<QAtomicInt> parents(idCount);
+    for (int i = 0; i < idCount; ++i)
+        parents[i].store(i);
+
+    int rangeCount = 1;
+    if (parallel)
+        rangeCount = std::max(1, std::min(QThread::idealThreadCount(), idCount / 1000));
+    std::vector<ComponentUnionRange> ranges(rangeCount);
+    for (int i = 0; i < rangeCount; ++i)
+    {
+        ranges[i].attributes = attributes;
+        ranges[i].parents = &parents;
+        ranges[i].begin = int((long long)(idCount) * i / rangeCount);
+        ranges[i].end = int((long long)(idCount) * (i + 1) / rangeCount);
+    }
+    if (rangeCount > 1)
+        QtConcurrent::blockingMap(ranges, uniteNodeRange);
+    else
+        uniteNodeRange(ranges[0]);
+
+    //Number the components and build their summaries.  Depths are averaged
+    //the same way as AssemblyGraph::getMeanDepth: weighted by length, unless
+    //all of the nodes have no length.
+    std::vector<int> rootComponents(idCount, -1);
+    std::vector<long double> depthSums;
+    std::vector<long double> lengthWeightedDepthSums;
+    m_nodeComponents.assign(idCount, -1);
+    for (int i = 0; i < idCount; ++i)
+    {
+        if (!attributes->m_positive[i])
+            continue;
+        int root = findRoot(&parents, i);
+        if (rootComponents[root] < 0)
+        {
+            rootComponents[root] = int(m_components.size());
+            GraphComponent component;
+            component.nodeCount = 0;
+            component.totalLength = 0;
+            component.minDepth = std::numeric_limits<double>::max();
+            component.maxDepth = 0.0;
+            component.meanDepth = 0.0;
+            component.circular = true;
+            m_components.push_back(component);
+            depthSums.push_back(0.0);
+            lengthWeightedDepthSums.push_back(0.0);
+        }
+        int componentId = rootComponents[root];
+        m_nodeComponents[i] = componentId;
+
+        GraphComponent & component = m_components[componentId];
+        double depth = attributes->m_depths[i];
+        int length = attributes->m_lengths[i];
+        ++component.nodeCount;
+        component.totalLength += length;
+        component.minDepth = std::min(component.minDepth, depth);
+        component.maxDepth = std::max(component.maxDepth, depth);
+        depthSums[componentId] += depth;
+        lengthWeightedDepthSums[componentId] += (long double)(length) * depth;
+
+        //A component is circular if it is a single loop: each node has
+        //exactly one edge in and one edge out.
+        const std::vector<DeBruijnEdge *> * edges = attributes->m_nodes[i]->getEdgesPointer();
+        int enteringEdges = 0;
+        int leavingEdges = 0;
+        for (size_t j = 0; j < edges->size(); ++j)
+        {
+            if ((*edges)[j]->getEndingNode() == attributes->m_nodes[i])
+                ++enteringEdges;
+            if ((*edges)[j]->getStartingNode() == attributes->m_nodes[i])
+                ++leavingEdges;
+        }
+        if (enteringEdges != 1 || leavingEdges != 1)
+            component.circular = false;
+    }
+
+    for (size_t i = 0; i < m_components.size(); ++i)
+    {
+        GraphComponent & component = m_components[i];
+        if (component.totalLength > 0)
+            component.meanDepth = lengthWeightedDepthSums[i] / component.totalLength;
+        else
+            component.meanDepth = depthSums[i] / component.nodeCount;
+    }
+
+    //Negative nodes are in the same component as their positive partners.
+    for (int i = 0; i < idCount; ++i)
+    {
+        DeBruijnNode * node = attributes->m_nodes[i];
+        if (node != 0 && !attributes->m_positive[i])
+            m_nodeComponents[i] = m_nodeComponents[node->getReverseComplement()->getId()];
+    }
+
+    //Group the positive nodes by component with a counting sort, so each
+    //component's nodes are in ID order.
+    m_componentStarts.assign(m_components.size() + 1, 0);
+    for (size_t i = 0; i < m_components.size(); ++i)
+        m_componentStarts[i + 1] = m_componentStarts[i] + m_components[i].nodeCount;
+    m_componentNodes.resize(m_componentStarts.back());
+    std::vector<int> positions(m_componentStarts.begin(), m_componentStarts.end() - 1);
+    for (int i = 0; i < idCount; ++i)
+    {
+        if (attributes->m_positive[i])
+            m_componentNodes[positions[m_nodeComponents[i]]++] = attributes->m_nodes[i];
+    }
+
+    m_built = true;
+}
+
+
+//This function returns -1 if the node is not in the components (e.g. if it
+//was made after they were built).
+int GraphComponents::getComponentId(const DeBruijnNode * node) const
+{
+    int id = node->getId();
+    if (id < 0 || id >= int(m_nodeComponents.size()))
+        return -1;
+    return m_nodeComponents[id];
+}
+
+
+//This function returns the positive nodes in the component.
+std::vector<DeBruijnNode *> GraphComponents::getComponentNodes(int componentId) const
+{
+    return std::vector<DeBruijnNode *>(m_componentNodes.begin() + m_componentStarts[componentId],
+                                       m_componentNodes.begin() + m_componentStarts[componentId + 1]);
+}
+
+
+//This function returns the component with the largest total length, or -1 if
+//there are no components.  Ties go to the lower component ID.
+int GraphComponents::getLargestComponentId() const
+{
+    int largestComponentId = -1;
+    for (int i = 0; i < getComponentCount(); ++i)
+    {
+        if (largestComponentId < 0 || m_components[i].totalLength > m_components[largestComponentId].totalLength)
+            largestComponentId = i;
+    }
+    return largestComponentId;
+}
@@ -0,0 +1,72 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef GRAPHCOMPONENTS_H
+#define GRAPHCOMPONENTS_H
+
+#include <vector>
+
+class DeBruijnNode;
+class NodeAttributes;
+
+//A summary of one connected component.  Only positive nodes are counted, so
+//each complementary node pair counts once.
+struct GraphComponent
+{
+    int nodeCount;
+    long long totalLength;
+    double minDepth;
+    double maxDepth;
+    double meanDepth;
+    bool circular;
+};
+
+//This class finds the connected components of the graph with a union-find
+//over node IDs, which can be run in parallel.  Both nodes in a complementary
+//pair are in the same component.  Components are numbered in the order of
+//their lowest node ID.  The assembly graph keeps one of these and rebuilds it
+//after the graph changes.
+
+class GraphComponents
+{
+public:
+    GraphComponents();
+
+    void build(const NodeAttributes * attributes, bool parallel = false);
+    void clear();
+    bool isBuilt() const {return m_built;}
+
+    int getComponentCount() const {return int(m_components.size());}
+    int getComponentId(const DeBruijnNode * node) const;
+    const GraphComponent & getComponent(int componentId) const {return m_components[componentId];}
+    std::vector<DeBruijnNode *> getComponentNodes(int componentId) const;
+    int getLargestComponentId() const;
+
+private:
+    bool m_built;
+    std::vector<int> m_nodeComponents;
+    std::vector<GraphComponent> m_components;
+
+    //The positive nodes of each component are stored together, with the
+    //starts giving each component's position.
+    std::vector<DeBruijnNode *> m_componentNodes;
+    std::vector<int> m_componentStarts;
+};
+
+#endif // GRAPHCOMPONENTS_H
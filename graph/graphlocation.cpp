@@ -19,6 +19,7 @@
 #include "graphlocation.h"
 
 #include "debruijnnode.h"
+#include "debruijnedge.h"
 #include "assemblygraph.h"
 #include "../program/globals.h"
 
@@ -121,10 +122,10 @@ void GraphLocation::moveForward(int change)
 
     //If there aren't enough bases left, then we recursively try with the
     //next nodes.
-    std::vector<DeBruijnNode *> downstreamNodes = m_node->getDownstreamNodes();
-    for (size_t i = 0; i < downstreamNodes.size(); ++i)
+    DeBruijnEdgeRange leavingEdges = m_node->getLeavingEdgeRange();
+    for (size_t i = 0; i < leavingEdges.size(); ++i)
     {
-        DeBruijnNode * node = downstreamNodes[i];
+        DeBruijnNode * node = leavingEdges[i]->getEndingNode();
         GraphLocation nextNodeLocation = GraphLocation::startOfNode(node);
         nextNodeLocation.moveForward(change - basesLeftInNode - 1);
 
@@ -156,10 +157,10 @@ void GraphLocation::moveBackward(int change)
 
     //If there aren't enough bases left, then we recursively try with the
     //next nodes.
-    std::vector<DeBruijnNode *> upstreamNodes = m_node->getUpstreamNodes();
-    for (size_t i = 0; i < upstreamNodes.size(); ++i)
+    DeBruijnEdgeRange enteringEdges = m_node->getEnteringEdgeRange();
+    for (size_t i = 0; i < enteringEdges.size(); ++i)
     {
-        DeBruijnNode * node = upstreamNodes[i];
+        DeBruijnNode * node = enteringEdges[i]->getStartingNode();
         GraphLocation nextNodeLocation = GraphLocation::endOfNode(node);
         nextNodeLocation.moveBackward(change - basesLeftInNode - 1);
 
@@ -0,0 +1,319 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "graphstatistics.h"
+#include "assemblygraph.h"
+#include "debruijnnode.h"
+#include "debruijnedge.h"
+#include "nodeattributes.h"
+#include "graphcomponents.h"
+#include <QThread>
+#include <QtConcurrentMap>
+#include <QPair>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+//The results of the node pass for one range of node IDs.
+struct NodeRangeStatistics
+{
+    const NodeAttributes * attributes;
+    int begin;
+    int end;
+    int nodeCount;
+    int edgeCount;
+    int smallestOverlap;
+    int largestOverlap;
+    long long totalLength;
+    long long totalLengthNoOverlaps;
+    long long totalLengthOrphanedNodes;
+    int deadEnds;
+    std::vector<int> lengths;
+    std::vector<QPair<double, long long> > depthsAndLengths;
+    std::vector<int> lengthsWithoutTrailingOverlap;
+};
+
+
+//This function looks at each node in the range once.  Edges are counted from
+//their starting node, so each is counted once.  Everything else is only for
+//positive nodes.
+static void calculateNodeRangeStatistics(NodeRangeStatistics & range)
+{
+    range.nodeCount = 0;
+    range.edgeCount = 0;
+    range.smallestOverlap = std::numeric_limits<int>::max();
+    range.largestOverlap = 0;
+    range.totalLength = 0;
+    range.totalLengthNoOverlaps = 0;
+    range.totalLengthOrphanedNodes = 0;
+    range.deadEnds = 0;
+
+    const NodeAttributes * attributes = range.attributes;
+    for (int i = range.begin; i < range.end; ++i)
+    {
+        DeBruijnNode * node = attributes->m_nodes[i];
+        if (node == 0)
+            continue;
+
+        const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+        bool hasEnteringEdge = false;
+        bool hasLeavingEdge = false;
+        int maxOverlap = 0;
+        int maxLeavingOverlap = 0;
+        for (size_t j = 0; j < edges->size(); ++j)
+        {
+            DeBruijnEdge * edge = (*edges)[j];
+            int overlap = edge->getOverlap();
+            maxOverlap = std::max(maxOverlap, overlap);
+            if (edge->getEndingNode() == node)
+                hasEnteringEdge = true;
+            if (edge->getStartingNode() == node)
+            {
+                hasLeavingEdge = true;
+                maxLeavingOverlap = std::max(maxLeavingOverlap, overlap);
+                range.smallestOverlap = std::min(range.smallestOverlap, overlap);
+                range.largestOverlap = std::max(range.largestOverlap, overlap);
+                if (edge->isPositiveEdge())
+                    ++range.edgeCount;
+            }
+        }
+
+        if (!attributes->m_positive[i])
+            continue;
+
+        int length = attributes->m_lengths[i];
+        ++range.nodeCount;
+        range.totalLength += length;
+        range.totalLengthNoOverlaps += length - maxOverlap;
+        range.lengths.push_back(length);
+        range.depthsAndLengths.push_back(QPair<double, long long>(attributes->m_depths[i], length));
+        range.lengthsWithoutTrailingOverlap.push_back(std::max(0, length - maxLeavingOverlap));
+
+        if (edges->empty())
+        {
+            range.deadEnds += 2;
+            range.totalLengthOrphanedNodes += length;
+        }
+        else if (!hasEnteringEdge || !hasLeavingEdge)
+            range.deadEnds += 1;
+    }
+}
+
+
+//This function gives the same result as AssemblyGraph's
+//getValueUsingFractionalIndex on a sorted vector, but it only partially
+//orders the vector to find the two values needed.
+template<typename T> static double selectUsingFractionalIndex(std::vector<T> * v, double index)
+{
+    if (v->size() == 0)
+        return 0.0;
+    if (v->size() == 1)
+        return double((*v)[0]);
+
+    int wholePart = floor(index);
+    if (wholePart < 0)
+        wholePart = 0;
+    if (wholePart >= int(v->size()) - 1)
+    {
+        std::nth_element(v->begin(), v->end() - 1, v->end());
+        return double(v->back());
+    }
+
+    std::nth_element(v->begin(), v->begin() + wholePart, v->end());
+    double fractionalPart = std::max(0.0, index - wholePart);
+    double piece1 = double((*v)[wholePart]);
+    double piece2 = double(*std::min_element(v->begin() + wholePart + 1, v->end()));
+
+    return piece1 * (1.0 - fractionalPart) + piece2 * fractionalPart;
+}
+
+
+template<typename T> static bool compareFirst(const QPair<T, long long> & a, const QPair<T, long long> & b)
+{
+    return a.first < b.first;
+}
+
+
+//This function finds the value at the target index, where each item covers a
+//number of indices equal to its weight and the items are in order of value.
+//It uses repeated median partitioning, so it is linear time.  It returns 0 if
+//the index is past the total weight.
+template<typename T> static T selectByWeightedIndex(std::vector<QPair<T, long long> > * items,
+                                                    long long targetIndex)
+{
+    typedef typename std::vector<QPair<T, long long> >::iterator Iterator;
+    Iterator begin = items->begin();
+    Iterator end = items->end();
+    while (begin != end)
+    {
+        Iterator middle = begin + (end - begin) / 2;
+        std::nth_element(begin, middle, end, compareFirst<T>);
+        T pivot = middle->first;
+
+        Iterator lessEnd = begin, equalEnd;
+        long long lessWeight = 0, equalWeight = 0;
+        for (Iterator i = begin; i != end; ++i)
+        {
+            if (i->first < pivot)
+            {
+                lessWeight += i->second;
+                std::iter_swap(i, lessEnd++);
+            }
+        }
+        equalEnd = lessEnd;
+        for (Iterator i = lessEnd; i != end; ++i)
+        {
+            if (!(pivot < i->first))
+            {
+                equalWeight += i->second;
+                std::iter_swap(i, equalEnd++);
+            }
+        }
+
+        if (targetIndex < lessWeight)
+            end = lessEnd;
+        else if (targetIndex < lessWeight + equalWeight)
+            return pivot;
+        else
+        {
+            targetIndex -= lessWeight + equalWeight;
+            begin = equalEnd;
+        }
+    }
+    return T(0);
+}
+
+
+GraphStatistics::GraphStatistics() :
+    m_nodeCount(0), m_edgeCount(0), m_smallestOverlap(0), m_largestOverlap(0),
+    m_totalLength(0), m_totalLengthNoOverlaps(0), m_deadEnds(0),
+    m_percentageDeadEnds(0.0), m_componentCount(0), m_largestComponentLength(0),
+    m_totalLengthOrphanedNodes(0), m_n50(0), m_shortestNode(0), m_firstQuartile(0),
+    m_median(0), m_thirdQuartile(0), m_longestNode(0), m_medianDepthByBase(0.0),
+    m_estimatedSequenceLength(0)
+{
+}
+
+
+void GraphStatistics::calculate(const AssemblyGraph * graph, bool parallel)
+{
+    *this = GraphStatistics();
+    const NodeAttributes * attributes = &graph->m_nodeAttributes;
+    int idCount = attributes->size();
+
+    //Split the IDs into ranges: one for each thread in parallel mode, or just
+    //one otherwise.
+    int rangeCount = 1;
+    if (parallel)
+        rangeCount = std::max(1, std::min(QThread::idealThreadCount(), idCount / 1000));
+    std::vector<NodeRangeStatistics> ranges(rangeCount);
+    for (int i = 0; i < rangeCount; ++i)
+    {
+        ranges[i].attributes = attributes;
+        ranges[i].begin = int((long long)(idCount) * i / rangeCount);
+        ranges[i].end = int((long long)(idCount) * (i + 1) / rangeCount);
+    }
+    if (rangeCount > 1)
+        QtConcurrent::blockingMap(ranges, calculateNodeRangeStatistics);
+    else
+        calculateNodeRangeStatistics(ranges[0]);
+
+    //Combine the ranges, in order.
+    std::vector<int> lengths;
+    std::vector<QPair<double, long long> > depthsAndLengths;
+    std::vector<int> lengthsWithoutTrailingOverlap;
+    int smallestOverlap = std::numeric_limits<int>::max();
+    for (int i = 0; i < rangeCount; ++i)
+    {
+        NodeRangeStatistics & range = ranges[i];
+        m_nodeCount += range.nodeCount;
+        m_edgeCount += range.edgeCount;
+        smallestOverlap = std::min(smallestOverlap, range.smallestOverlap);
+        m_largestOverlap = std::max(m_largestOverlap, range.largestOverlap);
+        m_totalLength += range.totalLength;
+        m_totalLengthNoOverlaps += range.totalLengthNoOverlaps;
+        m_totalLengthOrphanedNodes += range.totalLengthOrphanedNodes;
+        m_deadEnds += range.deadEnds;
+        lengths.insert(lengths.end(), range.lengths.begin(), range.lengths.end());
+        depthsAndLengths.insert(depthsAndLengths.end(), range.depthsAndLengths.begin(), range.depthsAndLengths.end());
+        lengthsWithoutTrailingOverlap.insert(lengthsWithoutTrailingOverlap.end(),
+                                             range.lengthsWithoutTrailingOverlap.begin(),
+                                             range.lengthsWithoutTrailingOverlap.end());
+        std::vector<int>().swap(range.lengths);
+        std::vector<QPair<double, long long> >().swap(range.depthsAndLengths);
+    }
+    if (smallestOverlap != std::numeric_limits<int>::max())
+        m_smallestOverlap = smallestOverlap;
+    if (m_nodeCount > 0)
+        m_percentageDeadEnds = 100.0 * double(m_deadEnds) / (2 * m_nodeCount);
+
+    const GraphComponents * components = graph->getComponents();
+    m_componentCount = components->getComponentCount();
+    int largestComponentId = components->getLargestComponentId();
+    if (largestComponentId >= 0)
+        m_largestComponentLength = components->getComponent(largestComponentId).totalLength;
+
+    if (m_totalLength == 0 || lengths.empty())
+        return;
+
+    //Node length statistics.
+    m_shortestNode = *std::min_element(lengths.begin(), lengths.end());
+    m_longestNode = *std::max_element(lengths.begin(), lengths.end());
+    double firstQuartileIndex = (lengths.size() - 1) / 4.0;
+    double medianIndex = (lengths.size() - 1) / 2.0;
+    double thirdQuartileIndex = (lengths.size() - 1) * 3.0 / 4.0;
+    m_firstQuartile = round(selectUsingFractionalIndex(&lengths, firstQuartileIndex));
+    m_median = round(selectUsingFractionalIndex(&lengths, medianIndex));
+    m_thirdQuartile = round(selectUsingFractionalIndex(&lengths, thirdQuartileIndex));
+
+    //The N50 node covers the base at this index when the nodes are ordered
+    //from shortest to longest.
+    std::vector<QPair<int, long long> > lengthsAndWeights(lengths.size());
+    for (size_t i = 0; i < lengths.size(); ++i)
+        lengthsAndWeights[i] = QPair<int, long long>(lengths[i], lengths[i]);
+    std::vector<int>().swap(lengths);
+    long long halfTotalLength = (m_totalLength + 1) / 2;
+    m_n50 = selectByWeightedIndex(&lengthsAndWeights, m_totalLength - halfTotalLength);
+    std::vector<QPair<int, long long> >().swap(lengthsAndWeights);
+
+    //Median depth by base.  The depths are needed in node order for the
+    //estimated sequence length, so a copy is used for the selection.
+    std::vector<QPair<double, long long> > depthSelection(depthsAndLengths);
+    if (depthSelection.size() == 1)
+        m_medianDepthByBase = depthSelection[0].first;
+    else if (m_totalLength % 2 == 0)
+    {
+        double depth1 = selectByWeightedIndex(&depthSelection, m_totalLength / 2 - 1);
+        double depth2 = selectByWeightedIndex(&depthSelection, m_totalLength / 2);
+        m_medianDepthByBase = (depth1 + depth2) / 2.0;
+    }
+    else
+        m_medianDepthByBase = selectByWeightedIndex(&depthSelection, (m_totalLength - 1) / 2);
+    std::vector<QPair<double, long long> >().swap(depthSelection);
+
+    if (m_medianDepthByBase == 0.0)
+        return;
+    for (size_t i = 0; i < depthsAndLengths.size(); ++i)
+    {
+        double relativeDepth = depthsAndLengths[i].first / m_medianDepthByBase;
+        int closestIntegerDepth = round(relativeDepth);
+        m_estimatedSequenceLength += lengthsWithoutTrailingOverlap[i] * closestIntegerDepth;
+    }
+}
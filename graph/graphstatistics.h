@@ -0,0 +1,61 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef GRAPHSTATISTICS_H
+#define GRAPHSTATISTICS_H
+
+class AssemblyGraph;
+
+//This class calculates all of the statistics shown by Bandage info and the
+//graph information dialog together.  The nodes are visited once (by ID, using
+//the graph's node attribute columns) to collect the counts, lengths and
+//overlaps.  Connected components come from the graph's component index.
+//Quartiles and medians are found by selection instead of sorting.  In
+//parallel mode, the node pass is split into ranges of IDs which are done in
+//separate threads.
+
+class GraphStatistics
+{
+public:
+    GraphStatistics();
+
+    void calculate(const AssemblyGraph * graph, bool parallel = false);
+
+    int m_nodeCount;
+    int m_edgeCount;
+    int m_smallestOverlap;
+    int m_largestOverlap;
+    long long m_totalLength;
+    long long m_totalLengthNoOverlaps;
+    int m_deadEnds;
+    double m_percentageDeadEnds;
+    int m_componentCount;
+    long long m_largestComponentLength;
+    long long m_totalLengthOrphanedNodes;
+    int m_n50;
+    int m_shortestNode;
+    int m_firstQuartile;
+    int m_median;
+    int m_thirdQuartile;
+    int m_longestNode;
+    double m_medianDepthByBase;
+    long long m_estimatedSequenceLength;
+};
+
+#endif // GRAPHSTATISTICS_H
@@ -0,0 +1,99 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "nodeattributes.h"
+#include "debruijnnode.h"
+
+int NodeAttributes::addNode(DeBruijnNode * node, double depth, int length, bool positive)
+{
+    m_nodes.push_back(node);
+    m_depths.push_back(depth);
+    m_relativeDepths.push_back(1.0);
+    m_lengths.push_back(length);
+    m_drawn.push_back(false);
+    m_positive.push_back(positive);
+    ++m_changeCount;
+    return int(m_nodes.size()) - 1;
+}
+
+
+//The removed node's attributes are zeroed so passes over the columns don't
+//need to check for deleted nodes.
+void NodeAttributes::removeNode(int id)
+{
+    if (id < 0 || id >= size() || m_nodes[id] == 0)
+        return;
+    m_nodes[id] = 0;
+    m_depths[id] = 0.0;
+    m_relativeDepths[id] = 0.0;
+    m_lengths[id] = 0;
+    m_drawn[id] = false;
+    m_positive[id] = false;
+    ++m_emptyCount;
+    ++m_changeCount;
+}
+
+
+void NodeAttributes::clear()
+{
+    m_nodes.clear();
+    m_depths.clear();
+    m_relativeDepths.clear();
+    m_lengths.clear();
+    m_drawn.clear();
+    m_positive.clear();
+    m_emptyCount = 0;
+    ++m_changeCount;
+}
+
+
+//This function removes the empty IDs left by deleted nodes, giving the
+//remaining nodes new IDs in the same order.
+void NodeAttributes::compact()
+{
+    int newSize = 0;
+    for (int i = 0; i < size(); ++i)
+    {
+        if (m_nodes[i] == 0)
+            continue;
+        m_nodes[newSize] = m_nodes[i];
+        m_depths[newSize] = m_depths[i];
+        m_relativeDepths[newSize] = m_relativeDepths[i];
+        m_lengths[newSize] = m_lengths[i];
+        m_drawn[newSize] = m_drawn[i];
+        m_positive[newSize] = m_positive[i];
+        m_nodes[newSize]->setId(newSize);
+        ++newSize;
+    }
+    m_nodes.resize(newSize);
+    m_depths.resize(newSize);
+    m_relativeDepths.resize(newSize);
+    m_lengths.resize(newSize);
+    m_drawn.resize(newSize);
+    m_positive.resize(newSize);
+    m_emptyCount = 0;
+    ++m_changeCount;
+}
+
+
+void NodeAttributes::compactIfSparse()
+{
+    if (m_emptyCount > size() / 2)
+        compact();
+}
@@ -0,0 +1,67 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef NODEATTRIBUTES_H
+#define NODEATTRIBUTES_H
+
+#include <vector>
+
+class DeBruijnNode;
+
+//This class holds the node attributes used by whole-graph passes (depth,
+//length and drawn status) in contiguous columns indexed by node ID, so those
+//passes are simple loops over arrays instead of walks through the node map.
+//Each node is given its ID when it is made and reads its attributes from
+//here.  IDs of deleted nodes are left empty (no node, zero length) until the
+//table is compacted, which renumbers the remaining nodes.  Compacting costs a
+//pass over the whole table, so after deletions it is only done once the empty
+//IDs outnumber the used ones.
+//
+//The table also counts changes to the set of nodes (additions, removals,
+//renames and renumbering), so anything built from the node names or IDs can
+//tell when it is out of date.
+
+class NodeAttributes
+{
+public:
+    NodeAttributes() : m_emptyCount(0), m_changeCount(0) {}
+
+    int addNode(DeBruijnNode * node, double depth, int length, bool positive);
+    void removeNode(int id);
+    void clear();
+    void compact();
+    void compactIfSparse();
+    int size() const {return int(m_nodes.size());}
+    int getEmptyCount() const {return m_emptyCount;}
+    long long getChangeCount() const {return m_changeCount;}
+    void nodeRenamed() {++m_changeCount;}
+
+    std::vector<DeBruijnNode *> m_nodes;
+    std::vector<double> m_depths;
+    std::vector<double> m_relativeDepths;
+    std::vector<int> m_lengths;
+    std::vector<char> m_drawn;
+    std::vector<char> m_positive;
+
+private:
+    int m_emptyCount;
+    long long m_changeCount;
+};
+
+#endif // NODEATTRIBUTES_H
@@ -0,0 +1,210 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "nodenameindex.h"
+#include "debruijnnode.h"
+#include "nodeattributes.h"
+#include <QMapIterator>
+#include <algorithm>
+#include <iterator>
+
+
+void NodeNameIndex::build(const QMap<QString, DeBruijnNode *> & nodes, const NodeAttributes & attributes)
+{
+    clear();
+
+    //Each positive node makes an entry for its pair.  A node without a
+    //positive partner makes an entry with its whole name.
+    m_entryStarts.push_back(0);
+    QMapIterator<QString, DeBruijnNode*> i(nodes);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = i.value();
+        DeBruijnNode * revCompNode = node->getReverseComplement();
+        QString name;
+        if (node->isPositiveNode())
+            name = node->getNameWithoutSign();
+        else if (revCompNode == 0 || !revCompNode->isPositiveNode())
+            name = node->getName();
+        else
+            continue;
+        m_entryNodes.push_back(node->getId());
+        m_names += name.toUtf8();
+        m_entryStarts.push_back(m_names.length());
+    }
+    int entryCount = int(m_entryNodes.size());
+
+    //There is about one bucket for every four name characters.
+    m_bucketBits = 10;
+    while (m_bucketBits < 22 && (1 << m_bucketBits) < m_names.length() / 4)
+        ++m_bucketBits;
+    int bucketCount = 1 << m_bucketBits;
+
+    //The buckets are filled with two passes over the names: one to count
+    //each bucket's entries and one to fill them in.
+    const char * names = m_names.constData();
+    m_bucketStarts.assign(bucketCount + 1, 0);
+    std::vector<int> lastEntry(bucketCount, -1);
+    for (int entry = 0; entry < entryCount; ++entry)
+    {
+        for (int j = m_entryStarts[entry]; j + 3 <= m_entryStarts[entry + 1]; ++j)
+        {
+            int bucket = getBucket(names + j);
+            if (lastEntry[bucket] != entry)
+            {
+                lastEntry[bucket] = entry;
+                ++m_bucketStarts[bucket + 1];
+            }
+        }
+    }
+    for (int bucket = 0; bucket < bucketCount; ++bucket)
+        m_bucketStarts[bucket + 1] += m_bucketStarts[bucket];
+
+    m_bucketEntries.resize(m_bucketStarts[bucketCount]);
+    std::vector<int> nextPosition(m_bucketStarts.begin(), m_bucketStarts.end() - 1);
+    lastEntry.assign(bucketCount, -1);
+    for (int entry = 0; entry < entryCount; ++entry)
+    {
+        for (int j = m_entryStarts[entry]; j + 3 <= m_entryStarts[entry + 1]; ++j)
+        {
+            int bucket = getBucket(names + j);
+            if (lastEntry[bucket] != entry)
+            {
+                lastEntry[bucket] = entry;
+                m_bucketEntries[nextPosition[bucket]++] = entry;
+            }
+        }
+    }
+
+    m_changeCount = attributes.getChangeCount();
+}
+
+
+void NodeNameIndex::clear()
+{
+    m_entryNodes.clear();
+    m_entryStarts.clear();
+    m_names.clear();
+    m_bucketBits = 0;
+    m_bucketStarts.clear();
+    m_bucketEntries.clear();
+    m_changeCount = -1;
+}
+
+
+bool NodeNameIndex::isUpToDate(const NodeAttributes & attributes) const
+{
+    return m_changeCount == attributes.getChangeCount();
+}
+
+
+int NodeNameIndex::getBucket(const char * trigram) const
+{
+    unsigned int key = (unsigned char)(trigram[0]) << 16 |
+                       (unsigned char)(trigram[1]) << 8 |
+                       (unsigned char)(trigram[2]);
+    return int((key * 2654435761u) >> (32 - m_bucketBits));
+}
+
+
+bool NodeNameIndex::entryContains(int entry, const QByteArray & text) const
+{
+    const char * nameBegin = m_names.constData() + m_entryStarts[entry];
+    const char * nameEnd = m_names.constData() + m_entryStarts[entry + 1];
+    return std::search(nameBegin, nameEnd, text.constData(), text.constData() + text.length()) != nameEnd;
+}
+
+
+//The candidates for text of three or more characters are the entries in
+//all of its trigrams' buckets, found by intersecting the buckets' lists
+//(which are in order), smallest first.
+std::vector<int> NodeNameIndex::findCandidateEntries(const QByteArray & text) const
+{
+    std::vector<int> candidates;
+    int entryCount = int(m_entryNodes.size());
+    if (text.length() < 3)
+    {
+        for (int entry = 0; entry < entryCount; ++entry)
+        {
+            if (entryContains(entry, text))
+                candidates.push_back(entry);
+        }
+        return candidates;
+    }
+
+    std::vector<std::pair<int, int> > buckets;
+    for (int j = 0; j + 3 <= text.length(); ++j)
+    {
+        int bucket = getBucket(text.constData() + j);
+        buckets.push_back(std::make_pair(m_bucketStarts[bucket + 1] - m_bucketStarts[bucket], bucket));
+    }
+    std::sort(buckets.begin(), buckets.end());
+    buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+
+    const int * bucketEntries = m_bucketEntries.data();
+    candidates.assign(bucketEntries + m_bucketStarts[buckets[0].second],
+                      bucketEntries + m_bucketStarts[buckets[0].second + 1]);
+    std::vector<int> intersection;
+    for (size_t j = 1; j < buckets.size() && !candidates.empty(); ++j)
+    {
+        intersection.clear();
+        std::set_intersection(candidates.begin(), candidates.end(),
+                              bucketEntries + m_bucketStarts[buckets[j].second],
+                              bucketEntries + m_bucketStarts[buckets[j].second + 1],
+                              std::back_inserter(intersection));
+        candidates.swap(intersection);
+    }
+
+    //Trigrams can share a bucket and needn't be in the right order, so the
+    //candidates are checked against the whole text.
+    std::vector<int> entries;
+    for (size_t j = 0; j < candidates.size(); ++j)
+    {
+        if (entryContains(candidates[j], text))
+            entries.push_back(candidates[j]);
+    }
+    return entries;
+}
+
+
+//This function gives the nodes whose names contain the text, in the same
+//order as the graph's node map (i.e. sorted by name).
+std::vector<DeBruijnNode *> NodeNameIndex::findNodesContaining(const QString & text,
+                                                               const NodeAttributes & attributes) const
+{
+    QString entryText = text;
+    if (entryText.endsWith('+') || entryText.endsWith('-'))
+        entryText.chop(1);
+    std::vector<int> entries = findCandidateEntries(entryText.toUtf8());
+
+    std::vector<DeBruijnNode *> nodes;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        DeBruijnNode * node = attributes.m_nodes[m_entryNodes[entries[i]]];
+        if (node->getName().contains(text))
+            nodes.push_back(node);
+        DeBruijnNode * revCompNode = node->getReverseComplement();
+        if (node->isPositiveNode() && revCompNode != 0 && revCompNode != node &&
+                revCompNode->getName().contains(text))
+            nodes.push_back(revCompNode);
+    }
+    std::sort(nodes.begin(), nodes.end(),
+              [](DeBruijnNode * a, DeBruijnNode * b) {return a->getName() < b->getName();});
+    return nodes;
+}
@@ -0,0 +1,77 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef NODENAMEINDEX_H
+#define NODENAMEINDEX_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMap>
+#include <vector>
+
+class DeBruijnNode;
+class NodeAttributes;
+
+//This class finds the nodes whose names contain a piece of text, without
+//looking at every node name.  It is a trigram index: each node name is
+//listed under every three-character piece it contains, so a search only has
+//to look at the names which contain all of the search text's pieces.  Those
+//names are then checked in full, so the results are exactly the nodes whose
+//name contains the text.
+//
+//There is one entry per complementary pair, made from the positive node's
+//name without its sign, as any text found in either node's name (once a
+//trailing +/- is removed from the text) is also in that.  Text shorter than
+//three characters is looked for in all of the names, which are stored back
+//to back so that is still a quick scan.
+//
+//The index is built when needed and records the NodeAttributes change
+//count, so it can tell when nodes have been added, removed or renamed.
+
+class NodeNameIndex
+{
+public:
+    NodeNameIndex() : m_bucketBits(0), m_changeCount(-1) {}
+
+    void build(const QMap<QString, DeBruijnNode *> & nodes, const NodeAttributes & attributes);
+    void clear();
+    bool isUpToDate(const NodeAttributes & attributes) const;
+    std::vector<DeBruijnNode *> findNodesContaining(const QString & text,
+                                                    const NodeAttributes & attributes) const;
+
+private:
+    //The node ID and name of each entry.  The name of entry i is at
+    //[m_entryStarts[i], m_entryStarts[i+1]) in m_names.
+    std::vector<int> m_entryNodes;
+    std::vector<int> m_entryStarts;
+    QByteArray m_names;
+
+    //Trigrams are hashed into buckets.  The entries in bucket i (each once,
+    //in order) are at [m_bucketStarts[i], m_bucketStarts[i+1]).
+    int m_bucketBits;
+    std::vector<int> m_bucketStarts;
+    std::vector<int> m_bucketEntries;
+
+    long long m_changeCount;
+
+    int getBucket(const char * trigram) const;
+    bool entryContains(int entry, const QByteArray & text) const;
+    std::vector<int> findCandidateEntries(const QByteArray & text) const;
+};
+
+#endif // NODENAMEINDEX_H
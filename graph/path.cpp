@@ -21,11 +21,15 @@
 #include "debruijnedge.h"
 #include "../blast/blasthit.h"
 #include "../blast/blastquery.h"
-#include <QRegularExpression>
+#include <QtConcurrentMap>
 #include "assemblygraph.h"
+#include "../program/compressedfile.h"
 #include <QStringList>
-#include <QApplication>
 #include <limits>
+#include <QHash>
+#include <queue>
+#include <algorithm>
+#include <cstdlib>
 
 
 
@@ -81,11 +85,11 @@ Path Path::makeFromOrderedNodes(QList<DeBruijnNode *> nodes, bool circular)
         DeBruijnNode * node2 = path.m_nodes[secondNodeIndex];
 
         bool foundEdge = false;
-        const std::vector<DeBruijnEdge *> * edges = node1->getEdgesPointer();
-        for (size_t j = 0; j < edges->size(); ++j)
+        DeBruijnEdgeRange edges = node1->getLeavingEdgeRange();
+        for (size_t j = 0; j < edges.size(); ++j)
         {
-            DeBruijnEdge * edge = (*edges)[j];
-            if (edge->getStartingNode() == node1 && edge->getEndingNode() == node2)
+            DeBruijnEdge * edge = edges[j];
+            if (edge->getEndingNode() == node2)
             {
                 path.m_edges.push_back(edge);
                 foundEdge = true;
@@ -118,59 +122,122 @@ Path Path::makeFromOrderedNodes(QList<DeBruijnNode *> nodes, bool circular)
 Path Path::makeFromString(QString pathString, bool circular,
                           QString * pathStringFailure)
 {
-    Path path;
+    return makeFromString(pathString, circular, pathStringFailure, 0);
+}
+
+
+//This function reads a position in brackets, e.g. "(123)", starting at i.
+//It returns the index after the closing bracket, or -1 if there isn't a
+//position there.
+static int readPathPosition(const QChar * chars, int i, int end)
+{
+    if (i >= end || chars[i] != '(')
+        return -1;
+    int digitsStart = ++i;
+    while (i < end && chars[i] >= '0' && chars[i] <= '9')
+        ++i;
+    if (i == digitsStart || i >= end || chars[i] != ')')
+        return -1;
+    return i + 1;
+}
 
-    QRegularExpression re("^(?:\\(([0-9]+)\\) ?)*((?:[^,]+[-\\+], ?)*[^,]+[-\\+])(?: ?\\(([0-9]+)\\))*$");
-    QRegularExpressionMatch match = re.match(pathString);
 
-    //If the string failed to match the regex, return an empty path.
-    if (!match.hasMatch())
+//A path string is a comma-separated list of node names, each ending in + or
+//-, with optional start and end positions in brackets:
+//  (1996) 9+, 13+ (5)
+//The string is checked and the node names are looked up in one pass.  Names
+//are found with nodeIndex if it is given, or the graph's node map if not.
+Path Path::makeFromString(const QString & pathString, bool circular,
+                          QString * pathStringFailure,
+                          const QHash<QString, DeBruijnNode *> * nodeIndex)
+{
+    Path path;
+    const QChar * chars = pathString.constData();
+    int begin = 0;
+    int end = pathString.length();
+
+    //Find the start position.  If there is more than one, the last is used.
+    int startPosBegin = -1, startPosEnd = -1;
+    int positionEnd;
+    while ((positionEnd = readPathPosition(chars, begin, end)) >= 0)
     {
-        *pathStringFailure = "the text is not formatted correctly";
-        return path;
+        startPosBegin = begin + 1;
+        startPosEnd = positionEnd - 1;
+        begin = positionEnd;
+        if (begin < end && chars[begin] == ' ')
+            ++begin;
     }
 
-    QString startPosString = match.captured(1);
-    QString nodeListString = match.captured(2);
-    QString endPosString = match.captured(3);
-
-    //Circular paths cannot have start and end positions.
-    if (circular && (startPosString != "" || endPosString != ""))
+    //Find the end position, working back from the end of the string.  If
+    //there is more than one, the last is used.
+    int endPosBegin = -1, endPosEnd = -1;
+    while (end > begin && chars[end - 1] == ')')
     {
-        *pathStringFailure = "circular paths cannot contain start or end positions";
-        return path;
+        int open = end - 2;
+        while (open >= begin && chars[open] >= '0' && chars[open] <= '9')
+            --open;
+        if (open < begin || chars[open] != '(' || open == end - 2)
+            break;
+        if (endPosBegin < 0)
+        {
+            endPosBegin = open + 1;
+            endPosEnd = end - 1;
+        }
+        end = open;
+        if (end > begin && chars[end - 1] == ' ')
+            --end;
     }
 
-    //Make sure there is at least one proposed node name listed.
-    QStringList nodeNameList = nodeListString.simplified().split(",", QString::SkipEmptyParts);
-    if (nodeNameList.empty())
+    //Each node name needs at least one character before its +/-.  Node
+    //names which aren't in the graph are gathered so they can all be given
+    //in the failure message.
+    QList<DeBruijnNode *> nodesInGraph;
+    QString nodesNotInGraph;
+    if (begin >= end || chars[end - 1] == ',')
     {
         *pathStringFailure = "the text is not formatted correctly";
         return path;
     }
-
-    //Find which node names are and are not actually in the graph. 
-    QList<DeBruijnNode *> nodesInGraph;
-    QStringList nodesNotInGraph;
-    for (int i = 0; i < nodeNameList.size(); ++i)
+    for (int nameBegin = begin; nameBegin < end; )
     {
-        QString nodeName = nodeNameList[i].simplified();
-        if (g_assemblyGraph->m_deBruijnGraphNodes.contains(nodeName))
-            nodesInGraph.push_back(g_assemblyGraph->m_deBruijnGraphNodes[nodeName]);
+        int nameEnd = nameBegin;
+        while (nameEnd < end && chars[nameEnd] != ',')
+            ++nameEnd;
+        if (nameEnd - nameBegin < 2 || (chars[nameEnd - 1] != '+' && chars[nameEnd - 1] != '-'))
+        {
+            *pathStringFailure = "the text is not formatted correctly";
+            return path;
+        }
+
+        QString nodeName = QString(chars + nameBegin, nameEnd - nameBegin).simplified();
+        DeBruijnNode * node = 0;
+        if (nodeIndex != 0)
+            node = nodeIndex->value(nodeName, 0);
         else
-            nodesNotInGraph.push_back(nodeName);
+            node = g_assemblyGraph->m_deBruijnGraphNodes.value(nodeName, 0);
+        if (node != 0)
+            nodesInGraph.push_back(node);
+        else
+        {
+            if (!nodesNotInGraph.isEmpty())
+                nodesNotInGraph += ", ";
+            nodesNotInGraph += nodeName;
+        }
+
+        nameBegin = nameEnd + 1;
+    }
+
+    //Circular paths cannot have start and end positions.
+    if (circular && (startPosBegin >= 0 || endPosBegin >= 0))
+    {
+        *pathStringFailure = "circular paths cannot contain start or end positions";
+        return path;
     }
 
     //If the path contains nodes not in the graph, we fail.
-    if (nodesNotInGraph.size() > 0)
+    if (!nodesNotInGraph.isEmpty())
     {
-        *pathStringFailure = "the following nodes are not in the graph: ";
-        for (int i = 0; i < nodesNotInGraph.size(); ++i)
-        {
-            *pathStringFailure += nodesNotInGraph[i];
-            if (i != nodesNotInGraph.size() - 1)
-                *pathStringFailure += ", ";
-        }
+        *pathStringFailure = "the following nodes are not in the graph: " + nodesNotInGraph;
         return path;
     }
 
@@ -194,9 +261,9 @@ Path Path::makeFromString(QString pathString, bool circular,
     DeBruijnNode * firstNode = path.m_nodes.front();
     DeBruijnNode * lastNode = path.m_nodes.back();
 
-    if (startPosString.length() > 0)
+    if (startPosBegin >= 0)
     {
-        int startPos = startPosString.toInt();
+        int startPos = pathString.mid(startPosBegin, startPosEnd - startPosBegin).toInt();
         if (startPos < 1 || startPos > firstNode->getLength())
         {
             *pathStringFailure = "starting node position not valid";
@@ -209,9 +276,9 @@ Path Path::makeFromString(QString pathString, bool circular,
         path.m_startLocation = GraphLocation::startOfNode(firstNode);
 
 
-    if (endPosString.length() > 0)
+    if (endPosBegin >= 0)
     {
-        int endPos = endPosString.toInt();
+        int endPos = pathString.mid(endPosBegin, endPosEnd - endPosBegin).toInt();
         if (endPos < 1 || endPos > lastNode->getLength())
         {
             *pathStringFailure = "ending node position not valid";
@@ -227,6 +294,124 @@ Path Path::makeFromString(QString pathString, bool circular,
 }
 
 
+//One path string for makeFromStrings, which can be made in a separate
+//thread.
+struct PathStringJob
+{
+    QString pathString;
+    bool circular;
+    const QHash<QString, DeBruijnNode *> * nodeIndex;
+    Path path;
+    QString failure;
+};
+
+static void makePathFromStringJob(PathStringJob & job)
+{
+    job.path = Path::makeFromString(job.pathString, job.circular, &job.failure, job.nodeIndex);
+}
+
+
+//This function makes many paths at once.  The node names are put in a hash
+//once for all of the paths, and the paths are made in parallel.  Each path's
+//failure message (empty if it succeeded) is put in pathStringFailures.
+QList<Path> Path::makeFromStrings(const QStringList & pathStrings, bool circular,
+                                  QStringList * pathStringFailures)
+{
+    QHash<QString, DeBruijnNode *> nodeIndex;
+    nodeIndex.reserve(g_assemblyGraph->m_deBruijnGraphNodes.size());
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        nodeIndex.insert(i.key(), i.value());
+    }
+
+    std::vector<PathStringJob> jobs(pathStrings.size());
+    for (int j = 0; j < pathStrings.size(); ++j)
+    {
+        jobs[j].pathString = pathStrings[j];
+        jobs[j].circular = circular;
+        jobs[j].nodeIndex = &nodeIndex;
+    }
+    QtConcurrent::blockingMap(jobs, makePathFromStringJob);
+
+    QList<Path> paths;
+    paths.reserve(pathStrings.size());
+    pathStringFailures->clear();
+    for (size_t j = 0; j < jobs.size(); ++j)
+    {
+        paths.push_back(jobs[j].path);
+        pathStringFailures->push_back(jobs[j].failure);
+    }
+    return paths;
+}
+
+
+//This function makes a path from each line of a file.  Blank lines and lines
+//starting with '#' are skipped, and a line ending in "(circular)" gives a
+//circular path.  The file's path strings and their failure messages (empty
+//for those which succeeded) are given too, in the same order as the paths.
+//It returns false if the file couldn't be read.
+bool Path::loadFromFile(QString filename, QList<Path> * paths, QStringList * pathStrings,
+                        QStringList * pathStringFailures)
+{
+    CompressedFile inputFile(filename);
+    if (!inputFile.open(QIODevice::ReadOnly))
+        return false;
+
+    QStringList linearPathStrings, circularPathStrings;
+    QList<int> linearIndices, circularIndices;
+    pathStrings->clear();
+    while (!inputFile.atEnd())
+    {
+        QString line = QString::fromUtf8(AssemblyGraph::removeLineEnding(inputFile.readLine())).trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        if (line.endsWith("(circular)"))
+        {
+            line.chop(10);
+            line = line.trimmed();
+            circularIndices.push_back(pathStrings->size());
+            circularPathStrings.push_back(line);
+        }
+        else
+        {
+            linearIndices.push_back(pathStrings->size());
+            linearPathStrings.push_back(line);
+        }
+        pathStrings->push_back(line);
+    }
+    if (inputFile.hasError())
+        return false;
+
+    //The linear and circular paths are made in two batches and then put back
+    //in the file's order.
+    QStringList linearFailures, circularFailures;
+    QList<Path> linearPaths = makeFromStrings(linearPathStrings, false, &linearFailures);
+    QList<Path> circularPaths = makeFromStrings(circularPathStrings, true, &circularFailures);
+
+    paths->clear();
+    pathStringFailures->clear();
+    for (int i = 0; i < pathStrings->size(); ++i)
+    {
+        paths->push_back(Path());
+        pathStringFailures->push_back(QString());
+    }
+    for (int i = 0; i < linearIndices.size(); ++i)
+    {
+        (*paths)[linearIndices[i]] = linearPaths[i];
+        (*pathStringFailures)[linearIndices[i]] = linearFailures[i];
+    }
+    for (int i = 0; i < circularIndices.size(); ++i)
+    {
+        (*paths)[circularIndices[i]] = circularPaths[i];
+        (*pathStringFailures)[circularIndices[i]] = circularFailures[i];
+    }
+    return true;
+}
+
+
 
 void Path::buildUnambiguousPathFromNodes(QList<DeBruijnNode *> nodes,
                                          bool strandSpecific)
@@ -415,15 +600,14 @@ bool Path::checkForOtherEdges()
     for (int i = 0; i < m_nodes.size(); ++i)
     {
         DeBruijnNode * startingNode = m_nodes[i];
-        const std::vector<DeBruijnEdge *> * startingNodeEdges = startingNode->getEdgesPointer();
+        DeBruijnEdgeRange startingNodeEdges = startingNode->getLeavingEdgeRange();
         for (int j = 0; j < m_nodes.size(); ++j)
         {
             DeBruijnNode * endingNode = m_nodes[j];
-            for (size_t k = 0; k < startingNodeEdges->size(); ++k)
+            for (size_t k = 0; k < startingNodeEdges.size(); ++k)
             {
-                DeBruijnEdge * edge = (*startingNodeEdges)[k];
-                if (edge->getStartingNode() == startingNode &&
-                        edge->getEndingNode() == endingNode)
+                DeBruijnEdge * edge = startingNodeEdges[k];
+                if (edge->getEndingNode() == endingNode)
                     allConnectingEdges.push_back(edge);
             }
         }
@@ -439,65 +623,119 @@ bool Path::checkForOtherEdges()
 
 //This function extracts the sequence for the whole path.  It uses the overlap
 //value in the edges to remove sequences that are duplicated at the end of one
-//node and the start of the next.
-QByteArray Path::getPathSequence() const
+//node and the start of the next.  If lineLength is above zero, the sequence
+//is broken into lines of that length, as for a FASTA file, and it always ends
+//in a newline.
+//The part of each node to use is found first, so the sequence's length is
+//known and it is only allocated once.
+QByteArray Path::getPathSequence(int lineLength) const
 {
     if (m_nodes.empty())
-        return "";
+        return lineLength > 0 ? QByteArray("\n") : QByteArray("");
 
-    QByteArray sequence;
-    QByteArray firstNodeSequence = m_nodes[0]->getSequence();
-
-    //If the path is circular, we trim the overlap from the first node.
-    if (isCircular())
+    //Each node contributes some Ns (for a negative overlap) and then a part
+    //of its sequence.
+    std::vector<PathSequencePart> parts(m_nodes.size());
+    for (int i = 0; i < m_nodes.size(); ++i)
     {
-        int overlap = m_edges.back()->getOverlap();
-        if (overlap != 0)
-            firstNodeSequence = modifySequenceUsingOverlap(firstNodeSequence, overlap);
-        sequence += firstNodeSequence;
-    }
+        PathSequencePart & part = parts[i];
+        part.sequence = m_nodes[i]->getSequence();
+        part.nCount = 0;
+        part.start = 0;
+        part.length = part.sequence.length();
+
+        //If the path is linear, then we begin either with the entire first
+        //node sequence or part of it.  If the path is circular, we trim the
+        //overlap from the first node.
+        int overlap = 0;
+        if (i > 0)
+            overlap = m_edges[i-1]->getOverlap();
+        else if (isCircular())
+            overlap = m_edges.back()->getOverlap();
+        else
+        {
+            int rightChars = std::max(0, part.length - m_startLocation.getPosition() + 1);
+            if (rightChars < part.length)
+            {
+                part.start = part.length - rightChars;
+                part.length = rightChars;
+            }
+        }
 
-    //If the path is linear, then we begin either with the entire first node
-    //sequence or part of it.
-    else
-    {
-        int rightChars = firstNodeSequence.length() - m_startLocation.getPosition() + 1;
-        sequence += firstNodeSequence.right(rightChars);
+        //Positive overlaps are trimmed from the start of the node (unless the
+        //node is shorter than the overlap) and negative overlaps are filled
+        //with Ns.
+        if (overlap > 0 && overlap <= part.length)
+        {
+            part.start = overlap;
+            part.length -= overlap;
+        }
+        else if (overlap < 0)
+            part.nCount = -overlap;
     }
 
-    //The middle nodes are not affected by whether or not the path is circular
-    //or has partial node ends.
-    for (int i = 1; i < m_nodes.size(); ++i)
-    {
-        int overlap = m_edges[i-1]->getOverlap();
-        QByteArray nodeSequence = m_nodes[i]->getSequence();
-        if (overlap != 0)
-            nodeSequence = modifySequenceUsingOverlap(nodeSequence, overlap);
-        sequence += nodeSequence;
-    }
+    long long totalLength = 0;
+    for (size_t i = 0; i < parts.size(); ++i)
+        totalLength += parts[i].nCount + parts[i].length;
 
+    //The end of the last node past the end location is left off.
     DeBruijnNode * lastNode = m_nodes.back();
     int amountToTrimFromEnd = lastNode->getLength() - m_endLocation.getPosition();
-    sequence.chop(amountToTrimFromEnd);
+    if (amountToTrimFromEnd > 0)
+        totalLength = std::max(0LL, totalLength - amountToTrimFromEnd);
+
+    QByteArray sequence;
+    long long reserveLength = totalLength;
+    if (lineLength > 0)
+        reserveLength += totalLength / lineLength + 1;
+    sequence.reserve(int(reserveLength));
+
+    long long remaining = totalLength;
+    int lineRemaining = lineLength;
+    for (size_t i = 0; i < parts.size() && remaining > 0; ++i)
+    {
+        const PathSequencePart & part = parts[i];
+        int nCount = int(std::min((long long)part.nCount, remaining));
+        for (int j = 0; j < nCount; ++j)
+            appendToPathSequence(&sequence, "N", 1, lineLength, &lineRemaining);
+        remaining -= nCount;
+
+        int length = int(std::min((long long)part.length, remaining));
+        appendToPathSequence(&sequence, part.sequence.constData() + part.start, length,
+                             lineLength, &lineRemaining);
+        remaining -= length;
+    }
 
+    if (lineLength > 0 && (sequence.isEmpty() || lineRemaining < lineLength))
+        sequence += '\n';
     return sequence;
 }
 
 
-//This function will trim bases from the start of a sequence (in the case of
-//positive overlap) or add Ns to the start (in the case of negative overlap).
-QByteArray Path::modifySequenceUsingOverlap(QByteArray sequence, int overlap) const
+//This function appends bases to a path sequence.  If lineLength is above
+//zero, a newline is added after each full line, except at the very end.
+void Path::appendToPathSequence(QByteArray * sequence, const char * bases, int length,
+                                int lineLength, int * lineRemaining)
 {
-    if (overlap > 0)
+    if (lineLength <= 0)
     {
-        int rightChars = sequence.length() - overlap;
-        if (rightChars >= 0)
-            sequence = sequence.right(rightChars);
+        sequence->append(bases, length);
+        return;
     }
-    else if (overlap < 0)
-        sequence = QByteArray(-overlap, 'N') + sequence;
 
-    return sequence;
+    while (length > 0)
+    {
+        if (*lineRemaining == 0)
+        {
+            *sequence += '\n';
+            *lineRemaining = lineLength;
+        }
+        int count = std::min(length, *lineRemaining);
+        sequence->append(bases, count);
+        bases += count;
+        length -= count;
+        *lineRemaining -= count;
+    }
 }
 
 
@@ -528,19 +766,7 @@ QString Path::getFasta() const
         fasta += "(circular)";
     fasta += "\n";
 
-    QString pathSequence = getPathSequence();
-    int charactersOnLine = 0;
-    for (int i = 0; i < pathSequence.length(); ++i)
-    {
-        fasta += pathSequence.at(i);
-        ++charactersOnLine;
-        if (charactersOnLine >= 70)
-        {
-            fasta += "\n";
-            charactersOnLine = 0;
-        }
-    }
-    fasta += "\n";
+    fasta += getPathSequence(70);
 
     return fasta;
 }
@@ -617,11 +843,11 @@ bool Path::canNodeFitOnEnd(DeBruijnNode * node, Path * extendedPath) const
         return false;
 
     DeBruijnNode * lastNode = m_nodes.back();
-    const std::vector<DeBruijnEdge *> * lastNodeEdges = lastNode->getEdgesPointer();
-    for (size_t i = 0; i < lastNodeEdges->size(); ++i)
+    DeBruijnEdgeRange lastNodeEdges = lastNode->getLeavingEdgeRange();
+    for (size_t i = 0; i < lastNodeEdges.size(); ++i)
     {
-        DeBruijnEdge * edge = (*lastNodeEdges)[i];
-        if (edge->getStartingNode() == lastNode && edge->getEndingNode() == node)
+        DeBruijnEdge * edge = lastNodeEdges[i];
+        if (edge->getEndingNode() == node)
         {
             *extendedPath = *this;
             extendedPath->m_edges.push_back(edge);
@@ -647,11 +873,11 @@ bool Path::canNodeFitAtStart(DeBruijnNode * node, Path * extendedPath) const
         return false;
 
     DeBruijnNode * firstNode = m_nodes.front();
-    const std::vector<DeBruijnEdge *> * firstNodeEdges = firstNode->getEdgesPointer();
-    for (size_t i = 0; i < firstNodeEdges->size(); ++i)
+    DeBruijnEdgeRange firstNodeEdges = firstNode->getEnteringEdgeRange();
+    for (size_t i = 0; i < firstNodeEdges.size(); ++i)
     {
-        DeBruijnEdge * edge = (*firstNodeEdges)[i];
-        if (edge->getStartingNode() == node && edge->getEndingNode() == firstNode)
+        DeBruijnEdge * edge = firstNodeEdges[i];
+        if (edge->getStartingNode() == node)
         {
             *extendedPath = *this;
             extendedPath->m_edges.push_front(edge);
@@ -665,63 +891,219 @@ bool Path::canNodeFitAtStart(DeBruijnNode * node, Path * extendedPath) const
 }
 
 
-//This function builds all possible paths between the given start and end,
-//within the given restrictions.
+//This function finds all paths between the two given locations which have a
+//length in the given range and no more than nodeSearchDepth edges.
+//The search proceeds one node at a time, as a breadth-first search, so the
+//paths are returned in order of increasing node count.  Partial paths are not
+//stored as separate Path objects but as steps in a parent-pointer tree, so
+//paths which share a prefix also share its storage.  Before the search
+//begins, the shortest distances (in both bases and edges) from every nearby
+//node to the end location are found, and these are used to discard any
+//extension which cannot possibly reach the end location within the allowed
+//length and depth.
 QList<Path> Path::getAllPossiblePaths(GraphLocation startLocation,
                                       GraphLocation endLocation,
                                       int nodeSearchDepth,
                                       int minDistance, int maxDistance)
 {
     QList<Path> finishedPaths;
-    QList<Path> unfinishedPaths;
 
-    Path startPath;
-    startPath.addNode(startLocation.getNode(), true, false);
-    startPath.m_startLocation = startLocation;
-    startPath.m_endLocation = GraphLocation::endOfNode(startLocation.getNode());
-    unfinishedPaths.push_back(startPath);
-
-    for (int i = 0; i <= nodeSearchDepth; ++i)
+    DeBruijnNode * startNode = startLocation.getNode();
+    DeBruijnNode * endNode = endLocation.getNode();
+    if (startNode == 0 || endNode == 0 || nodeSearchDepth < 0)
+        return finishedPaths;
+
+    //A path finishes with the end location, not the end of the end node, so
+    //this amount is subtracted from a path's length when it finishes.
+    int endTrim = endNode->getLength() - endLocation.getPosition();
+
+    QHash<DeBruijnNode *, int> distancesToEnd;
+    QHash<DeBruijnNode *, int> stepsToEnd;
+    bool distancesUsable = findDistancesToNode(endNode, nodeSearchDepth,
+                                               maxDistance, endTrim,
+                                               &distancesToEnd, &stepsToEnd);
+
+    //Each step records the node it adds, the edge used to get there, the
+    //step before it and the length of the path up to the end of its node.
+    std::vector<PathSearchStep> steps;
+    PathSearchStep firstStep;
+    firstStep.node = startNode;
+    firstStep.edge = 0;
+    firstStep.parent = -1;
+    firstStep.length = startNode->getLength() - (startLocation.getPosition() - 1);
+    steps.push_back(firstStep);
+
+    std::vector<int> currentLevel;
+    currentLevel.push_back(0);
+    std::vector<int> finishedSteps;
+
+    for (int i = 0; i <= nodeSearchDepth && !currentLevel.empty(); ++i)
     {
-        QApplication::processEvents();
-
-        //Look at each of the unfinished paths to see if they end with the end
-        //node.  If so, see if it has the appropriate length.
-        //If it does, it will go into the final returned list.
-        //If it doesn't and it's over length, then it will be removed.
-        QList<Path>::iterator j = unfinishedPaths.begin();
-        while (j != unfinishedPaths.end())
+        std::vector<int> nextLevel;
+        for (size_t j = 0; j < currentLevel.size(); ++j)
         {
-            DeBruijnNode * lastNode = (*j).m_nodes.back();
-            if (lastNode == endLocation.getNode())
+            int stepIndex = currentLevel[j];
+            DeBruijnNode * node = steps[stepIndex].node;
+            int length = steps[stepIndex].length;
+
+            //Paths which end with the end node may finish here, if they have
+            //an appropriate length.  They are still extended, as they may
+            //also return to the end node later.
+            if (node == endNode)
             {
-                Path potentialFinishedPath = *j;
-                potentialFinishedPath.m_endLocation = endLocation;
-                int length = potentialFinishedPath.getLength();
-                if (length >= minDistance && length <= maxDistance)
-                    finishedPaths.push_back(potentialFinishedPath);
-                ++j;
+                int finishedLength = length - endTrim;
+                if (finishedLength >= minDistance && finishedLength <= maxDistance)
+                    finishedSteps.push_back(stepIndex);
             }
-            else
+            else if (length > maxDistance)
+                continue;
+
+            //There is no need to extend paths on the last level.
+            if (i == nodeSearchDepth)
+                continue;
+
+            int remainingSteps = nodeSearchDepth - i - 1;
+            DeBruijnEdgeRange edges = node->getLeavingEdgeRange();
+            for (size_t k = 0; k < edges.size(); ++k)
             {
-                if ((*j).getLength() > maxDistance)
-                    j = unfinishedPaths.erase(j);
-                else
-                    ++j;
+                DeBruijnEdge * edge = edges[k];
+                DeBruijnNode * nextNode = edge->getEndingNode();
+
+                //Skip any extension which cannot reach the end node in the
+                //remaining steps or within the maximum length.
+                QHash<DeBruijnNode *, int>::const_iterator stepsIt = stepsToEnd.find(nextNode);
+                if (stepsIt == stepsToEnd.end() || stepsIt.value() > remainingSteps)
+                    continue;
+                int nextLength = length + nextNode->getLength() - edge->getOverlap();
+                if (distancesUsable)
+                {
+                    QHash<DeBruijnNode *, int>::const_iterator distanceIt = distancesToEnd.find(nextNode);
+                    if (distanceIt == distancesToEnd.end() ||
+                            (long long)nextLength + distanceIt.value() - endTrim > maxDistance)
+                        continue;
+                }
+
+                PathSearchStep nextStep;
+                nextStep.node = nextNode;
+                nextStep.edge = edge;
+                nextStep.parent = stepIndex;
+                nextStep.length = nextLength;
+                steps.push_back(nextStep);
+                nextLevel.push_back(int(steps.size()) - 1);
             }
         }
+        currentLevel.swap(nextLevel);
+    }
 
-        //Make new unfinished paths by extending each of the paths.
-        QList<Path> newUnfinishedPaths;
-        for (int j = 0; j < unfinishedPaths.size(); ++j)
-            newUnfinishedPaths.append(unfinishedPaths[j].extendPathInAllPossibleWays());
-        unfinishedPaths = newUnfinishedPaths;
+    //Build a Path object for each finished path by following the steps back
+    //to the start.
+    for (size_t i = 0; i < finishedSteps.size(); ++i)
+    {
+        Path path;
+        for (int j = finishedSteps[i]; j >= 0; j = steps[j].parent)
+        {
+            path.m_nodes.push_front(steps[j].node);
+            if (steps[j].edge != 0)
+                path.m_edges.push_front(steps[j].edge);
+        }
+        path.m_startLocation = startLocation;
+        path.m_endLocation = endLocation;
+        finishedPaths.push_back(path);
     }
 
     return finishedPaths;
 }
 
 
+//This function searches backwards from the given node to find, for each node
+//which can reach it, the fewest edges needed and the fewest bases added.  The
+//distance in bases counts each node after the first, minus the edge overlaps.
+//The search is limited by the maximum number of steps and the maximum
+//distance.  It returns false if the base distances can't be relied on as a
+//lower bound, which happens when an edge overlap is larger than its node.
+//Every edge between the nodes found by the step search is checked for this,
+//not just those the distance search follows, as a path may use any of them.
+bool Path::findDistancesToNode(DeBruijnNode * targetNode, int maxSteps,
+                               int maxDistance, int endTrim,
+                               QHash<DeBruijnNode *, int> * distances,
+                               QHash<DeBruijnNode *, int> * steps)
+{
+    //Fewest edges, by a breadth-first search.
+    steps->insert(targetNode, 0);
+    QList<DeBruijnNode *> currentLevel;
+    currentLevel.push_back(targetNode);
+    for (int i = 1; i <= maxSteps && !currentLevel.empty(); ++i)
+    {
+        QList<DeBruijnNode *> nextLevel;
+        for (int j = 0; j < currentLevel.size(); ++j)
+        {
+            DeBruijnEdgeRange edges = currentLevel[j]->getEnteringEdgeRange();
+            for (size_t k = 0; k < edges.size(); ++k)
+            {
+                DeBruijnEdge * edge = edges[k];
+                DeBruijnNode * previousNode = edge->getStartingNode();
+                if (steps->contains(previousNode))
+                    continue;
+                steps->insert(previousNode, i);
+                nextLevel.push_back(previousNode);
+            }
+        }
+        currentLevel = nextLevel;
+    }
+
+    QHashIterator<DeBruijnNode *, int> i(*steps);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = i.key();
+        DeBruijnEdgeRange edges = node->getEnteringEdgeRange();
+        for (size_t k = 0; k < edges.size(); ++k)
+        {
+            if (node->getLength() < edges[k]->getOverlap())
+                return false;
+        }
+    }
+
+    //Fewest bases, by Dijkstra's algorithm.  A path's length is always
+    //positive, so there is no need to look beyond maxDistance + endTrim.
+    long long distanceLimit = (long long)maxDistance + endTrim;
+    typedef std::pair<long long, DeBruijnNode *> QueueEntry;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > queue;
+    distances->insert(targetNode, 0);
+    queue.push(QueueEntry(0, targetNode));
+    while (!queue.empty())
+    {
+        QueueEntry entry = queue.top();
+        queue.pop();
+        DeBruijnNode * node = entry.second;
+        if (entry.first > distances->value(node))
+            continue;
+
+        DeBruijnEdgeRange edges = node->getEnteringEdgeRange();
+        for (size_t k = 0; k < edges.size(); ++k)
+        {
+            DeBruijnEdge * edge = edges[k];
+            DeBruijnNode * previousNode = edge->getStartingNode();
+            if (!steps->contains(previousNode))
+                continue;
+
+            int edgeDistance = node->getLength() - edge->getOverlap();
+            long long distance = entry.first + edgeDistance;
+            if (distance > distanceLimit)
+                continue;
+            QHash<DeBruijnNode *, int>::iterator it = distances->find(previousNode);
+            if (it == distances->end() || distance < it.value())
+            {
+                distances->insert(previousNode, int(distance));
+                queue.push(QueueEntry(distance, previousNode));
+            }
+        }
+    }
+
+    return true;
+}
+
+
 //This function takes the current path and extends it in all possible ways by
 //adding one more node, then returning a list of the new paths.  How many paths
 //it returns depends on the number of edges leaving the last node in the path.
@@ -738,7 +1120,7 @@ QList<Path> Path::extendPathInAllPossibleWays() const
         return returnList;
 
     DeBruijnNode * lastNode = m_nodes.back();
-    std::vector<DeBruijnEdge *> nextEdges = lastNode->getLeavingEdges();
+    DeBruijnEdgeRange nextEdges = lastNode->getLeavingEdgeRange();
     for (size_t i = 0; i < nextEdges.size(); ++i)
     {
         DeBruijnEdge * nextEdge = nextEdges[i];
@@ -819,6 +1201,110 @@ bool Path::hasNodeSubset(Path other) const
 }
 
 
+//This function finds which of the given paths are sub-paths of another path
+//in the list, as determined by hasNodeSubset.  Instead of comparing every
+//pair of paths, it hashes the node sequences.  Paths are processed from most
+//nodes to fewest, and each path's node windows (one for each shorter path
+//length present) are added to an index.  A path is then a sub-path if its
+//own hash is found in the index and the nodes really do match.
+std::vector<bool> Path::findPathsWithNodeSubsets(const QList<Path> & paths)
+{
+    std::vector<bool> subsetPaths(paths.size(), false);
+    if (paths.size() < 2)
+        return subsetPaths;
+
+    //A window's hash is a polynomial in its node pointers.  Prefix hashes for
+    //each path let any window's hash be found in constant time.
+    const quint64 base = 1000003;
+    std::vector<std::vector<quint64> > prefixHashes(paths.size());
+    int longestPath = 0;
+    for (int i = 0; i < paths.size(); ++i)
+    {
+        const QList<DeBruijnNode *> & nodes = paths[i].m_nodes;
+        std::vector<quint64> & prefix = prefixHashes[i];
+        prefix.resize(nodes.size() + 1);
+        prefix[0] = 0;
+        for (int j = 0; j < nodes.size(); ++j)
+        {
+            quint64 nodeValue = quint64(quintptr(nodes[j])) * 0x9E3779B97F4A7C15ULL;
+            prefix[j + 1] = prefix[j] * base + (nodeValue ^ (nodeValue >> 29));
+        }
+        longestPath = std::max(longestPath, nodes.size());
+    }
+    std::vector<quint64> basePowers(longestPath + 1);
+    basePowers[0] = 1;
+    for (int i = 1; i <= longestPath; ++i)
+        basePowers[i] = basePowers[i - 1] * base;
+
+    std::vector<bool> lengthPresent(longestPath + 1, false);
+    for (int i = 0; i < paths.size(); ++i)
+        lengthPresent[paths[i].m_nodes.size()] = true;
+
+    std::vector<int> order;
+    for (int i = 0; i < paths.size(); ++i)
+        order.push_back(i);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return paths[a].m_nodes.size() > paths[b].m_nodes.size();});
+
+    //The index maps a window hash (mixed with the window length) to the path
+    //and position of the window.
+    QMultiHash<quint64, QPair<int, int> > windowIndex;
+
+    size_t groupStart = 0;
+    while (groupStart < order.size())
+    {
+        int groupLength = paths[order[groupStart]].m_nodes.size();
+        size_t groupEnd = groupStart;
+        while (groupEnd < order.size() && paths[order[groupEnd]].m_nodes.size() == groupLength)
+            ++groupEnd;
+
+        //Every path in the index is longer than those in this group, so a
+        //match means this path is a sub-path.
+        for (size_t i = groupStart; i < groupEnd; ++i)
+        {
+            int pathIndex = order[i];
+            const QList<DeBruijnNode *> & nodes = paths[pathIndex].m_nodes;
+            quint64 key = prefixHashes[pathIndex][groupLength] + quint64(groupLength);
+            QMultiHash<quint64, QPair<int, int> >::const_iterator it = windowIndex.constFind(key);
+            for (; it != windowIndex.constEnd() && it.key() == key; ++it)
+            {
+                const QList<DeBruijnNode *> & otherNodes = paths[it.value().first].m_nodes;
+                int offset = it.value().second;
+                bool match = true;
+                for (int j = 0; j < groupLength && match; ++j)
+                    match = (nodes[j] == otherNodes[offset + j]);
+                if (match)
+                {
+                    subsetPaths[pathIndex] = true;
+                    break;
+                }
+            }
+        }
+
+        //Now add this group's windows for each shorter length.
+        for (size_t i = groupStart; i < groupEnd; ++i)
+        {
+            int pathIndex = order[i];
+            const std::vector<quint64> & prefix = prefixHashes[pathIndex];
+            for (int windowLength = 1; windowLength < groupLength; ++windowLength)
+            {
+                if (!lengthPresent[windowLength])
+                    continue;
+                for (int start = 0; start + windowLength <= groupLength; ++start)
+                {
+                    quint64 windowHash = prefix[start + windowLength] - prefix[start] * basePowers[windowLength];
+                    windowIndex.insert(windowHash + quint64(windowLength), QPair<int, int>(pathIndex, start));
+                }
+            }
+        }
+
+        groupStart = groupEnd;
+    }
+
+    return subsetPaths;
+}
+
+
 
 void Path::extendPathToIncludeEntirityOfNodes()
 {
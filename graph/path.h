@@ -24,12 +24,33 @@
 #include <vector>
 #include <QString>
 #include <QStringList>
+#include <QHash>
 #include "../program/globals.h"
 #include "graphlocation.h"
 
 class DeBruijnNode;
 class DeBruijnEdge;
 
+//One step of a path search.  Steps are stored in a tree, with each step
+//pointing to the step before it, so paths which share a start also share
+//their storage.
+struct PathSearchStep
+{
+    DeBruijnNode * node;
+    DeBruijnEdge * edge;
+    int parent;
+    int length;
+};
+
+//The part of one node's sequence which goes into a path's sequence.
+struct PathSequencePart
+{
+    QByteArray sequence;
+    int nCount;
+    int start;
+    int length;
+};
+
 class Path
 {
 public:
@@ -43,6 +64,13 @@ public:
                                      bool circular);
     static Path makeFromString(QString pathString, bool circular,
                                QString * pathStringFailure);
+    static Path makeFromString(const QString & pathString, bool circular,
+                               QString * pathStringFailure,
+                               const QHash<QString, DeBruijnNode *> * nodeIndex);
+    static QList<Path> makeFromStrings(const QStringList & pathStrings, bool circular,
+                                       QStringList * pathStringFailures);
+    static bool loadFromFile(QString filename, QList<Path> * paths, QStringList * pathStrings,
+                             QStringList * pathStringFailures);
 
     //ACCESSORS
     QList<DeBruijnNode *> getNodes() const {return m_nodes;}
@@ -51,7 +79,7 @@ public:
     bool isCircular() const;
     bool haveSameNodes(Path other) const;
     bool hasNodeSubset(Path other) const;
-    QByteArray getPathSequence() const;
+    QByteArray getPathSequence(int lineLength = 0) const;
     QString getFasta() const;
     QString getString(bool spaces) const;
     int getLength() const;
@@ -81,6 +109,7 @@ public:
                                            GraphLocation endLocation,
                                            int nodeSearchDepth,
                                            int minDistance, int maxDistance);
+    static std::vector<bool> findPathsWithNodeSubsets(const QList<Path> & paths);
 
 private:
     GraphLocation m_startLocation;
@@ -90,8 +119,13 @@ private:
 
     void buildUnambiguousPathFromNodes(QList<DeBruijnNode *> nodes,
                                        bool strandSpecific);
-    QByteArray modifySequenceUsingOverlap(QByteArray sequence, int overlap) const;
+    static void appendToPathSequence(QByteArray * sequence, const char * bases, int length,
+                                     int lineLength, int * lineRemaining);
     bool checkForOtherEdges();
+    static bool findDistancesToNode(DeBruijnNode * targetNode, int maxSteps,
+                                    int maxDistance, int endTrim,
+                                    QHash<DeBruijnNode *, int> * distances,
+                                    QHash<DeBruijnNode *, int> * steps);
 };
 
 #endif // PATH_H
@@ -0,0 +1,90 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "radixheap.h"
+
+RadixHeap::RadixHeap() :
+    m_last(0),
+    m_size(0)
+{
+}
+
+
+void RadixHeap::push(unsigned int key, int id)
+{
+    m_buckets[getBucket(key)].push_back(std::pair<unsigned int, int>(key, id));
+    ++m_size;
+}
+
+
+//This function removes and returns an entry with the smallest key.  The heap
+//must not be empty.  If the first bucket is empty, the next non-empty bucket
+//is emptied into the lower buckets using its smallest key as the new last
+//key, which always puts at least one entry in the first bucket.
+std::pair<unsigned int, int> RadixHeap::pop()
+{
+    if (m_buckets[0].empty())
+    {
+        int i = 1;
+        while (m_buckets[i].empty())
+            ++i;
+
+        std::vector<std::pair<unsigned int, int> > & bucket = m_buckets[i];
+        unsigned int newLast = bucket[0].first;
+        for (size_t j = 1; j < bucket.size(); ++j)
+        {
+            if (bucket[j].first < newLast)
+                newLast = bucket[j].first;
+        }
+        m_last = newLast;
+
+        for (size_t j = 0; j < bucket.size(); ++j)
+            m_buckets[getBucket(bucket[j].first)].push_back(bucket[j]);
+        bucket.clear();
+    }
+
+    std::pair<unsigned int, int> entry = m_buckets[0].back();
+    m_buckets[0].pop_back();
+    --m_size;
+    return entry;
+}
+
+
+void RadixHeap::clear()
+{
+    for (int i = 0; i < 33; ++i)
+        m_buckets[i].clear();
+    m_last = 0;
+    m_size = 0;
+}
+
+
+//The bucket is one more than the position of the highest bit which differs
+//from the last popped key, or 0 if the key equals the last popped key.
+int RadixHeap::getBucket(unsigned int key) const
+{
+    unsigned int difference = key ^ m_last;
+    int bucket = 0;
+    while (difference != 0)
+    {
+        difference >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
@@ -0,0 +1,52 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef RADIXHEAP_H
+#define RADIXHEAP_H
+
+#include <vector>
+#include <utility>
+
+//This class is a monotone priority queue of node IDs keyed by distance, for
+//shortest path searches with whole-number distances.  Keys popped never
+//decrease, so each pushed key must be at least the last key popped.  Entries
+//are kept in buckets by the highest bit in which their key differs from the
+//last popped key, which makes each entry move between buckets at most 32
+//times in total.
+
+class RadixHeap
+{
+public:
+    RadixHeap();
+
+    void push(unsigned int key, int id);
+    std::pair<unsigned int, int> pop();
+    bool empty() const {return m_size == 0;}
+    size_t size() const {return m_size;}
+    void clear();
+
+private:
+    std::vector<std::pair<unsigned int, int> > m_buckets[33];
+    unsigned int m_last;
+    size_t m_size;
+
+    int getBucket(unsigned int key) const;
+};
+
+#endif // RADIXHEAP_H
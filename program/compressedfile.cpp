@@ -0,0 +1,325 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "compressedfile.h"
+#include <zlib.h>
+#ifdef BANDAGE_ZSTD
+#include <zstd.h>
+#endif
+#include <cstring>
+#include <algorithm>
+
+static const int compressedFileBufferSize = 1 << 18;
+
+CompressedFile::CompressedFile(QString filename) :
+    m_file(filename), m_compression(NO_COMPRESSION),
+    m_inputPosition(0), m_inputSize(0), m_outputPosition(0), m_outputSize(0),
+    m_finished(false), m_streamEnded(false), m_error(false), m_decompressor(0)
+{
+}
+
+CompressedFile::~CompressedFile()
+{
+    close();
+}
+
+
+bool CompressedFile::open(OpenMode mode)
+{
+    //Compressed files can only be read.
+    if ((mode & WriteOnly) || !m_file.open(QIODevice::ReadOnly))
+    {
+        setErrorString(m_file.errorString());
+        return false;
+    }
+
+    m_compression = getCompressionFromMagicBytes(m_file.peek(4));
+
+    m_inputPosition = 0;
+    m_inputSize = 0;
+    m_outputPosition = 0;
+    m_outputSize = 0;
+    m_finished = false;
+    m_streamEnded = false;
+    m_error = false;
+
+    if (m_compression == GZIP_COMPRESSION)
+    {
+        z_stream * stream = new z_stream;
+        memset(stream, 0, sizeof(z_stream));
+
+        //Adding 32 to the window bits makes zlib expect a gzip header.
+        if (inflateInit2(stream, 15 + 32) != Z_OK)
+        {
+            delete stream;
+            m_file.close();
+            setErrorString("Unable to start gzip decompression.");
+            return false;
+        }
+        m_decompressor = stream;
+    }
+    else if (m_compression == ZSTD_COMPRESSION)
+    {
+#ifdef BANDAGE_ZSTD
+        ZSTD_DStream * stream = ZSTD_createDStream();
+        ZSTD_initDStream(stream);
+        m_decompressor = stream;
+#else
+        m_file.close();
+        setErrorString("This build of Bandage cannot read zstd-compressed files.");
+        return false;
+#endif
+    }
+
+    if (m_compression != NO_COMPRESSION)
+    {
+        m_inputBuffer.resize(compressedFileBufferSize);
+        m_outputBuffer.resize(compressedFileBufferSize);
+    }
+
+    QIODevice::open(mode);
+
+    //Decompress the first block now, so atEnd is right from the start.
+    if (m_compression != NO_COMPRESSION)
+        fillOutputBuffer();
+
+    return true;
+}
+
+
+void CompressedFile::close()
+{
+    freeDecompressor();
+    m_file.close();
+    m_inputBuffer.clear();
+    m_outputBuffer.clear();
+    m_inputPosition = 0;
+    m_inputSize = 0;
+    m_outputPosition = 0;
+    m_outputSize = 0;
+    m_finished = false;
+    m_streamEnded = false;
+    if (isOpen())
+        QIODevice::close();
+}
+
+
+void CompressedFile::freeDecompressor()
+{
+    if (m_decompressor == 0)
+        return;
+
+    if (m_compression == GZIP_COMPRESSION)
+    {
+        z_stream * stream = static_cast<z_stream *>(m_decompressor);
+        inflateEnd(stream);
+        delete stream;
+    }
+#ifdef BANDAGE_ZSTD
+    else if (m_compression == ZSTD_COMPRESSION)
+        ZSTD_freeDStream(static_cast<ZSTD_DStream *>(m_decompressor));
+#endif
+
+    m_decompressor = 0;
+}
+
+
+bool CompressedFile::atEnd() const
+{
+    if (m_compression == NO_COMPRESSION)
+        return QIODevice::bytesAvailable() == 0 && m_file.atEnd();
+    return bytesAvailable() == 0 && m_finished;
+}
+
+
+qint64 CompressedFile::bytesAvailable() const
+{
+    if (m_compression == NO_COMPRESSION)
+        return QIODevice::bytesAvailable() + m_file.bytesAvailable();
+    return QIODevice::bytesAvailable() + (m_outputSize - m_outputPosition);
+}
+
+
+qint64 CompressedFile::readData(char * data, qint64 maxSize)
+{
+    if (m_compression == NO_COMPRESSION)
+        return m_file.read(data, maxSize);
+
+    qint64 bytesRead = 0;
+    while (bytesRead < maxSize)
+    {
+        if (m_outputPosition == m_outputSize)
+        {
+            if (m_finished)
+                break;
+            fillOutputBuffer();
+            continue;
+        }
+        qint64 bytesToCopy = std::min(maxSize - bytesRead, qint64(m_outputSize - m_outputPosition));
+        memcpy(data + bytesRead, m_outputBuffer.constData() + m_outputPosition, size_t(bytesToCopy));
+        bytesRead += bytesToCopy;
+        m_outputPosition += int(bytesToCopy);
+    }
+
+    //Keep a decompressed block ready, so atEnd knows whether more is coming.
+    if (m_outputPosition == m_outputSize && !m_finished)
+        fillOutputBuffer();
+
+    if (bytesRead == 0 && m_finished)
+        return -1;
+    return bytesRead;
+}
+
+
+qint64 CompressedFile::writeData(const char *, qint64)
+{
+    return -1;
+}
+
+
+//This function decompresses until there is some output or the end of the
+//file is reached.  The decompressor can still have output to give after all
+//of the input has been read, but if it has none and its stream hasn't ended,
+//the file was cut short.
+void CompressedFile::fillOutputBuffer()
+{
+    m_outputPosition = 0;
+    m_outputSize = 0;
+    while (m_outputSize == 0 && !m_finished)
+    {
+        bool endOfInput = m_inputPosition == m_inputSize && !fillInputBuffer();
+        if (m_compression == GZIP_COMPRESSION)
+            m_outputSize = decompressGzip();
+        else
+            m_outputSize = decompressZstd();
+
+        if (endOfInput && m_outputSize == 0 && !m_finished)
+        {
+            if (!m_streamEnded)
+                setError("The compressed file is incomplete.");
+            m_finished = true;
+        }
+    }
+}
+
+
+void CompressedFile::setError(QString error)
+{
+    setErrorString(error);
+    m_error = true;
+}
+
+
+bool CompressedFile::fillInputBuffer()
+{
+    qint64 bytesRead = m_file.read(m_inputBuffer.data(), m_inputBuffer.size());
+    if (bytesRead <= 0)
+        return false;
+    m_inputPosition = 0;
+    m_inputSize = int(bytesRead);
+    return true;
+}
+
+
+int CompressedFile::decompressGzip()
+{
+    z_stream * stream = static_cast<z_stream *>(m_decompressor);
+    stream->next_in = reinterpret_cast<Bytef *>(m_inputBuffer.data() + m_inputPosition);
+    stream->avail_in = uInt(m_inputSize - m_inputPosition);
+    stream->next_out = reinterpret_cast<Bytef *>(m_outputBuffer.data());
+    stream->avail_out = uInt(m_outputBuffer.size());
+
+    int inputPosition = m_inputPosition;
+    int result = inflate(stream, Z_NO_FLUSH);
+    m_inputPosition = m_inputSize - int(stream->avail_in);
+    int outputSize = m_outputBuffer.size() - int(stream->avail_out);
+    if (outputSize > 0 || m_inputPosition > inputPosition)
+        m_streamEnded = result == Z_STREAM_END;
+
+    //A gzip file can hold more than one member (block-gzipped files hold
+    //many), so after the end of one, decompression continues with the next.
+    if (result == Z_STREAM_END)
+    {
+        if (m_inputPosition == m_inputSize && !fillInputBuffer())
+            m_finished = true;
+        else
+            inflateReset(stream);
+    }
+    else if (result != Z_OK && result != Z_BUF_ERROR)
+    {
+        setError("The gzip-compressed file is corrupt.");
+        m_finished = true;
+    }
+
+    return outputSize;
+}
+
+
+int CompressedFile::decompressZstd()
+{
+#ifdef BANDAGE_ZSTD
+    ZSTD_inBuffer input = {m_inputBuffer.constData(), size_t(m_inputSize), size_t(m_inputPosition)};
+    ZSTD_outBuffer output = {m_outputBuffer.data(), size_t(m_outputBuffer.size()), 0};
+    size_t result = ZSTD_decompressStream(static_cast<ZSTD_DStream *>(m_decompressor), &output, &input);
+    if (output.pos > 0 || int(input.pos) > m_inputPosition)
+        m_streamEnded = result == 0;
+    m_inputPosition = int(input.pos);
+    if (ZSTD_isError(result))
+    {
+        setError("The zstd-compressed file is corrupt.");
+        m_finished = true;
+    }
+    return int(output.pos);
+#else
+    m_finished = true;
+    return 0;
+#endif
+}
+
+
+//These functions look at the first bytes of a file to see how it is
+//compressed.
+FileCompression CompressedFile::getCompressionFromFile(QString filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return NO_COMPRESSION;
+    return getCompressionFromMagicBytes(file.peek(4));
+}
+
+FileCompression CompressedFile::getCompressionFromMagicBytes(QByteArray magic)
+{
+    if (magic.size() >= 2 && uchar(magic[0]) == 0x1f && uchar(magic[1]) == 0x8b)
+        return GZIP_COMPRESSION;
+    if (magic.size() >= 4 && uchar(magic[0]) == 0x28 && uchar(magic[1]) == 0xb5 &&
+            uchar(magic[2]) == 0x2f && uchar(magic[3]) == 0xfd)
+        return ZSTD_COMPRESSION;
+    return NO_COMPRESSION;
+}
+
+
+//This function removes a compression extension (.gz or .zst) from a
+//filename, so related files can be found from the name of a compressed one.
+QString CompressedFile::removeCompressionExtension(QString filename)
+{
+    if (filename.endsWith(".gz", Qt::CaseInsensitive))
+        return filename.left(filename.length() - 3);
+    if (filename.endsWith(".zst", Qt::CaseInsensitive))
+        return filename.left(filename.length() - 4);
+    return filename;
+}
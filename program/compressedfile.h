@@ -0,0 +1,83 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef COMPRESSEDFILE_H
+#define COMPRESSEDFILE_H
+
+#include <QIODevice>
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+
+//This class reads a file which may be compressed with gzip (including
+//block-gzipped files) or, if Bandage was built with zstd support, zstd.  The
+//compression is determined from the file's first bytes, not its name, and
+//the file is decompressed as it is read.  Uncompressed files are read as is,
+//so a CompressedFile can be used in place of a QFile for any input file.
+
+enum FileCompression {NO_COMPRESSION, GZIP_COMPRESSION, ZSTD_COMPRESSION};
+
+class CompressedFile : public QIODevice
+{
+public:
+    CompressedFile(QString filename);
+    ~CompressedFile();
+
+    bool open(OpenMode mode);
+    void close();
+    bool isSequential() const {return true;}
+    bool atEnd() const;
+    qint64 bytesAvailable() const;
+    QString fileName() const {return m_file.fileName();}
+    FileCompression getCompression() const {return m_compression;}
+
+    //This is true if the file turned out to be corrupt or cut short while it
+    //was being read, in which case errorString says what went wrong.
+    bool hasError() const {return m_error;}
+
+    static FileCompression getCompressionFromFile(QString filename);
+    static FileCompression getCompressionFromMagicBytes(QByteArray magic);
+    static QString removeCompressionExtension(QString filename);
+
+protected:
+    qint64 readData(char * data, qint64 maxSize);
+    qint64 writeData(const char * data, qint64 maxSize);
+
+private:
+    QFile m_file;
+    FileCompression m_compression;
+    QByteArray m_inputBuffer;
+    int m_inputPosition;
+    int m_inputSize;
+    QByteArray m_outputBuffer;
+    int m_outputPosition;
+    int m_outputSize;
+    bool m_finished;
+    bool m_streamEnded;
+    bool m_error;
+    void * m_decompressor;
+
+    void fillOutputBuffer();
+    void setError(QString error);
+    bool fillInputBuffer();
+    int decompressGzip();
+    int decompressZstd();
+    void freeDecompressor();
+};
+
+#endif // COMPRESSEDFILE_H
@@ -0,0 +1,279 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#include "fastaindex.h"
+#include <QFileInfo>
+#include <QDateTime>
+#include <QList>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+FastaIndex::FastaIndex(QString fastaFilename, int cacheSize) :
+    m_file(fastaFilename), m_cache(cacheSize)
+{
+}
+
+
+//This function opens the FASTA file and gets its index, either from an
+//existing .fai file or by building one.  It returns false if the FASTA can't
+//be indexed, e.g. if its lines are of irregular lengths.
+bool FastaIndex::load()
+{
+    m_records.clear();
+    m_cache.clear();
+    if (m_file.isOpen())
+        m_file.close();
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    QString indexFilename = getIndexFilename(m_file.fileName());
+    QFileInfo indexFileInfo(indexFilename);
+    if (indexFileInfo.exists() &&
+            indexFileInfo.lastModified() >= QFileInfo(m_file.fileName()).lastModified() &&
+            readIndexFile(indexFilename))
+        return true;
+
+    if (!buildIndex())
+        return false;
+
+    //It doesn't matter if the index can't be saved (e.g. the FASTA is in a
+    //read-only directory) - it will just be built again next time.
+    saveIndexFile(indexFilename);
+    return true;
+}
+
+
+//This function scans the FASTA file to make the index.  As with samtools,
+//every line of a sequence except the last must have the same length.
+bool FastaIndex::buildIndex()
+{
+    m_records.clear();
+    m_cache.clear();
+
+    QFile file(m_file.fileName());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    FastaIndexRecord record;
+    bool inRecord = false;
+    bool recordLinesFinished = false;
+    qint64 position = 0;
+    while (!file.atEnd())
+    {
+        QByteArray line = file.readLine();
+        position += line.length();
+        int lineWidth = line.length();
+        int lineBases = lineWidth;
+        while (lineBases > 0 && (line[lineBases - 1] == '\n' || line[lineBases - 1] == '\r'))
+            --lineBases;
+
+        if (line.startsWith('>'))
+        {
+            if (inRecord)
+                m_records.push_back(record);
+            int nameEnd = 1;
+            while (nameEnd < lineBases && !isspace(uchar(line[nameEnd])))
+                ++nameEnd;
+            record.name = line.mid(1, nameEnd - 1);
+            record.length = 0;
+            record.offset = position;
+            record.lineBases = 0;
+            record.lineWidth = 0;
+            inRecord = true;
+            recordLinesFinished = false;
+            continue;
+        }
+
+        //A blank line can only come at the end of a record.
+        if (lineBases == 0)
+        {
+            recordLinesFinished = true;
+            continue;
+        }
+        if (!inRecord || recordLinesFinished)
+        {
+            m_records.clear();
+            return false;
+        }
+
+        if (record.lineBases == 0)
+        {
+            record.lineBases = lineBases;
+            record.lineWidth = lineWidth;
+        }
+        else if (lineBases > record.lineBases ||
+                 (lineWidth - lineBases != record.lineWidth - record.lineBases && !file.atEnd()))
+        {
+            m_records.clear();
+            return false;
+        }
+        if (lineBases < record.lineBases)
+            recordLinesFinished = true;
+        record.length += lineBases;
+    }
+    if (inRecord)
+        m_records.push_back(record);
+
+    return true;
+}
+
+
+bool FastaIndex::readIndexFile(QString indexFilename)
+{
+    m_records.clear();
+    m_cache.clear();
+
+    QFile indexFile(indexFilename);
+    if (!indexFile.open(QIODevice::ReadOnly))
+        return false;
+
+    while (!indexFile.atEnd())
+    {
+        QByteArray line = indexFile.readLine().trimmed();
+        if (line.isEmpty())
+            continue;
+        QList<QByteArray> parts = line.split('\t');
+        if (parts.size() < 5)
+        {
+            m_records.clear();
+            return false;
+        }
+
+        FastaIndexRecord record;
+        bool lengthOk, offsetOk, lineBasesOk, lineWidthOk;
+        record.name = parts[0];
+        record.length = parts[1].toLongLong(&lengthOk);
+        record.offset = parts[2].toLongLong(&offsetOk);
+        record.lineBases = parts[3].toInt(&lineBasesOk);
+        record.lineWidth = parts[4].toInt(&lineWidthOk);
+        if (!lengthOk || !offsetOk || !lineBasesOk || !lineWidthOk ||
+                record.lineWidth < record.lineBases ||
+                (record.length > 0 && record.lineBases <= 0))
+        {
+            m_records.clear();
+            return false;
+        }
+        m_records.push_back(record);
+    }
+
+    return true;
+}
+
+
+bool FastaIndex::saveIndexFile(QString indexFilename) const
+{
+    QFile indexFile(indexFilename);
+    if (!indexFile.open(QIODevice::WriteOnly))
+        return false;
+
+    for (size_t i = 0; i < m_records.size(); ++i)
+    {
+        const FastaIndexRecord & record = m_records[i];
+        QByteArray line = record.name + '\t' +
+                QByteArray::number(record.length) + '\t' +
+                QByteArray::number(record.offset) + '\t' +
+                QByteArray::number(record.lineBases) + '\t' +
+                QByteArray::number(record.lineWidth) + '\n';
+        if (indexFile.write(line) != line.length())
+            return false;
+    }
+    return true;
+}
+
+
+//This function returns the sequence for the record, from the cache if
+//possible.  It returns a null QByteArray if the sequence couldn't be read.
+//It is safe to call from multiple threads.
+QByteArray FastaIndex::getSequence(int i)
+{
+    if (i < 0 || i >= getRecordCount())
+        return QByteArray();
+
+    QMutexLocker locker(&m_mutex);
+    QByteArray * cachedSequence = m_cache.object(i);
+    if (cachedSequence != 0)
+        return *cachedSequence;
+    locker.unlock();
+
+    QByteArray sequence = readSequence(i);
+
+    locker.relock();
+    if (!sequence.isNull() && !m_cache.contains(i))
+        m_cache.insert(i, new QByteArray(sequence), std::max(1, sequence.length()));
+    return sequence;
+}
+
+
+QByteArray FastaIndex::readSequence(int i)
+{
+    const FastaIndexRecord & record = m_records[i];
+    if (record.length == 0)
+        return QByteArray("");
+
+    //The sequence's bytes in the file include the line endings, which are
+    //removed after it is read.
+    qint64 lineEndingCount = (record.length - 1) / record.lineBases;
+    qint64 span = record.length + lineEndingCount * (record.lineWidth - record.lineBases);
+    QByteArray sequence(int(span), '\0');
+    if (readFromFile(sequence.data(), span, record.offset) != span)
+        return QByteArray();
+
+    if (record.lineWidth > record.lineBases)
+    {
+        char * data = sequence.data();
+        qint64 basesCopied = 0;
+        for (qint64 lineStart = 0; lineStart < span; lineStart += record.lineWidth)
+        {
+            qint64 lineBases = std::min(qint64(record.lineBases), span - lineStart);
+            memmove(data + basesCopied, data + lineStart, lineBases);
+            basesCopied += lineBases;
+        }
+        sequence.resize(int(basesCopied));
+    }
+    return sequence;
+}
+
+
+//On Unix systems, pread is used so reads from different threads don't need
+//to share a file position.
+qint64 FastaIndex::readFromFile(char * data, qint64 size, qint64 offset)
+{
+#ifdef Q_OS_UNIX
+    qint64 totalRead = 0;
+    while (totalRead < size)
+    {
+        ssize_t bytesRead = pread(m_file.handle(), data + totalRead,
+                                  size_t(size - totalRead), off_t(offset + totalRead));
+        if (bytesRead <= 0)
+            break;
+        totalRead += bytesRead;
+    }
+    return totalRead;
+#else
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.seek(offset))
+        return -1;
+    return m_file.read(data, size);
+#endif
+}
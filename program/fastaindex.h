@@ -0,0 +1,75 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+#ifndef FASTAINDEX_H
+#define FASTAINDEX_H
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QCache>
+#include <QMutex>
+#include <vector>
+
+//This class gives random access to the sequences of an uncompressed FASTA
+//file using a samtools-style .fai index.  If the index file is missing or
+//older than the FASTA file, the index is built by scanning the FASTA and saved
+//next to it (if possible).  Sequences are read from the file only when asked
+//for and recently used sequences are kept in a cache limited by total size,
+//so only the working set of sequences is held in memory.
+//
+//Each line of a .fai file has the record name, the sequence length, the file
+//offset of the first base, the bases per line and the bytes per line.
+
+struct FastaIndexRecord
+{
+    QByteArray name;
+    qint64 length;
+    qint64 offset;
+    int lineBases;
+    int lineWidth;
+};
+
+class FastaIndex
+{
+public:
+    FastaIndex(QString fastaFilename, int cacheSize = 64 * 1024 * 1024);
+
+    bool load();
+    bool buildIndex();
+    bool readIndexFile(QString indexFilename);
+    bool saveIndexFile(QString indexFilename) const;
+
+    int getRecordCount() const {return int(m_records.size());}
+    const FastaIndexRecord & getRecord(int i) const {return m_records[i];}
+    QByteArray getSequence(int i);
+
+    static QString getIndexFilename(QString fastaFilename) {return fastaFilename + ".fai";}
+
+private:
+    QFile m_file;
+    std::vector<FastaIndexRecord> m_records;
+    QCache<int, QByteArray> m_cache;
+    QMutex m_mutex;
+
+    QByteArray readSequence(int i);
+    qint64 readFromFile(char * data, qint64 size, qint64 offset);
+};
+
+#endif // FASTAINDEX_H
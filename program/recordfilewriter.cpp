@@ -0,0 +1,203 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "recordfilewriter.h"
+#include <zlib.h>
+#include <QtConcurrentMap>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+//BGZF blocks hold at most 65280 bytes of input so that their compressed size
+//always fits in the 16-bit block size field.
+static const int bgzfBlockInputSize = 0xff00;
+static const int bgzfBlockMaxSize = 0x10000;
+static const int bgzfHeaderSize = 18;
+static const int bgzfFooterSize = 8;
+static const int recordFileBufferSize = bgzfBlockInputSize * 64;
+
+//An empty BGZF block marks the end of the file.
+static const char bgzfEndOfFile[28] = {'\x1f', '\x8b', '\x08', '\x04', '\x00', '\x00', '\x00', '\x00',
+                                       '\x00', '\xff', '\x06', '\x00', '\x42', '\x43', '\x02', '\x00',
+                                       '\x1b', '\x00', '\x03', '\x00', '\x00', '\x00', '\x00', '\x00',
+                                       '\x00', '\x00', '\x00', '\x00'};
+
+RecordFileWriter::RecordFileWriter(QString filename, bool compress) :
+    m_file(filename), m_compress(compress), m_error(false)
+{
+}
+
+RecordFileWriter::~RecordFileWriter()
+{
+    if (m_file.isOpen())
+        close();
+}
+
+
+bool RecordFileWriter::open()
+{
+    //Compressed output is binary, but plain text output keeps the platform's
+    //line endings as a QTextStream would.
+    QIODevice::OpenMode mode = QIODevice::WriteOnly;
+    if (!m_compress)
+        mode |= QIODevice::Text;
+    m_error = !m_file.open(mode);
+    if (!m_error)
+        m_buffer.reserve(recordFileBufferSize + bgzfBlockInputSize);
+    return !m_error;
+}
+
+
+void RecordFileWriter::write(const QByteArray & data)
+{
+    m_buffer += data;
+    if (m_buffer.length() >= recordFileBufferSize)
+        flush(false);
+}
+
+
+//This function writes anything left in the buffer and closes the file.  It
+//returns false if any write failed.
+bool RecordFileWriter::close()
+{
+    if (!m_file.isOpen())
+        return false;
+
+    flush(true);
+    if (m_compress && m_file.write(bgzfEndOfFile, sizeof(bgzfEndOfFile)) != qint64(sizeof(bgzfEndOfFile)))
+        m_error = true;
+    m_file.close();
+    m_buffer.clear();
+    return !m_error;
+}
+
+
+bool RecordFileWriter::isCompressedFilename(QString filename)
+{
+    return filename.endsWith(".gz", Qt::CaseInsensitive) ||
+            filename.endsWith(".bgz", Qt::CaseInsensitive);
+}
+
+
+//One block of the buffer, to be compressed in a separate thread.
+struct BgzfBlock
+{
+    const char * data;
+    int size;
+    QByteArray compressed;
+};
+
+static void compressBlock(BgzfBlock & block)
+{
+    block.compressed = RecordFileWriter::compressBgzfBlock(block.data, block.size);
+}
+
+
+//When compressing, only whole blocks are written until the final flush, so
+//every block but the last is full.
+void RecordFileWriter::flush(bool final)
+{
+    if (m_error || m_buffer.isEmpty())
+        return;
+
+    if (!m_compress)
+    {
+        if (m_file.write(m_buffer) != m_buffer.length())
+            m_error = true;
+        m_buffer.clear();
+        return;
+    }
+
+    int blockCount = m_buffer.length() / bgzfBlockInputSize;
+    if (final && m_buffer.length() % bgzfBlockInputSize > 0)
+        ++blockCount;
+    if (blockCount == 0)
+        return;
+
+    std::vector<BgzfBlock> blocks(blockCount);
+    int bytesUsed = 0;
+    for (int i = 0; i < blockCount; ++i)
+    {
+        blocks[i].data = m_buffer.constData() + bytesUsed;
+        blocks[i].size = std::min(bgzfBlockInputSize, m_buffer.length() - bytesUsed);
+        bytesUsed += blocks[i].size;
+    }
+    if (blockCount > 1)
+        QtConcurrent::blockingMap(blocks, compressBlock);
+    else
+        compressBlock(blocks[0]);
+
+    for (int i = 0; i < blockCount && !m_error; ++i)
+    {
+        if (blocks[i].compressed.isEmpty() ||
+                m_file.write(blocks[i].compressed) != blocks[i].compressed.length())
+            m_error = true;
+    }
+    m_buffer.remove(0, bytesUsed);
+}
+
+
+//This function makes one BGZF block: a gzip member with a BC extra field
+//giving the size of the block.  If the data doesn't compress enough to fit,
+//it is stored instead.  An empty array is returned if zlib fails.
+QByteArray RecordFileWriter::compressBgzfBlock(const char * data, int size)
+{
+    QByteArray block(bgzfBlockMaxSize, '\0');
+    unsigned char * output = reinterpret_cast<unsigned char *>(block.data());
+
+    int compressedSize = -1;
+    for (int level = Z_DEFAULT_COMPRESSION; compressedSize < 0; level = Z_NO_COMPRESSION)
+    {
+        z_stream stream;
+        memset(&stream, 0, sizeof(z_stream));
+
+        //Negative window bits make zlib write raw deflate data, as the gzip
+        //header and footer are written here.
+        if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return QByteArray();
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        stream.avail_in = uInt(size);
+        stream.next_out = output + bgzfHeaderSize;
+        stream.avail_out = uInt(bgzfBlockMaxSize - bgzfHeaderSize - bgzfFooterSize);
+        int result = deflate(&stream, Z_FINISH);
+        if (result == Z_STREAM_END)
+            compressedSize = int(stream.total_out);
+        deflateEnd(&stream);
+
+        if (compressedSize < 0 && level == Z_NO_COMPRESSION)
+            return QByteArray();
+    }
+
+    int blockSize = bgzfHeaderSize + compressedSize + bgzfFooterSize;
+    const unsigned char header[bgzfHeaderSize] = {0x1f, 0x8b, 0x08, 0x04, 0, 0, 0, 0, 0, 0xff,
+                                                  6, 0, 'B', 'C', 2, 0,
+                                                  (unsigned char)((blockSize - 1) & 0xff),
+                                                  (unsigned char)((blockSize - 1) >> 8)};
+    memcpy(output, header, bgzfHeaderSize);
+
+    unsigned long crc = crc32(0L, reinterpret_cast<const Bytef *>(data), uInt(size));
+    unsigned char * footer = output + bgzfHeaderSize + compressedSize;
+    for (int i = 0; i < 4; ++i)
+    {
+        footer[i] = (unsigned char)((crc >> (8 * i)) & 0xff);
+        footer[i + 4] = (unsigned char)((unsigned(size) >> (8 * i)) & 0xff);
+    }
+
+    block.truncate(blockSize);
+    return block;
+}
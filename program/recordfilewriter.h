@@ -0,0 +1,62 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef RECORDFILEWRITER_H
+#define RECORDFILEWRITER_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+
+//This class writes a file made of text records, such as FASTA records or GFA
+//lines.  Records are gathered in a large buffer so the file gets a few big
+//writes instead of many small ones.
+//If compression is on, the file is block-gzipped (BGZF): a series of gzip
+//members, each holding up to 65280 bytes.  Any gzip reader can read this, and
+//each block is compressed separately, so a buffer's blocks are compressed in
+//parallel.
+//
+//Usage:
+//    RecordFileWriter writer(filename, RecordFileWriter::isCompressedFilename(filename));
+//    if (writer.open())
+//        writer.write(...);
+//    bool success = writer.close();
+
+class RecordFileWriter
+{
+public:
+    RecordFileWriter(QString filename, bool compress);
+    ~RecordFileWriter();
+
+    bool open();
+    void write(const QByteArray & data);
+    bool close();
+
+    static bool isCompressedFilename(QString filename);
+    static QByteArray compressBgzfBlock(const char * data, int size);
+
+private:
+    QFile m_file;
+    bool m_compress;
+    QByteArray m_buffer;
+    bool m_error;
+
+    void flush(bool final);
+};
+
+#endif // RECORDFILEWRITER_H
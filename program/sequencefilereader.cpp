@@ -0,0 +1,232 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "sequencefilereader.h"
+#include <cstring>
+#include <cctype>
+
+static const int sequenceFileBufferSize = 1 << 20;
+
+SequenceFileReader::SequenceFileReader(QString filename, bool useMemoryMap) :
+    m_file(filename), m_mappedFile(filename), m_useMemoryMap(useMemoryMap),
+    m_data(0), m_dataSize(0), m_position(0), m_endOfFile(false),
+    m_fastq(false), m_haveNextHeader(false)
+{
+}
+
+SequenceFileReader::~SequenceFileReader()
+{
+    if (m_mappedFile.isOpen())
+        m_mappedFile.close();
+}
+
+
+bool SequenceFileReader::open()
+{
+    m_position = 0;
+    m_endOfFile = false;
+    m_haveNextHeader = false;
+
+    //Memory mapping is only possible for uncompressed files.  If it fails,
+    //the file is read normally.
+    if (m_useMemoryMap &&
+            CompressedFile::getCompressionFromFile(m_mappedFile.fileName()) == NO_COMPRESSION &&
+            m_mappedFile.open(QIODevice::ReadOnly))
+    {
+        qint64 fileSize = m_mappedFile.size();
+        uchar * map = 0;
+        if (fileSize > 0)
+            map = m_mappedFile.map(0, fileSize);
+        if (map != 0 || fileSize == 0)
+        {
+            m_data = reinterpret_cast<const char *>(map);
+            m_dataSize = fileSize;
+            m_endOfFile = true;
+            return true;
+        }
+        m_mappedFile.close();
+    }
+
+    m_useMemoryMap = false;
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+    m_buffer.resize(sequenceFileBufferSize);
+    m_data = m_buffer.constData();
+    m_dataSize = 0;
+    m_name.reserve(256);
+    m_sequence.reserve(sequenceFileBufferSize);
+    return true;
+}
+
+
+//This function moves any unread data to the start of the buffer and fills
+//the rest from the file.  It returns false if nothing more could be read.
+bool SequenceFileReader::fillBuffer()
+{
+    if (m_endOfFile)
+        return false;
+
+    qint64 remaining = m_dataSize - m_position;
+    if (remaining > 0 && m_position > 0)
+        memmove(m_buffer.data(), m_buffer.constData() + m_position, size_t(remaining));
+    m_position = 0;
+    m_dataSize = remaining;
+
+    //A line longer than the buffer makes the buffer grow.
+    if (m_dataSize == m_buffer.size())
+        m_buffer.resize(m_buffer.size() * 2);
+    m_data = m_buffer.constData();
+
+    qint64 bytesRead = m_file.read(m_buffer.data() + m_dataSize, m_buffer.size() - m_dataSize);
+    if (bytesRead <= 0)
+    {
+        m_endOfFile = true;
+        return false;
+    }
+    m_dataSize += bytesRead;
+    return true;
+}
+
+
+//This function finds the next line, without its line ending.  The line
+//points into the buffer, so it is only valid until the next call.
+bool SequenceFileReader::readLine(const char ** line, int * length)
+{
+    while (true)
+    {
+        const char * start = m_data + m_position;
+        qint64 available = m_dataSize - m_position;
+        const char * newline = 0;
+        if (available > 0)
+            newline = static_cast<const char *>(memchr(start, '\n', size_t(available)));
+
+        if (newline != 0 || (m_endOfFile && available > 0))
+        {
+            int lineLength = (newline != 0) ? int(newline - start) : int(available);
+            m_position += lineLength + ((newline != 0) ? 1 : 0);
+            if (lineLength > 0 && start[lineLength - 1] == '\r')
+                --lineLength;
+            *line = start;
+            *length = lineLength;
+            return true;
+        }
+
+        if (!fillBuffer() && m_position == m_dataSize)
+            return false;
+    }
+}
+
+
+//This function reads the next record into the name, sequence and quality
+//buffers.  It returns false when there are no more records.
+bool SequenceFileReader::readNext()
+{
+    const char * line;
+    int length;
+
+    //Find the header line, skipping anything before it.
+    if (!m_haveNextHeader)
+    {
+        while (true)
+        {
+            if (!readLine(&line, &length))
+                return false;
+            if (length > 0 && (line[0] == '>' || line[0] == '@'))
+                break;
+        }
+        m_nextHeader = QByteArray(line, length);
+    }
+    m_haveNextHeader = false;
+
+    m_fastq = (m_nextHeader[0] == '@');
+    m_name.resize(0);
+    m_name.append(m_nextHeader.constData() + 1, m_nextHeader.length() - 1);
+    m_sequence.resize(0);
+    m_quality.resize(0);
+
+    if (m_fastq)
+    {
+        //FASTQ sequences end at the '+' line, and the quality is the same
+        //length as the sequence.
+        while (readLine(&line, &length))
+        {
+            if (length > 0 && line[0] == '+')
+                break;
+            appendSequenceLine(&m_sequence, line, length);
+        }
+        while (m_quality.length() < m_sequence.length() && readLine(&line, &length))
+            m_quality.append(line, length);
+        return true;
+    }
+
+    //FASTA sequences end at the next header.
+    while (readLine(&line, &length))
+    {
+        if (length > 0 && line[0] == '>')
+        {
+            m_nextHeader = QByteArray(line, length);
+            m_haveNextHeader = true;
+            break;
+        }
+        appendSequenceLine(&m_sequence, line, length);
+    }
+    return true;
+}
+
+
+//This function adds a sequence line to a sequence.  Like QString::simplified,
+//it trims whitespace from the ends and turns any internal whitespace into a
+//single space.
+void SequenceFileReader::appendSequenceLine(QByteArray * sequence, const char * line, int length)
+{
+    int start = 0;
+    while (start < length && isspace(uchar(line[start])))
+        ++start;
+    while (length > start && isspace(uchar(line[length - 1])))
+        --length;
+    if (start == length)
+        return;
+
+    const char * lineStart = line + start;
+    int lineLength = length - start;
+    bool hasWhitespace = false;
+    for (int i = 0; i < lineLength && !hasWhitespace; ++i)
+        hasWhitespace = isspace(uchar(lineStart[i]));
+
+    if (!hasWhitespace)
+    {
+        sequence->append(lineStart, lineLength);
+        return;
+    }
+
+    bool previousWasSpace = false;
+    for (int i = 0; i < lineLength; ++i)
+    {
+        if (isspace(uchar(lineStart[i])))
+        {
+            if (!previousWasSpace)
+                sequence->append(' ');
+            previousWasSpace = true;
+        }
+        else
+        {
+            sequence->append(lineStart[i]);
+            previousWasSpace = false;
+        }
+    }
+}
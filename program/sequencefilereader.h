@@ -0,0 +1,80 @@
+//Copyright 2017 Ryan Wick
+
+//This file is part of Bandage
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef SEQUENCEFILEREADER_H
+#define SEQUENCEFILEREADER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include "compressedfile.h"
+
+//This class reads FASTA and FASTQ files one record at a time, in the style of
+//kseq.  The file is read in large blocks and scanned as bytes, so no QString
+//is made for each line.  The name, sequence and quality buffers are reused
+//between records.  Compressed files are read through CompressedFile, and
+//uncompressed files can instead be memory mapped.
+//
+//Usage:
+//    SequenceFileReader reader(filename);
+//    if (reader.open())
+//        while (reader.readNext())
+//            ...reader.getName(), reader.getSequence()...
+
+class SequenceFileReader
+{
+public:
+    SequenceFileReader(QString filename, bool useMemoryMap = false);
+    ~SequenceFileReader();
+
+    bool open();
+    bool readNext();
+
+    //The name is the whole header line, without the leading '>' or '@'.
+    const QByteArray & getName() const {return m_name;}
+    const QByteArray & getSequence() const {return m_sequence;}
+    const QByteArray & getQuality() const {return m_quality;}
+    bool isFastq() const {return m_fastq;}
+
+    //This is true if the file is compressed and turned out to be corrupt or
+    //cut short, so its last records may be missing.
+    bool hasError() const {return m_file.hasError();}
+
+private:
+    CompressedFile m_file;
+    QFile m_mappedFile;
+    bool m_useMemoryMap;
+    const char * m_data;
+    qint64 m_dataSize;
+    qint64 m_position;
+    QByteArray m_buffer;
+    bool m_endOfFile;
+
+    QByteArray m_name;
+    QByteArray m_sequence;
+    QByteArray m_quality;
+    bool m_fastq;
+    QByteArray m_nextHeader;
+    bool m_haveNextHeader;
+
+    bool readLine(const char ** line, int * length);
+    bool fillBuffer();
+    static void appendSequenceLine(QByteArray * sequence, const char * line, int length);
+};
+
+#endif // SEQUENCEFILEREADER_H
@@ -18,6 +18,8 @@
 
 #include "settings.h"
 #include <QDir>
+#include <QThread>
+#include <algorithm>
 
 Settings::Settings()
 {
@@ -51,6 +53,7 @@ Settings::Settings()
 
     graphScope = WHOLE_GRAPH;
     nodeDistance = IntSetting(0, 0, 100);
+    baseDistance = IntSetting(1000, 0, 1000000000);
     startingNodesExactMatch = true;
     startingNodes = "";
     blastQueryFilename = "";
@@ -132,6 +135,8 @@ Settings::Settings()
     maxLengthBaseDiscrepancy = IntSetting(100, -1000000, 1000000, false);
 
     blastSearchParameters = "";
+    blastThreads = IntSetting(std::max(1, QThread::idealThreadCount()), 1, 1024);
+    blastQueryShards = IntSetting(1, 1, 256);
 
     blastAlignmentLengthFilter = IntSetting(100, 1, 1000000, false);
     blastQueryCoverageFilter = FloatSetting(50.0, 0.0, 100.0, false);
@@ -102,6 +102,7 @@ public:
 
     GraphScope graphScope;
     IntSetting nodeDistance;
+    IntSetting baseDistance;
     bool startingNodesExactMatch;
     QString startingNodes;
     QString blastQueryFilename;
@@ -191,6 +192,11 @@ public:
     //running a BLAST search.
     QString blastSearchParameters;
 
+    //The number of threads shared between the BLAST processes, and the number
+    //of processes that the queries of each sequence type are split between.
+    IntSetting blastThreads;
+    IntSetting blastQueryShards;
+
     //These are the optional BLAST hit filters: whether or not they are used and
     //what their values are.
     IntSetting blastAlignmentLengthFilter;
@@ -0,0 +1,134 @@
+//Copyright 2015 Ryan Wick
+
+//This file is part of Bandage.
+
+//Bandage is free software: you can redistribute it and/or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation, either version 3 of the License, or
+//(at your option) any later version.
+
+//Bandage is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//GNU General Public License for more details.
+
+//You should have received a copy of the GNU General Public License
+//along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+
+//These benchmarks are kept apart from the unit tests (in BandageTests) so the
+//tests stay quick.  They are built with BandageBenchmarks.pro.
+
+#include <QtTest/QtTest>
+#include "../graph/assemblygraph.h"
+#include "../program/settings.h"
+#include "../blast/blastsearch.h"
+#include "../ui/mygraphicsview.h"
+#include "../program/memory.h"
+#include "../graph/debruijnnode.h"
+#include "../graph/path.h"
+#include "../graph/graphlocation.h"
+#include "../program/globals.h"
+
+class BandageBenchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void edgeRangePathFinding();
+    void neighbourSearch();
+
+private:
+    void createGlobals();
+    QString getTestDirectory();
+};
+
+
+
+//Path finding reads each node's leaving and entering edge ranges.
+void BandageBenchmarks::edgeRangePathFinding()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    DeBruijnNode * node1 = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    DeBruijnNode * node2 = g_assemblyGraph->m_deBruijnGraphNodes["2+"];
+
+    QBENCHMARK
+    {
+        QList<Path> currentPaths;
+        QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+        while (i.hasNext())
+        {
+            i.next();
+            QList<DeBruijnNode *> nodes;
+            nodes.push_back(i.value());
+            currentPaths.push_back(Path::makeFromOrderedNodes(nodes, false));
+        }
+        for (int j = 0; j < 5; ++j)
+        {
+            QList<Path> nextPaths;
+            for (int k = 0; k < currentPaths.size(); ++k)
+                nextPaths.append(currentPaths[k].extendPathInAllPossibleWays());
+            currentPaths = nextPaths;
+        }
+        Path::getAllPossiblePaths(GraphLocation::endOfNode(node1),
+                                  GraphLocation::startOfNode(node2), 10, 0, 10000);
+    }
+}
+
+
+//The neighbour searches are run with every node as a starting node, as can
+//happen with the around BLAST hits scope.
+void BandageBenchmarks::neighbourSearch()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.Trinity.fasta");
+    g_settings->doubleMode = true;
+
+    std::vector<DeBruijnNode *> allNodes;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        allNodes.push_back(i.value());
+    }
+
+    QBENCHMARK
+    {
+        g_assemblyGraph->labelNeighbouringNodesAsDrawn(allNodes, 50);
+        g_assemblyGraph->labelNodesWithinBasesAsDrawn(allNodes, 100000);
+    }
+}
+
+
+
+void BandageBenchmarks::createGlobals()
+{
+    g_settings.reset(new Settings());
+    g_memory.reset(new Memory());
+    g_blastSearch.reset(new BlastSearch());
+    g_assemblyGraph.reset(new AssemblyGraph());
+    g_graphicsView = new MyGraphicsView();
+}
+
+QString BandageBenchmarks::getTestDirectory()
+{
+    QDir directory = QDir::current();
+
+    //We want to find a directory "Bandage/tests/".  Keep backing up in the
+    //directory structure until we find it.
+    QString path;
+    while (true)
+    {
+        path = directory.path() + "/Bandage/tests/";
+        if (QDir(path).exists())
+            return path;
+        if (!directory.cdUp())
+            return "";
+    }
+
+    return "";
+}
+
+QTEST_MAIN(BandageBenchmarks)
+#include "bandagebenchmarks.moc"
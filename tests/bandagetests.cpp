@@ -18,6 +18,7 @@
 
 #include <QtTest/QtTest>
 #include <QDebug>
+#include <algorithm>
 #include "ogdf/basic/Graph.h"
 #include "ogdf/basic/GraphAttributes.h"
 #include "../graph/assemblygraph.h"
@@ -27,8 +28,17 @@
 #include "../program/memory.h"
 #include "../graph/debruijnnode.h"
 #include "../graph/debruijnedge.h"
+#include "../graph/path.h"
+#include "../program/sequencefilereader.h"
+#include "../program/fastaindex.h"
+#include "../program/compressedfile.h"
+#include "../program/recordfilewriter.h"
+#include "../graph/graphstatistics.h"
+#include "../graph/graphcomponents.h"
+#include "../graph/gfatopology.h"
 #include "../program/globals.h"
 #include "../command_line/commoncommandlinefunctions.h"
+#include "../command_line/reduce.h"
 
 class BandageTests : public QObject
 {
@@ -38,26 +48,46 @@ private slots:
     void loadFastg();
     void loadLastGraph();
     void loadTrinity();
+    void loadCompressedGraph();
+    void loadTruncatedCompressedGraph();
     void pathFunctionsOnLastGraph();
     void pathFunctionsOnFastg();
     void pathFunctionsOnGfaSequencesInGraph();
     void pathFunctionsOnGfaSequencesInFasta();
+    void canuSequencesInFasta();
+    void fastaIndex();
     void graphLocationFunctions();
     void loadCsvData();
     void loadCsvDataTrinity();
     void blastSearch();
     void blastSearchFilters();
+    void blastSearchShards();
     void graphScope();
+    void neighbourSearch();
+    void streamingReduce();
+    void streamingReduceMatchesReduce();
     void commandLineSettings();
     void sciNotComparisons();
     void graphEdits();
+    void bulkDeletion();
     void velvetToGfa();
     void spadesToGfa();
+    void compressedGraphOutput();
+    void gfaPaths();
     void mergeNodesOnGfa();
+    void mergeAllPossibleMatchesOneAtATime();
     void changeNodeNames();
+    void partialNodeNameSearch();
     void changeNodeDepths();
     void blastQueryPaths();
+    void allPossiblePathsWithOverlaps();
+    void pathSubsetElimination();
+    void edgeRanges();
+    void readFastaFile();
+    void autoEdgeOverlaps();
     void bandageInfo();
+    void graphStatistics();
+    void graphComponents();
 
 
 private:
@@ -68,6 +98,17 @@ private:
     DeBruijnEdge * getEdgeFromNodeNames(QString startingNodeName,
                                         QString endingNodeName);
     bool doCircularSequencesMatch(QByteArray s1, QByteArray s2);
+    bool edgeRangesMatchEdges(DeBruijnNode * node);
+    QList<QList<DeBruijnNode *> > getAllPossiblePathsExhaustively(GraphLocation startLocation,
+                                                                  GraphLocation endLocation,
+                                                                  int nodeSearchDepth,
+                                                                  int minDistance, int maxDistance,
+                                                                  QList<int> * lengths);
+    int mergeAllPossibleOneAtATime();
+    QStringList getBlastResultStrings();
+    QSet<QString> getEdgeStrings();
+    QSet<QString> getNodeStrings();
+    int countGfaSegmentLines(QString filename);
 };
 
 
@@ -134,6 +175,72 @@ void BandageTests::loadTrinity()
 }
 
 
+//This function checks that a gzipped graph loads the same as the plain graph.
+//The gzipped file is made of two gzip members, like a block-gzipped file.
+void BandageTests::loadCompressedGraph()
+{
+    createGlobals();
+    QCOMPARE(g_assemblyGraph->getGraphFileTypeFromFile(getTestDirectory() + "test_plasmids.gfa.gz"), GFA);
+    bool gfaLoaded = g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test_plasmids.gfa");
+    QCOMPARE(gfaLoaded, true);
+    QByteArray plainSequence = g_assemblyGraph->m_deBruijnGraphNodes["277+"]->getSequence();
+
+    createGlobals();
+    gfaLoaded = g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test_plasmids.gfa.gz");
+    QCOMPARE(gfaLoaded, true);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 18);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphEdges.size(), 24);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes["277+"]->getSequence(), plainSequence);
+}
+
+
+//A gzipped graph which is cut short or corrupt should fail to load, not load
+//as a smaller graph.
+void BandageTests::loadTruncatedCompressedGraph()
+{
+    QFile gzFile(getTestDirectory() + "test_plasmids.gfa.gz");
+    gzFile.open(QIODevice::ReadOnly);
+    QByteArray gzData = gzFile.readAll();
+    gzFile.close();
+
+    QByteArray truncatedData = gzData.left(gzData.size() * 3 / 4);
+    QByteArray corruptData = gzData;
+    for (int i = 1000; i < 1010; ++i)
+        corruptData[i] = char(~corruptData[i]);
+
+    QStringList filenames;
+    filenames << "test_truncated_temp.gfa.gz" << "test_corrupt_temp.gfa.gz";
+    QList<QByteArray> fileData;
+    fileData << truncatedData << corruptData;
+
+    for (int i = 0; i < filenames.size(); ++i)
+    {
+        QString filename = getTestDirectory() + filenames[i];
+        QFile outputFile(filename);
+        outputFile.open(QIODevice::WriteOnly);
+        outputFile.write(fileData[i]);
+        outputFile.close();
+
+        CompressedFile file(filename);
+        QCOMPARE(file.open(QIODevice::ReadOnly), true);
+        file.readAll();
+        QCOMPARE(file.hasError(), true);
+        QCOMPARE(file.errorString().isEmpty(), false);
+
+        createGlobals();
+        QCOMPARE(g_assemblyGraph->loadGraphFromFile(filename), false);
+
+        QFile::remove(filename);
+    }
+
+    //The intact file has no error.
+    CompressedFile file(getTestDirectory() + "test_plasmids.gfa.gz");
+    QCOMPARE(file.open(QIODevice::ReadOnly), true);
+    QCOMPARE(file.readAll().isEmpty(), false);
+    QCOMPARE(file.hasError(), false);
+}
+
+
 //LastGraph files have no overlap in the edges, so these tests look at paths
 //where the connections are simple.
 void BandageTests::pathFunctionsOnLastGraph()
@@ -177,6 +284,56 @@ void BandageTests::pathFunctionsOnLastGraph()
     QCOMPARE(testPath4Extended.getString(true), QString("9+, 13+, 14-, 7+"));
     QCOMPARE(testPath4.canNodeFitAtStart(node4Minus, &testPath4Extended), true);
     QCOMPARE(testPath4Extended.getString(true), QString("4-, 9+, 13+, 14-"));
+
+    //Badly formatted strings and missing nodes give the same failures as
+    //they always have.
+    Path badPath = Path::makeFromString("9+, 13+,", false, &pathStringFailure);
+    QCOMPARE(badPath.isEmpty(), true);
+    QCOMPARE(pathStringFailure, QString("the text is not formatted correctly"));
+    badPath = Path::makeFromString("9+, 13", false, &pathStringFailure);
+    QCOMPARE(pathStringFailure, QString("the text is not formatted correctly"));
+    badPath = Path::makeFromString("(5) 9+, 13+", true, &pathStringFailure);
+    QCOMPARE(pathStringFailure, QString("circular paths cannot contain start or end positions"));
+    badPath = Path::makeFromString("9+, 1000+, 1001-", false, &pathStringFailure);
+    QCOMPARE(pathStringFailure, QString("the following nodes are not in the graph: 1000+, 1001-"));
+    badPath = Path::makeFromString("(99999) 9+, 13+", false, &pathStringFailure);
+    QCOMPARE(pathStringFailure, QString("starting node position not valid"));
+
+    //Many paths can be made at once, giving the same results as making them
+    //one at a time.
+    QStringList pathStrings;
+    pathStrings << "(1996) 9+, 13+ (5)" << "9+, 13+, 14-" << "9+, 13+," << "9+, 1000+" << "9+,13+,14-,7+";
+    QStringList pathStringFailures;
+    QList<Path> paths = Path::makeFromStrings(pathStrings, false, &pathStringFailures);
+    QCOMPARE(paths.size(), pathStrings.size());
+    QCOMPARE(pathStringFailures.size(), pathStrings.size());
+    for (int i = 0; i < pathStrings.size(); ++i)
+    {
+        QString singleFailure;
+        Path singlePath = Path::makeFromString(pathStrings[i], false, &singleFailure);
+        QCOMPARE(paths[i] == singlePath, true);
+        QCOMPARE(paths[i].isEmpty(), singlePath.isEmpty());
+        QCOMPARE(pathStringFailures[i], singleFailure);
+    }
+    QCOMPARE(paths[0] == testPath1, true);
+    QCOMPARE(pathStringFailures[0], QString());
+
+    //Paths can also be loaded from a file, one per line.
+    QString pathsFilename = getTestDirectory() + "test_paths_temp.txt";
+    QFile pathsFile(pathsFilename);
+    pathsFile.open(QIODevice::WriteOnly);
+    pathsFile.write("#paths\n(1996) 9+, 13+ (5)\n\n9+, 13+, 14-\n9+, 1000+\n");
+    pathsFile.close();
+    QList<Path> loadedPaths;
+    QStringList loadedPathStrings;
+    QCOMPARE(Path::loadFromFile(pathsFilename, &loadedPaths, &loadedPathStrings, &pathStringFailures), true);
+    QFile::remove(pathsFilename);
+    QCOMPARE(loadedPaths.size(), 3);
+    QCOMPARE(loadedPathStrings[1], QString("9+, 13+, 14-"));
+    QCOMPARE(loadedPaths[0] == testPath1, true);
+    QCOMPARE(loadedPaths[1] == testPath4, true);
+    QCOMPARE(loadedPaths[2].isEmpty(), true);
+    QCOMPARE(pathStringFailures[2], QString("the following nodes are not in the graph: 1000+"));
 }
 
 
@@ -195,6 +352,16 @@ void BandageTests::pathFunctionsOnFastg()
     QCOMPARE(testPath2.getLength(), 1387);
     QCOMPARE(testPath1.isCircular(), false);
     QCOMPARE(testPath2.isCircular(), true);
+
+    //The sequence can also be made with FASTA line breaks.
+    QByteArray testPath1Sequence = testPath1.getPathSequence();
+    QByteArray testPath2Sequence = testPath2.getPathSequence();
+    QCOMPARE(testPath1Sequence.length(), 1764);
+    QCOMPARE(testPath1.getPathSequence(70), AssemblyGraph::addNewlinesToSequence(testPath1Sequence));
+    QCOMPARE(testPath2.getPathSequence(70), AssemblyGraph::addNewlinesToSequence(testPath2Sequence));
+    QCOMPARE(testPath1.getPathSequence(63), AssemblyGraph::addNewlinesToSequence(testPath1Sequence, 63));
+    QCOMPARE(testPath1.getFasta(), ">" + testPath1.getString(false) + "\n" +
+                                   QString(AssemblyGraph::addNewlinesToSequence(testPath1Sequence)));
 }
 
 
@@ -262,6 +429,104 @@ void BandageTests::pathFunctionsOnGfaSequencesInFasta()
     QCOMPARE(node282Minus->sequenceIsMissing(), false);
     QCOMPARE(node282Plus->getLength(), 1819);
     QCOMPARE(node282Minus->getLength(), 1819);
+
+    //Reading the sequences saved an index of the FASTA file.
+    QFile::remove(getTestDirectory() + "test_plasmids_separate_sequences.fasta.fai");
+}
+
+
+//Canu FASTA headers have a description after the name.  The sequences must be
+//found for the nodes whether the FASTA is read with an index (uncompressed)
+//or read whole (compressed).
+void BandageTests::canuSequencesInFasta()
+{
+    QString gfaFilename = getTestDirectory() + "canu_temp.gfa";
+    QFile gfaFile(gfaFilename);
+    gfaFile.open(QIODevice::WriteOnly);
+    gfaFile.write("S\ttig00000001\t*\tLN:i:8\n"
+                  "S\ttig00000002\t*\tLN:i:4\n"
+                  "L\ttig00000001\t+\ttig00000002\t+\t0M\n");
+    gfaFile.close();
+    QByteArray fasta = ">tig00000001 len=8 reads=12 covStat=1.00 gappedBases=no class=contig suggestRepeat=no suggestCircular=no\n"
+                       "ACGTACGT\n"
+                       ">tig00000002 len=4 reads=3 covStat=1.00 gappedBases=no class=contig suggestRepeat=no suggestCircular=no\n"
+                       "TTGC\n";
+
+    QStringList fastaFilenames;
+    fastaFilenames << "canu_temp.fasta" << "canu_temp.fasta.gz";
+    for (int i = 0; i < fastaFilenames.size(); ++i)
+    {
+        QString fastaFilename = getTestDirectory() + fastaFilenames[i];
+        RecordFileWriter writer(fastaFilename, i == 1);
+        QCOMPARE(writer.open(), true);
+        writer.write(fasta);
+        QCOMPARE(writer.close(), true);
+
+        createGlobals();
+        QCOMPARE(g_assemblyGraph->loadGraphFromFile(gfaFilename), true);
+        DeBruijnNode * node1Plus = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+        DeBruijnNode * node2Minus = g_assemblyGraph->m_deBruijnGraphNodes["2-"];
+        QVERIFY(node1Plus != 0);
+        QVERIFY(node2Minus != 0);
+        QCOMPARE(node1Plus->getSequence(), QByteArray("ACGTACGT"));
+        QCOMPARE(node2Minus->getSequence(), QByteArray("GCAA"));
+
+        QFile::remove(fastaFilename);
+        QFile::remove(fastaFilename + ".fai");
+    }
+    QFile::remove(gfaFilename);
+}
+
+
+//This test checks that sequences read using a FASTA index match those read
+//from the whole file, including when the cache is too small to hold them all.
+void BandageTests::fastaIndex()
+{
+    QString fastaFilename = getTestDirectory() + "test_plasmids_separate_sequences.fasta";
+    std::vector<QString> names;
+    std::vector<QByteArray> sequences;
+    AssemblyGraph::readFastaFile(fastaFilename, &names, &sequences);
+
+    //The first load builds the index and saves it as a .fai file, which the
+    //second load reads.  Both should give the same records.
+    QString indexFilename = fastaFilename + ".fai";
+    QFile::remove(indexFilename);
+    FastaIndex builtIndex(fastaFilename);
+    QCOMPARE(builtIndex.load(), true);
+    QCOMPARE(QFile::exists(indexFilename), true);
+    FastaIndex index(fastaFilename, 2000);
+    QCOMPARE(index.load(), true);
+    QCOMPARE(index.getRecordCount(), int(names.size()));
+    QCOMPARE(builtIndex.getRecordCount(), index.getRecordCount());
+    for (int i = 0; i < index.getRecordCount(); ++i)
+    {
+        QCOMPARE(builtIndex.getRecord(i).name, index.getRecord(i).name);
+        QCOMPARE(builtIndex.getRecord(i).length, index.getRecord(i).length);
+        QCOMPARE(builtIndex.getRecord(i).offset, index.getRecord(i).offset);
+    }
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int i = 0; i < index.getRecordCount(); ++i)
+        {
+            QCOMPARE(QString(index.getRecord(i).name), names[i]);
+            QCOMPARE(index.getSequence(i), sequences[i]);
+        }
+    }
+
+    //Nodes given an indexed sequence don't store it themselves.
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test_plasmids_separate_sequences.gfa");
+    DeBruijnNode * node282Plus = g_assemblyGraph->m_deBruijnGraphNodes["282+"];
+    DeBruijnNode * node282Minus = g_assemblyGraph->m_deBruijnGraphNodes["282-"];
+    QByteArray node282Sequence = node282Plus->getSequence();
+    QCOMPARE(node282Sequence.length(), 1819);
+    QCOMPARE(node282Plus->storedSequenceIsMissing(), true);
+    QCOMPARE(node282Plus->sequenceIsMissing(), false);
+    QCOMPARE(node282Minus->getSequence(), AssemblyGraph::getReverseComplement(node282Sequence));
+    QCOMPARE(node282Minus->getBaseAt(0), node282Minus->getSequence().at(0));
+
+    QFile::remove(indexFilename);
 }
 
 
@@ -390,6 +655,14 @@ void BandageTests::loadCsvData()
     QCOMPARE(node9Plus->getCsvLine(3), QString(""));
     QCOMPARE(node9Plus->getCsvLine(4), QString(""));
     QCOMPARE(node9Plus->getCsvLine(5), QString(""));
+
+    //The CSV data is stored by column, with one row for each matched line.
+    QCOMPARE(g_assemblyGraph->m_csvData.getRowCount(), 9);
+    QCOMPARE(g_assemblyGraph->m_csvData.isNumericColumn(0), false);
+    std::vector<QByteArray> fields;
+    QCOMPARE(AssemblyGraph::splitCsv("1,\"a,\"\"b\"\"\",,2.5", ',', &fields), 4);
+    QCOMPARE(fields[1], QByteArray("a,\"b\""));
+    QCOMPARE(fields[2], QByteArray(""));
 }
 
 
@@ -465,6 +738,34 @@ void BandageTests::blastSearch()
 
 
 
+//Splitting the queries between several BLAST processes should give the same
+//hits, in the same order, and the same query paths as a single process.
+void BandageTests::blastSearchShards()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    g_settings->blastQueryFilename = getTestDirectory() + "test_queries2.fasta";
+    createBlastTempDirectory();
+
+    g_settings->blastQueryShards = 1;
+    QCOMPARE(g_blastSearch->doAutoBlastSearch(), QString());
+    QStringList unshardedResults = getBlastResultStrings();
+    QCOMPARE(unshardedResults.isEmpty(), false);
+
+    g_settings->blastQueryShards = 4;
+    QCOMPARE(g_blastSearch->doAutoBlastSearch(), QString());
+    QCOMPARE(getBlastResultStrings(), unshardedResults);
+
+    //With more shards than queries, each query is searched on its own.
+    g_settings->blastQueryShards = 100;
+    QCOMPARE(g_blastSearch->doAutoBlastSearch(), QString());
+    QCOMPARE(getBlastResultStrings(), unshardedResults);
+
+    deleteBlastTempDirectory();
+}
+
+
+
 void BandageTests::blastSearchFilters()
 {
     createGlobals();
@@ -634,6 +935,39 @@ void BandageTests::graphScope()
     drawnNodes = g_assemblyGraph->getDrawnNodeCount();
     QCOMPARE(drawnNodes, 42);
 
+    //The depth range scope gives its starting nodes in name order.
+    for (size_t i = 1; i < startingNodes.size(); ++i)
+        QVERIFY(startingNodes[i - 1]->getName() < startingNodes[i]->getName());
+
+    //With a base distance of zero, the around bases scope draws the starting
+    //node and its neighbours, the same as one node step.
+    g_settings->graphScope = AROUND_BASES;
+    g_settings->startingNodes = "1";
+    g_settings->baseDistance = 0;
+    g_settings->doubleMode = false;
+    startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    g_assemblyGraph->layoutGraph();
+    drawnNodes = g_assemblyGraph->getDrawnNodeCount();
+    QCOMPARE(drawnNodes, 3);
+
+    //With a very large base distance, it draws the whole connected component,
+    //the same as a very large number of node steps.
+    g_settings->graphScope = AROUND_NODE;
+    g_settings->nodeDistance = 100;
+    startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    g_assemblyGraph->layoutGraph();
+    int componentNodes = g_assemblyGraph->getDrawnNodeCount();
+
+    g_settings->graphScope = AROUND_BASES;
+    g_settings->baseDistance = 1000000000;
+    startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "");
+    g_assemblyGraph->buildOgdfGraphFromNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    g_assemblyGraph->layoutGraph();
+    drawnNodes = g_assemblyGraph->getDrawnNodeCount();
+    QCOMPARE(drawnNodes, componentNodes);
+
     createBlastTempDirectory();
 
     g_settings->blastQueryFilename = getTestDirectory() + "test_queries1.fasta";
@@ -666,9 +1000,254 @@ void BandageTests::graphScope()
     drawnNodes = g_assemblyGraph->getDrawnNodeCount();
     QCOMPARE(drawnNodes, 9);
 
+    //Labelling the drawn nodes without building the OGDF graph should give
+    //the same nodes, and leave the OGDF graph empty.
+    startingNodes = g_assemblyGraph->getStartingNodes(&errorTitle, &errorMessage, g_settings->doubleMode, g_settings->startingNodes, "all");
+    g_assemblyGraph->labelDrawnNodesAndEdges(startingNodes, g_settings->nodeDistance);
+    drawnNodes = g_assemblyGraph->getDrawnNodeCount();
+    QCOMPARE(drawnNodes, 9);
+    QCOMPARE(g_assemblyGraph->m_ogdfGraph->numberOfNodes(), 0);
+
     deleteBlastTempDirectory();
 }
 
+
+//This function checks the neighbour search used by the graph scopes against
+//expanding the drawn set one step at a time.
+void BandageTests::neighbourSearch()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.Trinity.fasta");
+    g_settings->doubleMode = true;
+
+    //Use every tenth node as a starting node.
+    std::vector<DeBruijnNode *> startingNodes;
+    std::vector<DeBruijnNode *> allNodes;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        allNodes.push_back(i.value());
+        if (allNodes.size() % 10 == 0)
+            startingNodes.push_back(i.value());
+    }
+
+    for (int nodeDistance = 0; nodeDistance <= 5; ++nodeDistance)
+    {
+        QSet<DeBruijnNode *> expected;
+        for (size_t j = 0; j < startingNodes.size(); ++j)
+            expected.insert(startingNodes[j]);
+        for (int step = 0; step < nodeDistance; ++step)
+        {
+            QSet<DeBruijnNode *> nextStep = expected;
+            QSetIterator<DeBruijnNode *> j(expected);
+            while (j.hasNext())
+            {
+                DeBruijnNode * node = j.next();
+                const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+                for (size_t k = 0; k < edges->size(); ++k)
+                    nextStep.insert((*edges)[k]->getOtherNode(node));
+            }
+            expected = nextStep;
+        }
+
+        for (size_t j = 0; j < allNodes.size(); ++j)
+            allNodes[j]->setAsNotDrawn();
+        for (size_t j = 0; j < startingNodes.size(); ++j)
+            startingNodes[j]->setAsDrawn();
+        g_assemblyGraph->labelNeighbouringNodesAsDrawn(startingNodes, nodeDistance);
+
+        for (size_t j = 0; j < allNodes.size(); ++j)
+            QCOMPARE(allNodes[j]->isDrawn(), expected.contains(allNodes[j]));
+    }
+
+    //Check the base distance search against relaxing every edge until no
+    //distance changes.
+    QSet<DeBruijnNode *> startingNodeSet;
+    for (size_t j = 0; j < startingNodes.size(); ++j)
+        startingNodeSet.insert(startingNodes[j]);
+    for (int baseDistance = 0; baseDistance <= 2000; baseDistance += 250)
+    {
+        QHash<DeBruijnNode *, long long> distances;
+        for (size_t j = 0; j < startingNodes.size(); ++j)
+            distances[startingNodes[j]] = 0;
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            QHashIterator<DeBruijnNode *, long long> j(distances);
+            while (j.hasNext())
+            {
+                j.next();
+                DeBruijnNode * node = j.key();
+                bool startingNode = startingNodeSet.contains(node);
+                long long farDistance = startingNode ? 0 : j.value() + node->getLength();
+                const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+                for (size_t k = 0; k < edges->size(); ++k)
+                {
+                    DeBruijnEdge * edge = (*edges)[k];
+                    long long nextDistance = startingNode ? 0 : std::max(j.value(), farDistance - edge->getOverlap());
+                    DeBruijnNode * otherNode = edge->getOtherNode(node);
+                    if (nextDistance > baseDistance)
+                        continue;
+                    if (distances.contains(otherNode) && distances[otherNode] <= nextDistance)
+                        continue;
+                    distances[otherNode] = nextDistance;
+                    changed = true;
+                }
+            }
+        }
+
+        for (size_t j = 0; j < allNodes.size(); ++j)
+            allNodes[j]->setAsNotDrawn();
+        for (size_t j = 0; j < startingNodes.size(); ++j)
+            startingNodes[j]->setAsDrawn();
+        g_assemblyGraph->labelNodesWithinBasesAsDrawn(startingNodes, baseDistance);
+
+        for (size_t j = 0; j < allNodes.size(); ++j)
+            QCOMPARE(allNodes[j]->isDrawn(), distances.contains(allNodes[j]));
+    }
+}
+
+//The streaming reduce should choose the same segments as a reduce which
+//loads the whole graph.
+void BandageTests::streamingReduce()
+{
+    createGlobals();
+    QString filename = getTestDirectory() + "test_plasmids.gfa";
+    g_assemblyGraph->loadGraphFromFile(filename);
+    g_settings->doubleMode = true;
+
+    GfaTopology topology;
+    QCOMPARE(topology.load(filename), true);
+    QCOMPARE(topology.getSegmentCount(), 9);
+    QCOMPARE(topology.getLinkCount(), 12);
+
+    std::vector<DeBruijnNode *> segmentNodes;
+    for (int i = 0; i < topology.getSegmentCount(); ++i)
+    {
+        DeBruijnNode * node = g_assemblyGraph->m_deBruijnGraphNodes[topology.getSegmentName(i)];
+        QCOMPARE(node->getLength(), topology.getSegmentLength(i));
+        segmentNodes.push_back(node);
+    }
+
+    std::vector<DeBruijnNode *> allNodes;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        allNodes.push_back(i.value());
+    }
+
+    for (int segment = 0; segment < topology.getSegmentCount(); ++segment)
+    {
+        std::vector<QString> nodesNotFound;
+        QString nodeName = segmentNodes[segment]->getNameWithoutSign();
+        std::vector<int> startingSegments = topology.findSegments(nodeName, true, &nodesNotFound);
+        QCOMPARE(nodesNotFound.size(), size_t(0));
+        std::vector<DeBruijnNode *> startingNodes = g_assemblyGraph->getNodesFromString(nodeName, true);
+
+        for (int test = 0; test < 7; ++test)
+        {
+            std::vector<char> selected;
+            for (size_t j = 0; j < allNodes.size(); ++j)
+                allNodes[j]->setAsNotDrawn();
+            for (size_t j = 0; j < startingNodes.size(); ++j)
+                startingNodes[j]->setAsDrawn();
+            if (test < 4)
+            {
+                selected = topology.selectWithinSteps(startingSegments, test);
+                g_assemblyGraph->labelNeighbouringNodesAsDrawn(startingNodes, test);
+            }
+            else
+            {
+                int baseDistance = (test - 4) * 2000;
+                selected = topology.selectWithinBases(startingSegments, baseDistance);
+                g_assemblyGraph->labelNodesWithinBasesAsDrawn(startingNodes, baseDistance);
+            }
+
+            for (int j = 0; j < topology.getSegmentCount(); ++j)
+                QCOMPARE(bool(selected[j]), segmentNodes[j]->isDrawn() ||
+                                            segmentNodes[j]->getReverseComplement()->isDrawn());
+        }
+    }
+
+    //The subgraph file should hold only the selected segments and the links
+    //between them.
+    std::vector<int> startingSegments = topology.findSegments(segmentNodes[0]->getNameWithoutSign(), true, 0);
+    std::vector<char> selected = topology.selectWithinSteps(startingSegments, 1);
+    int selectedCount = int(std::count(selected.begin(), selected.end(), 1));
+    QString subgraphFilename = getTestDirectory() + "test_temp.gfa";
+    QCOMPARE(topology.writeSubgraph(filename, subgraphFilename, selected), true);
+
+    GfaTopology subgraph;
+    QCOMPARE(subgraph.load(subgraphFilename), true);
+    QCOMPARE(subgraph.getSegmentCount(), selectedCount);
+    createGlobals();
+    QCOMPARE(g_assemblyGraph->loadGraphFromFile(subgraphFilename), true);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), selectedCount * 2);
+    QFile::remove(subgraphFilename);
+}
+
+
+//Reducing a GFA with --stream should give the same graph as loading it first,
+//for each of the scopes which --stream supports.  The input has a duplicated
+//segment, which should only be saved once.
+void BandageTests::streamingReduceMatchesReduce()
+{
+    QString testGfa = getTestDirectory() + "test_plasmids.gfa";
+    QFile testFile(testGfa);
+    QVERIFY(testFile.open(QIODevice::ReadOnly));
+    QByteArray contents = testFile.readAll();
+    testFile.close();
+    int firstLineEnd = contents.indexOf('\n') + 1;
+    contents.insert(firstLineEnd, contents.left(firstLineEnd));
+
+    QString inputFilename = getTestDirectory() + "test_temp_input.gfa";
+    QFile inputFile(inputFilename);
+    QVERIFY(inputFile.open(QIODevice::WriteOnly));
+    inputFile.write(contents);
+    inputFile.close();
+
+    QString outputFilename = getTestDirectory() + "test_temp.gfa";
+    QString streamOutputFilename = getTestDirectory() + "test_temp_stream.gfa";
+
+    QList<QStringList> scopeArguments;
+    scopeArguments << (QStringList() << "--scope" << "entire");
+    scopeArguments << (QStringList() << "--scope" << "aroundnodes" << "--nodes" << "232" << "--distance" << "1");
+    scopeArguments << (QStringList() << "--scope" << "aroundnodes" << "--nodes" << "6,289" << "--distance" << "0");
+    scopeArguments << (QStringList() << "--scope" << "aroundbases" << "--nodes" << "232" << "--distancebp" << "1000");
+
+    for (int i = 0; i < scopeArguments.size(); ++i)
+    {
+        QStringList arguments = QStringList() << inputFilename << outputFilename << scopeArguments[i] << "--double";
+        QStringList streamArguments = QStringList() << inputFilename << streamOutputFilename << scopeArguments[i] << "--double" << "--stream";
+
+        createGlobals();
+        QCOMPARE(bandageReduce(arguments), 0);
+        createGlobals();
+        QCOMPARE(bandageReduce(streamArguments), 0);
+
+        int segmentLineCount = countGfaSegmentLines(outputFilename);
+        QCOMPARE(countGfaSegmentLines(streamOutputFilename), segmentLineCount);
+
+        createGlobals();
+        QCOMPARE(g_assemblyGraph->loadGraphFromFile(outputFilename), true);
+        QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), segmentLineCount * 2);
+        QSet<QString> nodes = getNodeStrings();
+        QSet<QString> edges = getEdgeStrings();
+
+        createGlobals();
+        QCOMPARE(g_assemblyGraph->loadGraphFromFile(streamOutputFilename), true);
+        QCOMPARE(getNodeStrings(), nodes);
+        QCOMPARE(getEdgeStrings(), edges);
+    }
+
+    QFile::remove(inputFilename);
+    QFile::remove(outputFilename);
+    QFile::remove(streamOutputFilename);
+}
+
 void BandageTests::commandLineSettings()
 {
     createGlobals();
@@ -690,6 +1269,10 @@ void BandageTests::commandLineSettings()
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->graphScope, DEPTH_RANGE);
 
+    commandLineSettings = QString("--scope aroundbases").split(" ");
+    parseSettings(commandLineSettings);
+    QCOMPARE(g_settings->graphScope, AROUND_BASES);
+
     commandLineSettings = QString("--nodes 5+").split(" ");
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->startingNodes, QString("5+"));
@@ -707,6 +1290,10 @@ void BandageTests::commandLineSettings()
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->nodeDistance.val, 12);
 
+    commandLineSettings = QString("--distancebp 5000").split(" ");
+    parseSettings(commandLineSettings);
+    QCOMPARE(g_settings->baseDistance.val, 5000);
+
     commandLineSettings = QString("--mindepth 1.2").split(" ");
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->minDepthRange.val, 1.2);
@@ -895,6 +1482,11 @@ void BandageTests::commandLineSettings()
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->blastSearchParameters, QString("--abc"));
 
+    commandLineSettings = QString("--blastthreads 12 --blastshards 3").split(" ");
+    parseSettings(commandLineSettings);
+    QCOMPARE(g_settings->blastThreads.val, 12);
+    QCOMPARE(g_settings->blastQueryShards.val, 3);
+
     QCOMPARE(g_settings->blastAlignmentLengthFilter.on, false);
     commandLineSettings = QString("--alfilter 543").split(" ");
     parseSettings(commandLineSettings);
@@ -1082,6 +1674,76 @@ void BandageTests::graphEdits()
 
     DeBruijnNode * mergedNode = g_assemblyGraph->m_deBruijnGraphNodes["6_26_copy_23_26_24+"];
     QCOMPARE(pathSequence, mergedNode->getSequence());
+
+    //The deleted nodes leave empty IDs in the node attribute table until it
+    //is compacted, after which every node should still find its own
+    //attributes.
+    QCOMPARE(g_assemblyGraph->m_nodeAttributes.size() - g_assemblyGraph->m_nodeAttributes.getEmptyCount(), 82);
+    g_assemblyGraph->m_nodeAttributes.compact();
+    QCOMPARE(g_assemblyGraph->m_nodeAttributes.size(), 82);
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = i.value();
+        QCOMPARE(g_assemblyGraph->m_nodeAttributes.m_nodes[node->getId()], node);
+        QCOMPARE(bool(g_assemblyGraph->m_nodeAttributes.m_positive[node->getId()]), node->isPositiveNode());
+    }
+    QCOMPARE(mergedNode->getLength(), pathSequence.length());
+}
+
+
+//Deleting many nodes and edges at once should leave the node map, edge map
+//and each node's edges consistent with each other.
+void BandageTests::bulkDeletion()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    std::vector<DeBruijnNode *> nodesToDelete;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnNode * node = i.value();
+        if (node->isPositiveNode() && node->getNameWithoutSign().toInt() % 3 != 0)
+            nodesToDelete.push_back(node);
+    }
+    DeBruijnNode * node12 = g_assemblyGraph->m_deBruijnGraphNodes["12+"];
+    DeBruijnNode * node36 = g_assemblyGraph->m_deBruijnGraphNodes["36-"];
+    std::vector<DeBruijnEdge *> edgesToDelete;
+    edgesToDelete.push_back(getEdgeFromNodeNames("12+", "36-"));
+    QCOMPARE(edgesToDelete[0] != 0, true);
+    g_assemblyGraph->deleteNodesAndEdges(&nodesToDelete, &edgesToDelete);
+
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 88 - 2 * int(nodesToDelete.size()));
+    QCOMPARE(g_assemblyGraph->getComponents()->getComponentCount() > 0, true);
+
+    int edgeCount = 0;
+    QMapIterator<QString, DeBruijnNode*> j(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (j.hasNext())
+    {
+        j.next();
+        DeBruijnNode * node = j.value();
+        QCOMPARE(node->getNameWithoutSign().toInt() % 3, 0);
+        QCOMPARE(g_assemblyGraph->m_nodeAttributes.m_nodes[node->getId()], node);
+        const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+        for (size_t k = 0; k < edges->size(); ++k)
+        {
+            DeBruijnEdge * edge = (*edges)[k];
+            QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.contains(edge->getOtherNode(node)->getName()), true);
+            QCOMPARE(g_assemblyGraph->m_deBruijnGraphEdges.value(QPair<DeBruijnNode*, DeBruijnNode*>(edge->getStartingNode(), edge->getEndingNode())), edge);
+            if (edge->getStartingNode() == node)
+                ++edgeCount;
+        }
+    }
+    QCOMPARE(edgeCount, int(g_assemblyGraph->m_deBruijnGraphEdges.size()));
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphEdges.contains(QPair<DeBruijnNode*, DeBruijnNode*>(node12, node36)), false);
+
+    //More than half of the nodes were deleted, so the node attribute table
+    //should have been compacted.
+    QCOMPARE(g_assemblyGraph->m_nodeAttributes.getEmptyCount(), 0);
+    QCOMPARE(g_assemblyGraph->m_nodeAttributes.size(), g_assemblyGraph->m_deBruijnGraphNodes.size());
 }
 
 
@@ -1189,6 +1851,192 @@ void BandageTests::spadesToGfa()
 }
 
 
+//Graphs saved with a .gz name should be block-gzipped copies of the plain
+//files.
+void BandageTests::compressedGraphOutput()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    QStringList filenames;
+    filenames << "test_temp.gfa" << "test_temp.gfa.gz" << "test_temp.fasta" << "test_temp.fasta.gz";
+    QCOMPARE(g_assemblyGraph->saveEntireGraphToGfa(getTestDirectory() + filenames[0]), true);
+    QCOMPARE(g_assemblyGraph->saveEntireGraphToGfa(getTestDirectory() + filenames[1]), true);
+    g_assemblyGraph->saveEntireGraphToFasta(getTestDirectory() + filenames[2]);
+    g_assemblyGraph->saveEntireGraphToFasta(getTestDirectory() + filenames[3]);
+
+    QList<QByteArray> contents;
+    for (int i = 0; i < filenames.size(); ++i)
+    {
+        CompressedFile file(getTestDirectory() + filenames[i]);
+        QCOMPARE(file.open(QIODevice::ReadOnly), true);
+        QCOMPARE(file.getCompression(), (i % 2 == 1) ? GZIP_COMPRESSION : NO_COMPRESSION);
+        contents.push_back(file.readAll());
+    }
+    QCOMPARE(contents[0], contents[1]);
+    QCOMPARE(contents[2], contents[3]);
+    QCOMPARE(contents[0].count("\nS\t") + 1, 44);
+    QCOMPARE(contents[2].count('>'), 88);
+
+    //Data which doesn't compress has to be stored in its block.
+    QByteArray randomData(70000, '\0');
+    for (int i = 0; i < randomData.length(); ++i)
+        randomData[i] = char(rand() % 256);
+    QByteArray block = RecordFileWriter::compressBgzfBlock(randomData.constData(), 65280);
+    QVERIFY(block.length() > 65280);
+    QVERIFY(block.length() <= 65536);
+
+    createGlobals();
+    QCOMPARE(g_assemblyGraph->loadGraphFromFile(getTestDirectory() + filenames[1]), true);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 88);
+
+    for (int i = 0; i < filenames.size(); ++i)
+        QFile::remove(getTestDirectory() + filenames[i]);
+}
+
+
+//GFA P and W lines are loaded into the path store, which gives each path's
+//nodes and the paths through each node.
+void BandageTests::gfaPaths()
+{
+    createGlobals();
+    QString gfaFilename = getTestDirectory() + "test_paths_temp.gfa";
+    QFile gfaFile(gfaFilename);
+    gfaFile.open(QIODevice::WriteOnly);
+    gfaFile.write("H\tVN:Z:1.0\n"
+                  "P\tp1\t1+,2+,3-\t*\n"
+                  "S\t1\tACGTACGT\n"
+                  "S\t2\tTTTT\n"
+                  "S\t3\tGGGCC\n"
+                  "L\t1\t+\t2\t+\t0M\n"
+                  "L\t2\t+\t3\t-\t0M\n"
+                  "P\tp2\t3+,2-,1-\t*\n"
+                  "P\tp3\t1+,4+\t*\n"
+                  "W\tsample\t1\tchr1\t0\t17\t>1>2<3\n"
+                  "W\tsample\t2\tchr1\t*\t*\t>1>2\n"
+                  "S\t5\tAAAAA\n"
+                  "S\t6\tCCCCC\n"
+                  "S\t7\tGGGGG\n"
+                  "S\t8\tTTTTT\n"
+                  "P\tp4\t7+,1-\t*\n");
+    gfaFile.close();
+    QCOMPARE(g_assemblyGraph->loadGraphFromFile(gfaFilename), true);
+
+    //The path using a segment which isn't in the graph is left out.
+    const GfaPathStore & store = g_assemblyGraph->m_gfaPaths;
+    QCOMPARE(store.getPathCount(), 5);
+    QCOMPARE(store.getPathName(2), QString("sample#1#chr1:0-17"));
+    QCOMPARE(store.getPathName(3), QString("sample#2#chr1"));
+    QCOMPARE(store.findPath("p2"), 1);
+    QCOMPARE(store.findPath("p3"), -1);
+    QCOMPARE(store.getStepCount(0), 3);
+    QCOMPARE(store.getStepCount(3), 2);
+
+    DeBruijnNode * node1Plus = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    DeBruijnNode * node1Minus = g_assemblyGraph->m_deBruijnGraphNodes["1-"];
+    DeBruijnNode * node3Plus = g_assemblyGraph->m_deBruijnGraphNodes["3+"];
+    DeBruijnNode * node3Minus = g_assemblyGraph->m_deBruijnGraphNodes["3-"];
+    std::vector<DeBruijnNode *> p1Nodes = store.getPathNodes(0, g_assemblyGraph->m_nodeAttributes);
+    QCOMPARE(int(p1Nodes.size()), 3);
+    QCOMPARE(p1Nodes[0], node1Plus);
+    QCOMPARE(p1Nodes[2], node3Minus);
+    QVERIFY(store.getPathsThroughNode(node1Plus->getId()) == std::vector<int>({0, 2, 3}));
+    QVERIFY(store.getPathsThroughNode(node1Minus->getId()) == std::vector<int>({1, 4}));
+    QCOMPARE(store.getPathCountThroughNode(node3Minus->getId()), 2);
+    QCOMPARE(store.getPathCountThroughNode(node3Plus->getId()), 1);
+
+    Path p1 = g_assemblyGraph->makePathFromGfaPath(0);
+    QCOMPARE(p1.getPathSequence(), QByteArray("ACGTACGTTTTTGGCCC"));
+    QCOMPARE(g_assemblyGraph->makePathFromGfaPath(1).getPathSequence(), QByteArray("GGGCCAAAAACGTACGT"));
+
+    QString fastaFilename = getTestDirectory() + "test_paths_temp.fasta";
+    //The last path doesn't follow the graph's edges, so it is left out.
+    QCOMPARE(g_assemblyGraph->saveGfaPathsToFasta(fastaFilename), true);
+    QFile fastaFile(fastaFilename);
+    fastaFile.open(QIODevice::ReadOnly);
+    QCOMPARE(fastaFile.readAll(), QByteArray(">p1\nACGTACGTTTTTGGCCC\n"
+                                             ">p2\nGGGCCAAAAACGTACGT\n"
+                                             ">sample#1#chr1:0-17\nACGTACGTTTTTGGCCC\n"
+                                             ">sample#2#chr1\nACGTACGTTTTT\n"));
+    fastaFile.close();
+    QFile::remove(fastaFilename);
+
+    //Colouring by a path only colours the nodes it passes through.
+    g_assemblyGraph->colourNodesByGfaPaths(std::vector<int>({3}));
+    QCOMPARE(node1Plus->hasCustomColour(), true);
+    QCOMPARE(node1Minus->hasCustomColour(), true);
+    QCOMPARE(node3Plus->hasCustomColour(), false);
+
+    //Deleting nodes drops the paths through them.  Enough nodes are deleted
+    //here for the node IDs to be compacted, so the remaining paths have to
+    //be given the new IDs.
+    DeBruijnNode * node7Plus = g_assemblyGraph->m_deBruijnGraphNodes["7+"];
+    int node7PlusOldId = node7Plus->getId();
+    std::vector<DeBruijnNode *> nodesToDelete;
+    nodesToDelete.push_back(node3Plus);
+    nodesToDelete.push_back(g_assemblyGraph->m_deBruijnGraphNodes["5+"]);
+    nodesToDelete.push_back(g_assemblyGraph->m_deBruijnGraphNodes["6+"]);
+    nodesToDelete.push_back(g_assemblyGraph->m_deBruijnGraphNodes["8+"]);
+    QCOMPARE(g_assemblyGraph->deleteNodes(&nodesToDelete), 3);
+    QCOMPARE(g_assemblyGraph->m_nodeAttributes.getEmptyCount(), 0);
+    QVERIFY(node7Plus->getId() != node7PlusOldId);
+    QCOMPARE(store.getPathCount(), 2);
+    QCOMPARE(store.getPathName(0), QString("sample#2#chr1"));
+    QCOMPARE(store.getPathName(1), QString("p4"));
+    QCOMPARE(store.findPath("p4"), 1);
+    QCOMPARE(store.findPath("p1"), -1);
+    std::vector<DeBruijnNode *> p4Nodes = store.getPathNodes(1, g_assemblyGraph->m_nodeAttributes);
+    QVERIFY(p4Nodes == std::vector<DeBruijnNode *>({node7Plus, node1Minus}));
+    QVERIFY(store.getPathsThroughNode(node1Plus->getId()) == std::vector<int>({0}));
+    QVERIFY(store.getPathsThroughNode(node1Minus->getId()) == std::vector<int>({1}));
+    QVERIFY(store.getPathsThroughNode(node7Plus->getId()) == std::vector<int>({1}));
+    QCOMPARE(g_assemblyGraph->makePathFromGfaPath(0).getPathSequence(), QByteArray("ACGTACGTTTTT"));
+
+    //A larger graph: a chain of segments with many paths along it.
+    gfaFile.open(QIODevice::WriteOnly);
+    gfaFile.write("H\tVN:Z:1.0\n");
+    QByteArray steps;
+    for (int i = 1; i <= 1000; ++i)
+    {
+        gfaFile.write("S\t" + QByteArray::number(i) + "\tACGTACGTAC\n");
+        if (i > 1)
+            gfaFile.write("L\t" + QByteArray::number(i - 1) + "\t+\t" + QByteArray::number(i) + "\t+\t0M\n");
+        steps += (i > 1 ? "," : "") + QByteArray::number(i) + "+";
+    }
+    for (int i = 0; i < 200; ++i)
+        gfaFile.write("P\tpath" + QByteArray::number(i) + "\t" + steps + "\t*\n");
+    gfaFile.write("P\tpartial\t10+,11+,12+\t*\n");
+    gfaFile.write("P\treverse\t3-,2-,1-\t*\n");
+    gfaFile.close();
+
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(gfaFilename);
+    QCOMPARE(g_assemblyGraph->m_gfaPaths.getPathCount(), 202);
+    QCOMPARE(g_assemblyGraph->m_gfaPaths.getPathCountThroughNode(g_assemblyGraph->m_deBruijnGraphNodes["500+"]->getId()), 200);
+    QCOMPARE(g_assemblyGraph->makePathFromGfaPath(199).getLength(), 10000);
+    QFile::remove(gfaFilename);
+
+    //Merging the chain moves each path's run of steps along it onto the
+    //merged node, so no paths are lost.
+    QCOMPARE(g_assemblyGraph->mergeAllPossible(), 1);
+    QCOMPARE(g_assemblyGraph->m_deBruijnGraphNodes.size(), 2);
+    DeBruijnNode * mergedNode = g_assemblyGraph->m_deBruijnGraphNodes.first();
+    if (!mergedNode->isPositiveNode())
+        mergedNode = mergedNode->getReverseComplement();
+    const GfaPathStore & chainStore = g_assemblyGraph->m_gfaPaths;
+    QCOMPARE(chainStore.getPathCount(), 202);
+    for (int i = 0; i < chainStore.getPathCount(); ++i)
+        QCOMPARE(chainStore.getStepCount(i), 1);
+    QVERIFY(chainStore.getPathNodes(199, g_assemblyGraph->m_nodeAttributes) == std::vector<DeBruijnNode *>({mergedNode}));
+    QVERIFY(chainStore.getPathNodes(chainStore.findPath("partial"), g_assemblyGraph->m_nodeAttributes) ==
+            std::vector<DeBruijnNode *>({mergedNode}));
+    QVERIFY(chainStore.getPathNodes(chainStore.findPath("reverse"), g_assemblyGraph->m_nodeAttributes) ==
+            std::vector<DeBruijnNode *>({mergedNode->getReverseComplement()}));
+    QCOMPARE(chainStore.getPathCountThroughNode(mergedNode->getId()), 201);
+    QCOMPARE(g_assemblyGraph->makePathFromGfaPath(199).getLength(), 10000);
+}
+
+
 void BandageTests::mergeNodesOnGfa()
 {
     createGlobals();
@@ -1234,6 +2082,12 @@ void BandageTests::mergeNodesOnGfa()
     //the overlaps.
     DeBruijnNode * lastNode = g_assemblyGraph->m_deBruijnGraphNodes.first();
     QCOMPARE(lastNode->getLength(), nodeTotalLength - 5 * 81);
+    QCOMPARE(lastNode->getReverseComplement()->getSequence(), AssemblyGraph::getReverseComplement(lastNode->getSequence()));
+
+    //The edge which closed the loop should now loop the merged node back to
+    //itself (along with its reverse complement edge).
+    QCOMPARE(int(g_assemblyGraph->m_deBruijnGraphEdges.size()), 2);
+    QCOMPARE(lastNode->getSelfLoopingEdge() != 0, true);
 
     //If we make a circular path with this node, its length should be equal to
     //the length of the path made before.
@@ -1248,6 +2102,102 @@ void BandageTests::mergeNodesOnGfa()
 
 
 
+//mergeAllPossible finds all of the chains and merges them together.  This
+//test checks that it gives the same nodes and edges as finding the chains
+//and merging them one at a time with mergeNodes, as it used to, on a graph
+//with branches, cycles, self-loops and chains which switch strands.
+void BandageTests::mergeAllPossibleMatchesOneAtATime()
+{
+    QString gfaFilename = getTestDirectory() + "test_merge_temp.gfa";
+    QFile gfaFile(gfaFilename);
+    gfaFile.open(QIODevice::WriteOnly);
+    gfaFile.write("H\tVN:Z:1.0\n"
+                  "S\t1\tACGTTGCAAT\n"
+                  "S\t2\tAATCCGGA\n"
+                  "S\t3\tGTATCCGGCTT\n"
+                  "S\t4\tTACGGTACCA\n"
+                  "S\t5\tCCATTTGAGC\n"
+                  "S\t6\tCCAGGGTTTA\n"
+                  "S\t7\tAGCTTACCAT\n"
+                  "S\t8\tGGGCATGGG\n"
+                  "S\t9\tTTTACGATCAG\n"
+                  "S\t10\tCAGATTGGG\n"
+                  "S\t11\tCGTTCGAACG\n"
+                  "S\t12\tAACCGTTCG\n"
+                  "S\t13\tACACACACAC\n"
+                  "S\t14\tTTAGGCCTAG\n"
+                  "S\t15\tTAGCATCA\n"
+                  "S\t16\tTCATTTTGGCAT\n"
+                  "S\t17\tCATGGA\n"
+                  "L\t1\t+\t2\t+\t3M\n"
+                  "L\t2\t+\t3\t-\t3M\n"
+                  "L\t3\t-\t4\t+\t3M\n"
+                  "L\t4\t+\t5\t+\t3M\n"
+                  "L\t4\t+\t6\t+\t3M\n"
+                  "L\t5\t+\t7\t+\t3M\n"
+                  "L\t7\t+\t5\t+\t3M\n"
+                  "L\t8\t+\t8\t+\t3M\n"
+                  "L\t9\t+\t10\t+\t3M\n"
+                  "L\t10\t+\t8\t+\t3M\n"
+                  "L\t12\t+\t11\t+\t3M\n"
+                  "L\t11\t+\t11\t-\t4M\n"
+                  "L\t6\t+\t14\t+\t3M\n"
+                  "L\t14\t+\t15\t+\t3M\n"
+                  "L\t15\t+\t16\t+\t3M\n"
+                  "L\t16\t+\t17\t+\t3M\n");
+    gfaFile.close();
+
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(gfaFilename);
+    int oneAtATimeMerges = mergeAllPossibleOneAtATime();
+    QMap<QString, QByteArray> oneAtATimeSequences;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        oneAtATimeSequences.insert(i.key(), i.value()->getSequence());
+    }
+    QSet<QString> oneAtATimeEdges = getEdgeStrings();
+
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(gfaFilename);
+    int merges = g_assemblyGraph->mergeAllPossible();
+    QMap<QString, QByteArray> sequences;
+    QMapIterator<QString, DeBruijnNode*> j(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (j.hasNext())
+    {
+        j.next();
+        sequences.insert(j.key(), j.value()->getSequence());
+        QVERIFY(edgeRangesMatchEdges(j.value()));
+    }
+    QSet<QString> edges = getEdgeStrings();
+
+    QCOMPARE(merges, oneAtATimeMerges);
+    QCOMPARE(merges, 5);
+    QCOMPARE(sequences, oneAtATimeSequences);
+    QVERIFY(sequences.contains("1_2_3_4+"));
+    QVERIFY(sequences.contains("6_14_15_16_17+"));
+    QVERIFY(sequences.contains("8+"));
+    QCOMPARE(sequences["1_2_3_4-"], AssemblyGraph::getReverseComplement(sequences["1_2_3_4+"]));
+
+    //Merging one at a time lost the edges from a chain's end back to its own
+    //start (the 5_7 cycle) or to its own reverse complement (the 12_11
+    //hairpin), as those edges were made to the original nodes just before
+    //they were deleted.  Those are the only edges allowed to differ.
+    QSet<QString> missingEdges = oneAtATimeEdges;
+    missingEdges.subtract(edges);
+    QVERIFY(missingEdges.isEmpty());
+    QSet<QString> extraEdges = edges;
+    extraEdges.subtract(oneAtATimeEdges);
+    QSet<QString> expectedExtraEdges;
+    expectedExtraEdges << "5_7+\t5_7+\t3" << "5_7-\t5_7-\t3" << "12_11+\t12_11-\t4";
+    QCOMPARE(extraEdges, expectedExtraEdges);
+
+    QFile::remove(gfaFilename);
+}
+
+
+
 void BandageTests::changeNodeNames()
 {
     createGlobals();
@@ -1268,6 +2218,44 @@ void BandageTests::changeNodeNames()
     QCOMPARE(nodeCountBefore, nodeCountAfter);
 }
 
+
+//Partial node name searches use an index, which must give the same nodes
+//(in the same order) as checking every node name.
+void BandageTests::partialNodeNameSearch()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    QStringList queries;
+    queries << "1" << "12" << "2+" << "3-" << "+" << "-" << "40+" << "123" << "xyz";
+    for (int i = 0; i < queries.size(); ++i)
+    {
+        std::vector<DeBruijnNode *> expected;
+        QMapIterator<QString, DeBruijnNode*> j(g_assemblyGraph->m_deBruijnGraphNodes);
+        while (j.hasNext())
+        {
+            j.next();
+            if (j.key().contains(queries[i]))
+                expected.push_back(j.value());
+        }
+        std::vector<QString> nodesNotInGraph;
+        std::vector<DeBruijnNode *> found = g_assemblyGraph->getNodesFromString(queries[i], false, &nodesNotInGraph);
+        QVERIFY(found == expected);
+        QCOMPARE(nodesNotInGraph.size(), size_t(expected.empty() ? 1 : 0));
+    }
+    QCOMPARE(g_assemblyGraph->getNodesFromString("2+", false).size(), size_t(5));
+
+    //The index is rebuilt when nodes are renamed or deleted.
+    QCOMPARE(g_assemblyGraph->getNodesFromString("2345", false).size(), size_t(0));
+    g_assemblyGraph->changeNodeName("6", "12345");
+    std::vector<DeBruijnNode *> renamedNodes = g_assemblyGraph->getNodesFromString("2345", false);
+    QCOMPARE(renamedNodes.size(), size_t(2));
+    QCOMPARE(renamedNodes[0]->getName(), QString("12345+"));
+    QCOMPARE(renamedNodes[1]->getName(), QString("12345-"));
+    g_assemblyGraph->deleteNodes(&renamedNodes);
+    QCOMPARE(g_assemblyGraph->getNodesFromString("2345", false).size(), size_t(0));
+}
+
 void BandageTests::changeNodeDepths()
 {
     createGlobals();
@@ -1431,6 +2419,213 @@ void BandageTests::blastQueryPaths()
 }
 
 
+//The query path search must find the same paths, in the same order, as the
+//exhaustive search it replaced.  The FASTG graph has edge overlaps, so the
+//lengths depend on them.
+void BandageTests::allPossiblePathsWithOverlaps()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    QList<DeBruijnNode *> nodes = g_assemblyGraph->m_deBruijnGraphNodes.values();
+    int pathCount = 0;
+    for (int i = 0; i < nodes.size(); i += 4)
+    {
+        for (int j = 0; j < nodes.size(); ++j)
+        {
+            GraphLocation startLocation(nodes[i], (nodes[i]->getLength() + 1) / 2);
+            GraphLocation endLocation(nodes[j], (nodes[j]->getLength() + 1) / 2);
+            QList<int> expectedLengths;
+            QList<QList<DeBruijnNode *> > expectedPaths =
+                    getAllPossiblePathsExhaustively(startLocation, endLocation, 5, 1, 3000, &expectedLengths);
+            QList<Path> paths = Path::getAllPossiblePaths(startLocation, endLocation, 5, 1, 3000);
+
+            QCOMPARE(paths.size(), expectedPaths.size());
+            for (int k = 0; k < paths.size(); ++k)
+            {
+                QVERIFY(paths[k].getNodes() == expectedPaths[k]);
+                QCOMPARE(paths[k].getLength(), expectedLengths[k]);
+                QVERIFY(paths[k].getStartLocation() == startLocation);
+                QVERIFY(paths[k].getEndLocation() == endLocation);
+            }
+            pathCount += paths.size();
+        }
+    }
+    QVERIFY(pathCount > 0);
+}
+
+
+void BandageTests::pathSubsetElimination()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    //Make every path of up to five nodes in the graph.  Many of these are
+    //sub-paths of others.
+    QList<Path> paths;
+    QList<Path> currentPaths;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        QList<DeBruijnNode *> nodes;
+        nodes.push_back(i.value());
+        currentPaths.push_back(Path::makeFromOrderedNodes(nodes, false));
+    }
+    for (int j = 0; j < 5; ++j)
+    {
+        paths.append(currentPaths);
+        QList<Path> nextPaths;
+        for (int k = 0; k < currentPaths.size(); ++k)
+            nextPaths.append(currentPaths[k].extendPathInAllPossibleWays());
+        currentPaths = nextPaths;
+    }
+
+    //The indexed elimination should agree with comparing every pair.
+    std::vector<bool> subsetPaths = Path::findPathsWithNodeSubsets(paths);
+    int subsetCount = 0;
+    for (int j = 0; j < paths.size(); ++j)
+    {
+        bool hasSubset = false;
+        for (int k = 0; k < paths.size() && !hasSubset; ++k)
+            hasSubset = (j != k && paths[j].hasNodeSubset(paths[k]));
+        QCOMPARE(bool(subsetPaths[j]), hasSubset);
+        if (hasSubset)
+            ++subsetCount;
+    }
+    QVERIFY(subsetCount > 0);
+}
+
+
+//This function checks that each node's leaving and entering edge ranges stay
+//in agreement with its edges as the graph is edited.
+void BandageTests::edgeRanges()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+
+    int leavingEdgeCount = 0;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        QVERIFY(edgeRangesMatchEdges(i.value()));
+        leavingEdgeCount += i.value()->getLeavingEdgeCount();
+    }
+    QCOMPARE(leavingEdgeCount, g_assemblyGraph->m_deBruijnGraphEdges.size());
+
+    //Adding an edge which already exists should do nothing.
+    DeBruijnNode * node1 = g_assemblyGraph->m_deBruijnGraphNodes["1+"];
+    QVERIFY(node1->getLeavingEdgeCount() > 0);
+    int node1EdgeCount = int(node1->getEdgesPointer()->size());
+    DeBruijnEdge * existingEdge = node1->getLeavingEdgeRange()[0];
+    g_assemblyGraph->createDeBruijnEdge(node1->getName(), existingEdge->getEndingNode()->getName());
+    QCOMPARE(int(node1->getEdgesPointer()->size()), node1EdgeCount);
+
+    //Add a self-looping edge and an edge which is its own pair, then remove
+    //some edges, checking the ranges after each change.
+    g_assemblyGraph->createDeBruijnEdge("1+", "1+");
+    g_assemblyGraph->createDeBruijnEdge("2+", "2-");
+    DeBruijnNode * node2 = g_assemblyGraph->m_deBruijnGraphNodes["2+"];
+    QVERIFY(node1->getSelfLoopingEdge() != 0);
+    QVERIFY(node2->doesNodeLeadAway(g_assemblyGraph->m_deBruijnGraphNodes["2-"]) != 0);
+    QVERIFY(edgeRangesMatchEdges(node1));
+    QVERIFY(edgeRangesMatchEdges(node2));
+    QVERIFY(edgeRangesMatchEdges(node2->getReverseComplement()));
+
+    std::vector<DeBruijnEdge *> edgesToDelete;
+    edgesToDelete.push_back(existingEdge);
+    edgesToDelete.push_back(existingEdge->getReverseComplement());
+    edgesToDelete.push_back(node1->getSelfLoopingEdge());
+    edgesToDelete.push_back(node1->getReverseComplement()->getSelfLoopingEdge());
+    g_assemblyGraph->deleteEdges(&edgesToDelete);
+    QVERIFY(node1->getSelfLoopingEdge() == 0);
+    QCOMPARE(int(node1->getEdgesPointer()->size()), node1EdgeCount - 1);
+
+    i.toFront();
+    while (i.hasNext())
+    {
+        i.next();
+        QVERIFY(edgeRangesMatchEdges(i.value()));
+    }
+}
+
+
+//This function checks the FASTA reader, with and without memory mapping.
+void BandageTests::readFastaFile()
+{
+    createGlobals();
+    QString filename = getTestDirectory() + "test.Trinity.fasta";
+
+    std::vector<QString> names;
+    std::vector<QByteArray> sequences;
+    AssemblyGraph::readFastaFile(filename, &names, &sequences);
+    QCOMPARE(int(names.size()), 93);
+    QCOMPARE(int(sequences.size()), 93);
+    QCOMPARE(names[0], QString("TR1|c0_g1_i1 len=280 path=[274:0-228 275:229-279] [-1, 274, 275, -2]"));
+    QCOMPARE(sequences[0].length(), 280);
+    QCOMPARE(sequences[92].length(), 256);
+
+    long long totalLength = 0;
+    int recordCount = 0;
+    SequenceFileReader mappedReader(filename, true);
+    QCOMPARE(mappedReader.open(), true);
+    while (mappedReader.readNext())
+    {
+        QCOMPARE(mappedReader.getSequence(), sequences[recordCount]);
+        totalLength += mappedReader.getSequence().length();
+        ++recordCount;
+    }
+    QCOMPARE(recordCount, 93);
+    QCOMPARE(totalLength, 150727LL);
+}
+
+
+//This test checks the overlaps found for a FASTG graph: each edge's overlaps
+//should be the same as those found by testing each overlap in turn, and the
+//chosen overlaps shouldn't change between loads with the same random seed.
+void BandageTests::autoEdgeOverlaps()
+{
+    createGlobals();
+    srand(0);
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    QList<DeBruijnEdge *> edges = g_assemblyGraph->m_deBruijnGraphEdges.values();
+    QMap<QString, int> firstLoadOverlaps;
+    for (int i = 0; i < edges.size(); ++i)
+    {
+        DeBruijnEdge * edge = edges[i];
+        QString edgeName = edge->getStartingNode()->getName() + "," + edge->getEndingNode()->getName();
+        firstLoadOverlaps[edgeName] = edge->getOverlap();
+        QCOMPARE(edge->testExactOverlap(edge->getOverlap()), true);
+
+        int min, max;
+        if (!edge->getAutoOverlapSearchRange(&min, &max))
+            continue;
+        std::vector<int> overlaps = DeBruijnEdge::findExactOverlaps(edge->getStartingNode()->getSequence(),
+                                                                    edge->getEndingNode()->getSequence(),
+                                                                    min, max);
+        std::vector<int> testedOverlaps;
+        for (int overlap = min; overlap <= max; ++overlap)
+        {
+            if (edge->testExactOverlap(overlap))
+                testedOverlaps.push_back(overlap);
+        }
+        QCOMPARE(overlaps, testedOverlaps);
+    }
+
+    createGlobals();
+    srand(0);
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.fastg");
+    edges = g_assemblyGraph->m_deBruijnGraphEdges.values();
+    for (int i = 0; i < edges.size(); ++i)
+    {
+        DeBruijnEdge * edge = edges[i];
+        QString edgeName = edge->getStartingNode()->getName() + "," + edge->getEndingNode()->getName();
+        QCOMPARE(edge->getOverlap(), firstLoadOverlaps[edgeName]);
+    }
+}
+
+
 void BandageTests::bandageInfo()
 {
     int n50 = 0;
@@ -1482,6 +2677,138 @@ void BandageTests::bandageInfo()
 
 
 
+//The single-pass statistics should match the separate AssemblyGraph
+//functions, whether or not the node pass is done in parallel.
+void BandageTests::graphStatistics()
+{
+    QStringList graphFiles;
+    graphFiles << "test.LastGraph" << "test.fastg" << "test.Trinity.fasta" << "test_plasmids.gfa";
+
+    for (int i = 0; i < graphFiles.size(); ++i)
+    {
+        createGlobals();
+        g_assemblyGraph->loadGraphFromFile(getTestDirectory() + graphFiles[i]);
+
+        int n50 = 0;
+        int shortestNode = 0;
+        int firstQuartile = 0;
+        int median = 0;
+        int thirdQuartile = 0;
+        int longestNode = 0;
+        int componentCount = 0;
+        int largestComponentLength = 0;
+        g_assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
+        g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
+        QPair<int, int> overlapRange = g_assemblyGraph->getOverlapRange();
+        double medianDepthByBase = g_assemblyGraph->getMedianDepthByBase();
+
+        for (int parallel = 0; parallel < 2; ++parallel)
+        {
+            GraphStatistics stats;
+            stats.calculate(g_assemblyGraph.data(), parallel == 1);
+            QCOMPARE(stats.m_nodeCount, g_assemblyGraph->m_nodeCount);
+            QCOMPARE(stats.m_edgeCount, g_assemblyGraph->m_edgeCount);
+            QCOMPARE(stats.m_totalLength, g_assemblyGraph->m_totalLength);
+            QCOMPARE(stats.m_totalLengthNoOverlaps, g_assemblyGraph->getTotalLengthMinusEdgeOverlaps());
+            QCOMPARE(stats.m_deadEnds, g_assemblyGraph->getDeadEndCount());
+            QCOMPARE(stats.m_componentCount, componentCount);
+            QCOMPARE(stats.m_largestComponentLength, (long long)largestComponentLength);
+            QCOMPARE(stats.m_totalLengthOrphanedNodes, g_assemblyGraph->getTotalLengthOrphanedNodes());
+            QCOMPARE(stats.m_n50, n50);
+            QCOMPARE(stats.m_shortestNode, shortestNode);
+            QCOMPARE(stats.m_firstQuartile, firstQuartile);
+            QCOMPARE(stats.m_median, median);
+            QCOMPARE(stats.m_thirdQuartile, thirdQuartile);
+            QCOMPARE(stats.m_longestNode, longestNode);
+            QCOMPARE(stats.m_medianDepthByBase, medianDepthByBase);
+            QCOMPARE(stats.m_estimatedSequenceLength, g_assemblyGraph->getEstimatedSequenceLength(medianDepthByBase));
+            if (g_assemblyGraph->m_edgeCount > 0)
+            {
+                QCOMPARE(stats.m_smallestOverlap, overlapRange.first);
+                QCOMPARE(stats.m_largestOverlap, overlapRange.second);
+            }
+        }
+    }
+}
+
+
+
+void BandageTests::graphComponents()
+{
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test.Trinity.fasta");
+    const GraphComponents * components = g_assemblyGraph->getComponents();
+    QCOMPARE(components->getComponentCount(), 66);
+    QCOMPARE(components->getComponent(components->getLargestComponentId()).totalLength, 9398LL);
+
+    //Each component should hold the same nodes as a breadth-first search from
+    //one of its nodes.
+    int nodeCount = 0;
+    long long totalLength = 0;
+    for (int i = 0; i < components->getComponentCount(); ++i)
+    {
+        std::vector<DeBruijnNode *> componentNodes = components->getComponentNodes(i);
+        QCOMPARE(int(componentNodes.size()), components->getComponent(i).nodeCount);
+        QCOMPARE(components->getComponent(i).meanDepth, g_assemblyGraph->getMeanDepth(componentNodes));
+        nodeCount += int(componentNodes.size());
+        totalLength += components->getComponent(i).totalLength;
+
+        QSet<DeBruijnNode *> visitedNodes;
+        QQueue<DeBruijnNode *> q;
+        q.enqueue(componentNodes[0]);
+        visitedNodes.insert(componentNodes[0]);
+        while (!q.isEmpty())
+        {
+            std::vector<DeBruijnNode *> connectedNodes = q.dequeue()->getAllConnectedPositiveNodes();
+            for (size_t j = 0; j < connectedNodes.size(); ++j)
+            {
+                if (!visitedNodes.contains(connectedNodes[j]))
+                {
+                    visitedNodes.insert(connectedNodes[j]);
+                    q.enqueue(connectedNodes[j]);
+                }
+            }
+        }
+        QCOMPARE(visitedNodes.size(), int(componentNodes.size()));
+        for (size_t j = 0; j < componentNodes.size(); ++j)
+        {
+            QCOMPARE(visitedNodes.contains(componentNodes[j]), true);
+            QCOMPARE(components->getComponentId(componentNodes[j]), i);
+            QCOMPARE(components->getComponentId(componentNodes[j]->getReverseComplement()), i);
+        }
+    }
+    QCOMPARE(nodeCount, g_assemblyGraph->m_nodeCount);
+    QCOMPARE(totalLength, g_assemblyGraph->m_totalLength);
+
+    //A single-threaded build should give the same components.
+    GraphComponents serialComponents;
+    serialComponents.build(&g_assemblyGraph->m_nodeAttributes, false);
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        QCOMPARE(serialComponents.getComponentId(i.value()), components->getComponentId(i.value()));
+    }
+
+    //Nodes 6 and 7 are a simple path, and adding an edge from 7 back to 6
+    //makes them circular.  The components must be rebuilt after each change.
+    createGlobals();
+    g_assemblyGraph->loadGraphFromFile(getTestDirectory() + "test_query_paths.gfa");
+    QCOMPARE(g_assemblyGraph->getComponents()->getComponentCount(), 1);
+    std::vector<DeBruijnNode *> nodesToDelete = g_assemblyGraph->getNodesFromString("1, 2, 3, 4, 5, 8", true);
+    g_assemblyGraph->deleteNodes(&nodesToDelete);
+    components = g_assemblyGraph->getComponents();
+    QCOMPARE(components->getComponentCount(), 1);
+    QCOMPARE(components->getComponent(0).nodeCount, 2);
+    QCOMPARE(components->getComponent(0).circular, false);
+    g_assemblyGraph->createDeBruijnEdge("7+", "6+");
+    components = g_assemblyGraph->getComponents();
+    QCOMPARE(components->getComponentCount(), 1);
+    QCOMPARE(components->getComponent(0).circular, true);
+}
+
+
+
 
 
 
@@ -1584,6 +2911,240 @@ bool BandageTests::doCircularSequencesMatch(QByteArray s1, QByteArray s2)
 }
 
 
+//This function checks a node's leaving and entering edge ranges against a
+//filter of all of its edges.
+bool BandageTests::edgeRangesMatchEdges(DeBruijnNode * node)
+{
+    std::vector<DeBruijnEdge *> leavingEdges;
+    std::vector<DeBruijnEdge *> enteringEdges;
+    const std::vector<DeBruijnEdge *> * edges = node->getEdgesPointer();
+    for (size_t i = 0; i < edges->size(); ++i)
+    {
+        DeBruijnEdge * edge = (*edges)[i];
+        if (std::count(edges->begin(), edges->end(), edge) != 1)
+            return false;
+        if (edge->getStartingNode() == node)
+            leavingEdges.push_back(edge);
+        if (edge->getEndingNode() == node)
+            enteringEdges.push_back(edge);
+    }
+
+    DeBruijnEdgeRange leavingRange = node->getLeavingEdgeRange();
+    DeBruijnEdgeRange enteringRange = node->getEnteringEdgeRange();
+    std::sort(leavingEdges.begin(), leavingEdges.end());
+    std::sort(enteringEdges.begin(), enteringEdges.end());
+    std::vector<DeBruijnEdge *> leavingRangeEdges(leavingRange.begin(), leavingRange.end());
+    std::vector<DeBruijnEdge *> enteringRangeEdges(enteringRange.begin(), enteringRange.end());
+    std::sort(leavingRangeEdges.begin(), leavingRangeEdges.end());
+    std::sort(enteringRangeEdges.begin(), enteringRangeEdges.end());
+    return leavingEdges == leavingRangeEdges && enteringEdges == enteringRangeEdges;
+}
+
+
+//This function finds paths between two locations the way
+//Path::getAllPossiblePaths used to: by extending every unfinished path by
+//one node at a time, removing only those which are too long.  It gives each
+//path's nodes and its length between the two locations.
+QList<QList<DeBruijnNode *> > BandageTests::getAllPossiblePathsExhaustively(GraphLocation startLocation,
+                                                                          GraphLocation endLocation,
+                                                                          int nodeSearchDepth,
+                                                                          int minDistance, int maxDistance,
+                                                                          QList<int> * lengths)
+{
+    QList<QList<DeBruijnNode *> > finishedPaths;
+    QList<Path> unfinishedPaths;
+
+    QList<DeBruijnNode *> startNodes;
+    startNodes.push_back(startLocation.getNode());
+    unfinishedPaths.push_back(Path::makeFromOrderedNodes(startNodes, false));
+
+    int startTrim = startLocation.getPosition() - 1;
+    int endTrim = endLocation.getNode()->getLength() - endLocation.getPosition();
+    for (int i = 0; i <= nodeSearchDepth; ++i)
+    {
+        QList<Path>::iterator j = unfinishedPaths.begin();
+        while (j != unfinishedPaths.end())
+        {
+            int length = j->getLength() - startTrim;
+            if (j->getNodes().back() == endLocation.getNode())
+            {
+                if (length - endTrim >= minDistance && length - endTrim <= maxDistance)
+                {
+                    finishedPaths.push_back(j->getNodes());
+                    lengths->push_back(length - endTrim);
+                }
+                ++j;
+            }
+            else if (length > maxDistance)
+                j = unfinishedPaths.erase(j);
+            else
+                ++j;
+        }
+
+        QList<Path> newUnfinishedPaths;
+        for (int j = 0; j < unfinishedPaths.size(); ++j)
+            newUnfinishedPaths.append(unfinishedPaths[j].extendPathInAllPossibleWays());
+        unfinishedPaths = newUnfinishedPaths;
+    }
+
+    return finishedPaths;
+}
+
+
+//This function merges all possible nodes the way
+//AssemblyGraph::mergeAllPossible used to: it finds the chains by following
+//each node's leaving and entering edges, and then merges each chain in turn
+//with mergeNodes.
+int BandageTests::mergeAllPossibleOneAtATime()
+{
+    QSet<DeBruijnNode *> uncheckedNodes;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        uncheckedNodes.insert(i.value());
+    }
+
+    QList<QList<DeBruijnNode *> > allMerges;
+    QMapIterator<QString, DeBruijnNode*> j(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (j.hasNext())
+    {
+        j.next();
+        DeBruijnNode * node = j.value();
+        if (!uncheckedNodes.contains(node))
+            continue;
+
+        QList<DeBruijnNode *> nodesToMerge;
+        nodesToMerge.push_back(node);
+        uncheckedNodes.remove(node);
+        uncheckedNodes.remove(node->getReverseComplement());
+
+        bool extended;
+        do
+        {
+            extended = false;
+            std::vector<DeBruijnEdge *> outgoingEdges = nodesToMerge.back()->getLeavingEdges();
+            if (outgoingEdges.size() == 1)
+            {
+                DeBruijnEdge * potentialEdge = outgoingEdges[0];
+                DeBruijnNode * potentialNode = potentialEdge->getEndingNode();
+                std::vector<DeBruijnEdge *> edgesEnteringPotentialNode = potentialNode->getEnteringEdges();
+                if (edgesEnteringPotentialNode.size() == 1 &&
+                        edgesEnteringPotentialNode[0] == potentialEdge &&
+                        !nodesToMerge.contains(potentialNode) &&
+                        uncheckedNodes.contains(potentialNode))
+                {
+                    nodesToMerge.push_back(potentialNode);
+                    uncheckedNodes.remove(potentialNode);
+                    uncheckedNodes.remove(potentialNode->getReverseComplement());
+                    extended = true;
+                }
+            }
+        } while (extended);
+
+        do
+        {
+            extended = false;
+            std::vector<DeBruijnEdge *> incomingEdges = nodesToMerge.front()->getEnteringEdges();
+            if (incomingEdges.size() == 1)
+            {
+                DeBruijnEdge * potentialEdge = incomingEdges[0];
+                DeBruijnNode * potentialNode = potentialEdge->getStartingNode();
+                std::vector<DeBruijnEdge *> edgesLeavingPotentialNode = potentialNode->getLeavingEdges();
+                if (edgesLeavingPotentialNode.size() == 1 &&
+                        edgesLeavingPotentialNode[0] == potentialEdge &&
+                        !nodesToMerge.contains(potentialNode) &&
+                        uncheckedNodes.contains(potentialNode))
+                {
+                    nodesToMerge.push_front(potentialNode);
+                    uncheckedNodes.remove(potentialNode);
+                    uncheckedNodes.remove(potentialNode->getReverseComplement());
+                    extended = true;
+                }
+            }
+        } while (extended);
+
+        if (nodesToMerge.size() > 1)
+            allMerges.push_back(nodesToMerge);
+    }
+
+    for (int k = 0; k < allMerges.size(); ++k)
+        g_assemblyGraph->mergeNodes(allMerges[k], 0, false);
+    return allMerges.size();
+}
+
+
+//This function describes each BLAST hit, in order, followed by each query's
+//paths.
+QStringList BandageTests::getBlastResultStrings()
+{
+    QStringList results;
+    for (int i = 0; i < g_blastSearch->m_allHits.size(); ++i)
+    {
+        BlastHit * hit = g_blastSearch->m_allHits[i].data();
+        results.push_back(hit->m_query->getName() + " " + hit->m_node->getName() + " " +
+                          QString::number(hit->m_percentIdentity) + " " +
+                          QString::number(hit->m_alignmentLength) + " " +
+                          QString::number(hit->m_queryStart) + "-" + QString::number(hit->m_queryEnd) + " " +
+                          QString::number(hit->m_nodeStart) + "-" + QString::number(hit->m_nodeEnd) + " " +
+                          hit->m_eValue.asString(false));
+    }
+    std::vector<BlastQuery *> queries = g_blastSearch->m_blastQueries.m_queries;
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        QList<BlastQueryPath> paths = queries[i]->getPaths();
+        for (int j = 0; j < paths.size(); ++j)
+            results.push_back(queries[i]->getName() + " path " + paths[j].getPath().getString(false));
+    }
+    return results;
+}
+
+
+//This function describes each edge in the graph by its node names and
+//overlap.
+QSet<QString> BandageTests::getEdgeStrings()
+{
+    QSet<QString> edgeStrings;
+    QMapIterator<QPair<DeBruijnNode*, DeBruijnNode*>, DeBruijnEdge*> i(g_assemblyGraph->m_deBruijnGraphEdges);
+    while (i.hasNext())
+    {
+        i.next();
+        DeBruijnEdge * edge = i.value();
+        edgeStrings.insert(edge->getStartingNode()->getName() + "\t" + edge->getEndingNode()->getName() +
+                           "\t" + QString::number(edge->getOverlap()));
+    }
+    return edgeStrings;
+}
+
+
+QSet<QString> BandageTests::getNodeStrings()
+{
+    QSet<QString> nodeStrings;
+    QMapIterator<QString, DeBruijnNode*> i(g_assemblyGraph->m_deBruijnGraphNodes);
+    while (i.hasNext())
+    {
+        i.next();
+        nodeStrings.insert(i.key() + "\t" + QString::number(i.value()->getLength()));
+    }
+    return nodeStrings;
+}
+
+
+int BandageTests::countGfaSegmentLines(QString filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+    int count = 0;
+    while (!file.atEnd())
+    {
+        if (file.readLine().startsWith("S\t"))
+            ++count;
+    }
+    return count;
+}
+
+
 
 QTEST_MAIN(BandageTests)
 #include "bandagetests.moc"
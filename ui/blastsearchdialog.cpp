@@ -614,9 +614,9 @@ void BlastSearchDialog::runBlastSearchFinished(QString error)
 
 void BlastSearchDialog::runBlastSearchCancelled()
 {
-    g_blastSearch->m_cancelRunBlastSearch = true;
-    if (g_blastSearch->m_blast != 0)
-        g_blastSearch->m_blast->kill();
+    //The worker running the search checks this flag and stops its BLAST
+    //processes.
+    g_blastSearch->m_cancelRunBlastSearch.storeRelease(1);
 }
 
 
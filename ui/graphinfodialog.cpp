@@ -3,7 +3,7 @@
 
 #include "../program/globals.h"
 #include "../graph/assemblygraph.h"
-#include <QPair>
+#include "../graph/graphstatistics.h"
 
 GraphInfoDialog::GraphInfoDialog(QWidget *parent) :
     QDialog(parent),
@@ -27,77 +27,57 @@ void GraphInfoDialog::setLabels()
 {
     ui->filenameLabel->setText(g_assemblyGraph->m_filename);
 
-    int nodeCount = g_assemblyGraph->m_nodeCount;
+    GraphStatistics stats;
+    stats.calculate(g_assemblyGraph.data(), true);
 
-    ui->nodeCountLabel->setText(formatIntForDisplay(nodeCount));
-    ui->edgeCountLabel->setText(formatIntForDisplay(g_assemblyGraph->m_edgeCount));
+    ui->nodeCountLabel->setText(formatIntForDisplay(stats.m_nodeCount));
+    ui->edgeCountLabel->setText(formatIntForDisplay(stats.m_edgeCount));
 
-    if (g_assemblyGraph->m_edgeCount == 0)
+    if (stats.m_edgeCount == 0)
         ui->edgeOverlapRangeLabel->setText("n/a");
     else
     {
-        QPair<int, int> overlapRange = g_assemblyGraph->getOverlapRange();
-        int smallestOverlap = overlapRange.first;
-        int largestOverlap = overlapRange.second;
-        if (smallestOverlap == largestOverlap)
-            ui->edgeOverlapRangeLabel->setText(formatIntForDisplay(smallestOverlap) + " bp");
+        if (stats.m_smallestOverlap == stats.m_largestOverlap)
+            ui->edgeOverlapRangeLabel->setText(formatIntForDisplay(stats.m_smallestOverlap) + " bp");
         else
-            ui->edgeOverlapRangeLabel->setText(formatIntForDisplay(smallestOverlap) + " to " + formatIntForDisplay(largestOverlap) + " bp");
+            ui->edgeOverlapRangeLabel->setText(formatIntForDisplay(stats.m_smallestOverlap) + " to " + formatIntForDisplay(stats.m_largestOverlap) + " bp");
     }
 
-    ui->totalLengthLabel->setText(formatIntForDisplay(g_assemblyGraph->m_totalLength) + " bp");
-    ui->totalLengthNoOverlapsLabel->setText(formatIntForDisplay(g_assemblyGraph->getTotalLengthMinusEdgeOverlaps()) + " bp");
+    ui->totalLengthLabel->setText(formatIntForDisplay(stats.m_totalLength) + " bp");
+    ui->totalLengthNoOverlapsLabel->setText(formatIntForDisplay(stats.m_totalLengthNoOverlaps) + " bp");
 
-    int deadEnds = g_assemblyGraph->getDeadEndCount();
-    double percentageDeadEnds = 100.0 * double(deadEnds) / (2 * nodeCount);
+    ui->deadEndsLabel->setText(formatIntForDisplay(stats.m_deadEnds));
+    ui->percentageDeadEndsLabel->setText(formatDoubleForDisplay(stats.m_percentageDeadEnds, 2) + "%");
 
-    ui->deadEndsLabel->setText(formatIntForDisplay(deadEnds));
-    ui->percentageDeadEndsLabel->setText(formatDoubleForDisplay(percentageDeadEnds, 2) + "%");
 
-
-    int componentCount = 0;
-    int largestComponentLength = 0;
-    g_assemblyGraph->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
     QString percentageLargestComponent;
-    if (g_assemblyGraph->m_totalLength > 0)
-        percentageLargestComponent = formatDoubleForDisplay(100.0 * double(largestComponentLength) / g_assemblyGraph->m_totalLength, 2);
+    if (stats.m_totalLength > 0)
+        percentageLargestComponent = formatDoubleForDisplay(100.0 * double(stats.m_largestComponentLength) / stats.m_totalLength, 2);
     else
         percentageLargestComponent = "n/a";
 
-    long long totalLengthOrphanedNodes = g_assemblyGraph->getTotalLengthOrphanedNodes();
     QString percentageOrphaned;
-    if (g_assemblyGraph->m_totalLength > 0)
-        percentageOrphaned = formatDoubleForDisplay(100.0 * double(totalLengthOrphanedNodes) / g_assemblyGraph->m_totalLength, 2);
+    if (stats.m_totalLength > 0)
+        percentageOrphaned = formatDoubleForDisplay(100.0 * double(stats.m_totalLengthOrphanedNodes) / stats.m_totalLength, 2);
     else
         percentageOrphaned = "n/a";
 
-    ui->connectedComponentsLabel->setText(formatIntForDisplay(componentCount));
-    ui->largestComponentLabel->setText(formatIntForDisplay(largestComponentLength) + " bp (" + percentageLargestComponent + "%)");
-    ui->orphanedLengthLabel->setText(formatIntForDisplay(totalLengthOrphanedNodes) + " bp (" + percentageOrphaned + "%)");
-
-    int n50 = 0;
-    int shortestNode = 0;
-    int firstQuartile = 0;
-    int median = 0;
-    int thirdQuartile = 0;
-    int longestNode = 0;
-    g_assemblyGraph->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
-
-    ui->n50Label->setText(formatIntForDisplay(n50) + " bp");
-    ui->shortestNodeLabel->setText(formatIntForDisplay(shortestNode) + " bp");
-    ui->lowerQuartileNodeLabel->setText(formatIntForDisplay(firstQuartile) + " bp");
-    ui->medianNodeLabel->setText(formatIntForDisplay(median) + " bp");
-    ui->upperQuartileNodeLabel->setText(formatIntForDisplay(thirdQuartile) + " bp");
-    ui->longestNodeLabel->setText(formatIntForDisplay(longestNode) + " bp");
-
-    double medianDepthByBase = g_assemblyGraph->getMedianDepthByBase();
-    long long estimatedSequenceLength = g_assemblyGraph->getEstimatedSequenceLength(medianDepthByBase);
-
-    ui->medianDepthLabel->setText(formatDepthForDisplay(medianDepthByBase));
-    if (medianDepthByBase == 0.0)
+    ui->connectedComponentsLabel->setText(formatIntForDisplay(stats.m_componentCount));
+    ui->largestComponentLabel->setText(formatIntForDisplay(stats.m_largestComponentLength) + " bp (" + percentageLargestComponent + "%)");
+    ui->orphanedLengthLabel->setText(formatIntForDisplay(stats.m_totalLengthOrphanedNodes) + " bp (" + percentageOrphaned + "%)");
+
+    ui->n50Label->setText(formatIntForDisplay(stats.m_n50) + " bp");
+    ui->shortestNodeLabel->setText(formatIntForDisplay(stats.m_shortestNode) + " bp");
+    ui->lowerQuartileNodeLabel->setText(formatIntForDisplay(stats.m_firstQuartile) + " bp");
+    ui->medianNodeLabel->setText(formatIntForDisplay(stats.m_median) + " bp");
+    ui->upperQuartileNodeLabel->setText(formatIntForDisplay(stats.m_thirdQuartile) + " bp");
+    ui->longestNodeLabel->setText(formatIntForDisplay(stats.m_longestNode) + " bp");
+
+    ui->medianDepthLabel->setText(formatDepthForDisplay(stats.m_medianDepthByBase));
+    if (stats.m_medianDepthByBase == 0.0)
         ui->estimatedSequenceLengthLabel->setText("unavailable");
     else
-        ui->estimatedSequenceLengthLabel->setText(formatIntForDisplay(estimatedSequenceLength) + " bp");
+        ui->estimatedSequenceLengthLabel->setText(formatIntForDisplay(stats.m_estimatedSequenceLength) + " bp");
 }
 
 
@@ -174,6 +174,7 @@ MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     connect(ui->actionSelect_not_contiguous_nodes, SIGNAL(triggered()), this, SLOT(selectNotContiguous()));
     connect(ui->actionBandage_online_help, SIGNAL(triggered()), this, SLOT(openBandageUrl()));
     connect(ui->nodeDistanceSpinBox, SIGNAL(valueChanged(int)), this, SLOT(nodeDistanceChanged()));
+    connect(ui->baseDistanceSpinBox, SIGNAL(valueChanged(int)), this, SLOT(baseDistanceChanged()));
     connect(ui->minDepthSpinBox, SIGNAL(valueChanged(double)), this, SLOT(depthRangeChanged()));
     connect(ui->maxDepthSpinBox, SIGNAL(valueChanged(double)), this, SLOT(depthRangeChanged()));
     connect(ui->startingNodesExactMatchRadioButton, SIGNAL(toggled(bool)), this, SLOT(startingNodesExactMatchChanged()));
@@ -185,6 +186,7 @@ MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     connect(ui->actionSave_entire_graph_to_FASTA_only_positive_nodes, SIGNAL(triggered(bool)), this, SLOT(saveEntireGraphToFastaOnlyPositiveNodes()));
     connect(ui->actionSave_entire_graph_to_GFA, SIGNAL(triggered(bool)), this, SLOT(saveEntireGraphToGfa()));
     connect(ui->actionSave_visible_graph_to_GFA, SIGNAL(triggered(bool)), this, SLOT(saveVisibleGraphToGfa()));
+    connect(ui->actionSave_GFA_paths_to_FASTA, SIGNAL(triggered(bool)), this, SLOT(saveGfaPathsToFasta()));
     connect(ui->actionWeb_BLAST_selected_nodes, SIGNAL(triggered(bool)), this, SLOT(webBlastSelectedNodes()));
     connect(ui->actionHide_selected_nodes, SIGNAL(triggered(bool)), this, SLOT(hideNodes()));
     connect(ui->actionRemove_selection_from_graph, SIGNAL(triggered(bool)), this, SLOT(removeSelection()));
@@ -193,6 +195,7 @@ MainWindow::MainWindow(QString fileToLoadOnStartup, bool drawGraphAfterLoad) :
     connect(ui->actionMerge_all_possible_nodes, SIGNAL(triggered(bool)), this, SLOT(mergeAllPossible()));
     connect(ui->actionChange_node_name, SIGNAL(triggered(bool)), this, SLOT(changeNodeName()));
     connect(ui->actionChange_node_depth, SIGNAL(triggered(bool)), this, SLOT(changeNodeDepth()));
+    connect(ui->actionColour_nodes_by_GFA_paths, SIGNAL(triggered(bool)), this, SLOT(colourNodesByGfaPaths()));
     connect(ui->moreInfoButton, SIGNAL(clicked(bool)), this, SLOT(openGraphInfoDialog()));
 
     connect(this, SIGNAL(windowLoaded()), this, SLOT(afterMainWindowShow()), Qt::ConnectionType(Qt::QueuedConnection | Qt::UniqueConnection));
@@ -266,7 +269,7 @@ void MainWindow::cleanUp()
 
 void MainWindow::loadCSV(QString fullFileName)
 {
-    QString selectedFilter = "Comma separated value (*.csv)";
+    QString selectedFilter = "Comma separated value (*.csv *.csv.gz)";
     if (fullFileName == "")
     {
         fullFileName = QFileDialog::getOpenFileName(this, "Load CSV", g_memory->rememberedPath,
@@ -322,7 +325,7 @@ void MainWindow::loadGraph(QString fullFileName)
     QString selectedFilter = "Any supported graph (*)";
     if (fullFileName == "")
         fullFileName = QFileDialog::getOpenFileName(this, "Load graph", g_memory->rememberedPath,
-                                                    "Any supported graph (*);;LastGraph (*LastGraph*);;FASTG (*.fastg);;GFA (*.gfa);;Trinity.fasta (*.fasta);;ASQG (*.asqg);;Plain FASTA (*.fasta)",
+                                                    "Any supported graph (*);;LastGraph (*LastGraph*);;FASTG (*.fastg *.fastg.gz);;GFA (*.gfa *.gfa.gz);;Trinity.fasta (*.fasta *.fasta.gz);;ASQG (*.asqg *.asqg.gz);;Plain FASTA (*.fasta *.fasta.gz)",
                                                     &selectedFilter);
 
     if (fullFileName != "") //User did not hit cancel
@@ -604,6 +607,7 @@ void MainWindow::graphScopeChanged()
         setStartingNodesWidgetVisibility(false);
         setNodeDistanceWidgetVisibility(false);
         setDepthRangeWidgetVisibility(false);
+        setBaseDistanceWidgetVisibility(false);
 
         ui->graphDrawingGridLayout->addWidget(ui->nodeStyleInfoText, 1, 0, 1, 1);
         ui->graphDrawingGridLayout->addWidget(ui->nodeStyleLabel, 1, 1, 1, 1);
@@ -619,6 +623,7 @@ void MainWindow::graphScopeChanged()
         setStartingNodesWidgetVisibility(true);
         setNodeDistanceWidgetVisibility(true);
         setDepthRangeWidgetVisibility(false);
+        setBaseDistanceWidgetVisibility(false);
 
         ui->nodeDistanceInfoText->setInfoText("Nodes will be drawn if they are specified in the above list or are "
                                               "within this many steps of those nodes.<br><br>"
@@ -649,6 +654,7 @@ void MainWindow::graphScopeChanged()
         setStartingNodesWidgetVisibility(false);
         setNodeDistanceWidgetVisibility(true);
         setDepthRangeWidgetVisibility(false);
+        setBaseDistanceWidgetVisibility(false);
 
         ui->nodeDistanceInfoText->setInfoText("Nodes will be drawn if they contain a BLAST hit or are within this "
                                               "many steps of nodes with a BLAST hit.<br><br>"
@@ -673,6 +679,7 @@ void MainWindow::graphScopeChanged()
         setStartingNodesWidgetVisibility(false);
         setNodeDistanceWidgetVisibility(false);
         setDepthRangeWidgetVisibility(true);
+        setBaseDistanceWidgetVisibility(false);
 
         ui->graphDrawingGridLayout->addWidget(ui->minDepthInfoText, 1, 0, 1, 1);
         ui->graphDrawingGridLayout->addWidget(ui->minDepthLabel, 1, 1, 1, 1);
@@ -686,6 +693,31 @@ void MainWindow::graphScopeChanged()
         ui->graphDrawingGridLayout->addWidget(ui->drawGraphInfoText, 4, 0, 1, 1);
         ui->graphDrawingGridLayout->addWidget(ui->drawGraphButton, 4, 1, 1, 2);
 
+        break;
+
+    case 4:
+        g_settings->graphScope = AROUND_BASES;
+
+        setStartingNodesWidgetVisibility(true);
+        setNodeDistanceWidgetVisibility(false);
+        setDepthRangeWidgetVisibility(false);
+        setBaseDistanceWidgetVisibility(true);
+
+        ui->graphDrawingGridLayout->addWidget(ui->startingNodesInfoText, 1, 0, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->startingNodesLabel, 1, 1, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->startingNodesLineEdit, 1, 2, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->startingNodesMatchTypeInfoText, 2, 0, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->startingNodesMatchTypeLabel, 2, 1, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->startingNodesMatchTypeWidget, 2, 2, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->baseDistanceInfoText, 3, 0, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->baseDistanceLabel, 3, 1, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->baseDistanceSpinBox, 3, 2, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->nodeStyleInfoText, 4, 0, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->nodeStyleLabel, 4, 1, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->nodeStyleWidget, 4, 2, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->drawGraphInfoText, 5, 0, 1, 1);
+        ui->graphDrawingGridLayout->addWidget(ui->drawGraphButton, 5, 1, 1, 2);
+
         break;
     }
 }
@@ -707,6 +739,12 @@ void MainWindow::setNodeDistanceWidgetVisibility(bool visible)
     ui->nodeDistanceLabel->setVisible(visible);
     ui->nodeDistanceSpinBox->setVisible(visible);
 }
+void MainWindow::setBaseDistanceWidgetVisibility(bool visible)
+{
+    ui->baseDistanceInfoText->setVisible(visible);
+    ui->baseDistanceLabel->setVisible(visible);
+    ui->baseDistanceSpinBox->setVisible(visible);
+}
 void MainWindow::setDepthRangeWidgetVisibility(bool visible)
 {
     ui->minDepthInfoText->setVisible(visible);
@@ -1652,7 +1690,16 @@ void MainWindow::setInfoTexts()
                                         "limit the drawing to a smaller region of the graph.</li>"
                                         "<li>'Around BLAST hits': if you have conducted a BLAST search "
                                         "on this graph, this option will draw the region(s) of the graph "
-                                        "around nodes that contain hits.</li></ul>");
+                                        "around nodes that contain hits.</li>"
+                                        "<li>'Around nodes (bases)': like 'Around nodes', but the distance "
+                                        "is given in bases instead of node steps. This suits graphs where "
+                                        "node lengths vary widely.</li></ul>");
+    ui->baseDistanceInfoText->setInfoText("Nodes will be drawn if they are specified in the above list or "
+                                          "begin within this many bases of those nodes. The length of each "
+                                          "node passed through, minus its edge overlap, counts towards the "
+                                          "distance.<br><br>"
+                                          "A value of 0 will result in the specified nodes and their "
+                                          "immediate neighbours being drawn.");
     ui->startingNodesInfoText->setInfoText("Enter a comma-delimited list of node names here. This will "
                                            "define which regions of the graph will be drawn.<br><br>"
                                            "When in double mode, you can include '+' or '-' at the end "
@@ -2065,6 +2112,7 @@ void MainWindow::setWidgetsFromSettings()
 
     setGraphScopeComboBox(g_settings->graphScope);
     ui->nodeDistanceSpinBox->setValue(g_settings->nodeDistance);
+    ui->baseDistanceSpinBox->setValue(g_settings->baseDistance);
     ui->startingNodesLineEdit->setText(g_settings->startingNodes);
 
     ui->minDepthSpinBox->setValue(g_settings->minDepthRange);
@@ -2095,6 +2143,7 @@ void MainWindow::setGraphScopeComboBox(GraphScope graphScope)
     case AROUND_NODE: ui->graphScopeComboBox->setCurrentIndex(1); break;
     case AROUND_BLAST_HITS: ui->graphScopeComboBox->setCurrentIndex(2); break;
     case DEPTH_RANGE: ui->graphScopeComboBox->setCurrentIndex(3); break;
+    case AROUND_BASES: ui->graphScopeComboBox->setCurrentIndex(4); break;
     }
 }
 
@@ -2103,6 +2152,11 @@ void MainWindow::nodeDistanceChanged()
     g_settings->nodeDistance = ui->nodeDistanceSpinBox->value();
 }
 
+void MainWindow::baseDistanceChanged()
+{
+    g_settings->baseDistance = ui->baseDistanceSpinBox->value();
+}
+
 void MainWindow::depthRangeChanged()
 {
     g_settings->minDepthRange = ui->minDepthSpinBox->value();
@@ -2234,6 +2288,27 @@ void MainWindow::saveVisibleGraphToGfa()
     }
 }
 
+void MainWindow::saveGfaPathsToFasta()
+{
+    if (g_assemblyGraph->m_gfaPaths.getPathCount() == 0)
+    {
+        QMessageBox::information(this, "No GFA paths", "The graph has no paths.\n\n"
+                                                       "Paths come from the P and W lines of a GFA file.");
+        return;
+    }
+
+    QString defaultFileNameAndPath = g_memory->rememberedPath + "/gfa_paths.fasta";
+    QString fullFileName = QFileDialog::getSaveFileName(this, "Save GFA paths", defaultFileNameAndPath, "FASTA (*.fasta)");
+
+    if (fullFileName != "") //User did not hit cancel
+    {
+        g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
+        bool success = g_assemblyGraph->saveGfaPathsToFasta(fullFileName);
+        if (!success)
+            QMessageBox::warning(this, "Error saving file", "Bandage was unable to save the FASTA file.");
+    }
+}
+
 
 void MainWindow::webBlastSelectedNodes()
 {
@@ -2303,11 +2378,8 @@ void MainWindow::removeSelection()
     std::vector<DeBruijnEdge *> selectedEdges = m_scene->getSelectedEdges();
     std::vector<DeBruijnNode *> selectedNodes = m_scene->getSelectedNodes();
 
-    g_assemblyGraph->removeGraphicsItemEdges(&selectedEdges, true, m_scene);
-    g_assemblyGraph->removeGraphicsItemNodes(&selectedNodes, true, m_scene);
-
-    g_assemblyGraph->deleteEdges(&selectedEdges);
-    g_assemblyGraph->deleteNodes(&selectedNodes);
+    g_assemblyGraph->removeGraphicsItems(&selectedNodes, &selectedEdges, true, m_scene);
+    int droppedGfaPaths = g_assemblyGraph->deleteNodesAndEdges(&selectedNodes, &selectedEdges);
 
     g_assemblyGraph->determineGraphInfo();
     displayGraphDetails();
@@ -2316,6 +2388,12 @@ void MainWindow::removeSelection()
     //stuff, as they may no longer apply.
     cleanUpAllBlast();
     g_assemblyGraph->resetNodeContiguityStatus();
+
+    if (droppedGfaPaths > 0)
+        QMessageBox::information(this, "GFA paths removed",
+                                 QString::number(droppedGfaPaths) + " GFA path" + (droppedGfaPaths == 1 ? "" : "s") +
+                                 " passed through the removed nodes and " + (droppedGfaPaths == 1 ? "was" : "were") +
+                                 " removed from the graph.");
 }
 
 
@@ -2495,6 +2573,31 @@ void MainWindow::changeNodeDepth()
 
 
 
+//Each GFA path is given its own colour, and the colour scheme is switched to
+//custom colours to show them.
+void MainWindow::colourNodesByGfaPaths()
+{
+    int pathCount = g_assemblyGraph->m_gfaPaths.getPathCount();
+    if (pathCount == 0)
+    {
+        QMessageBox::information(this, "No GFA paths", "The graph has no paths.\n\n"
+                                                       "Paths come from the P and W lines of a GFA file.");
+        return;
+    }
+
+    std::vector<int> gfaPaths;
+    for (int i = 0; i < pathCount; ++i)
+        gfaPaths.push_back(i);
+    g_assemblyGraph->colourNodesByGfaPaths(gfaPaths);
+
+    if (ui->coloursComboBox->currentIndex() != 6)
+        setNodeColourSchemeComboBox(CUSTOM_COLOURS);
+    else
+        switchColourScheme();
+}
+
+
+
 void MainWindow::openGraphInfoDialog()
 {
     GraphInfoDialog graphInfoDialog(this);
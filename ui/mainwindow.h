@@ -91,6 +91,7 @@ private:
     void setSelectedEdgesWidgetsVisibility(bool visible);
     void setStartingNodesWidgetVisibility(bool visible);
     void setNodeDistanceWidgetVisibility(bool visible);
+    void setBaseDistanceWidgetVisibility(bool visible);
     void setDepthRangeWidgetVisibility(bool visible);
     static QByteArray makeStringUrlSafe(QByteArray s);
     void removeGraphicsItemNodes(const std::vector<DeBruijnNode *> * nodes, bool reverseComplement);
@@ -141,6 +142,7 @@ private slots:
     void selectNotContiguous();
     void openBandageUrl();
     void nodeDistanceChanged();
+    void baseDistanceChanged();
     void depthRangeChanged();
     void afterMainWindowShow();
     void startingNodesExactMatchChanged();
@@ -150,6 +152,7 @@ private slots:
     void saveEntireGraphToFastaOnlyPositiveNodes();
     void saveEntireGraphToGfa();
     void saveVisibleGraphToGfa();
+    void saveGfaPathsToFasta();
     void webBlastSelectedNodes();
     void removeSelection();
     void duplicateSelectedNodes();
@@ -158,6 +161,7 @@ private slots:
     void cleanUpAllBlast();
     void changeNodeName();
     void changeNodeDepth();
+    void colourNodesByGfaPaths();
     void openGraphInfoDialog();
 
 protected:
@@ -25,6 +25,7 @@
 #include <QTextStream>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QMessageBox>
 #include "mygraphicsview.h"
 #include "../program/memory.h"
 
@@ -51,6 +52,7 @@ PathSpecifyDialog::PathSpecifyDialog(QWidget *parent) :
     connect(ui->circularPathCheckBox, SIGNAL(toggled(bool)), g_graphicsView->viewport(), SLOT(update()));
     connect(ui->copyButton, SIGNAL(clicked(bool)), this, SLOT(copyPathToClipboard()));
     connect(ui->saveButton, SIGNAL(clicked(bool)), this, SLOT(savePathToFile()));
+    connect(ui->saveFilePathsButton, SIGNAL(clicked(bool)), this, SLOT(savePathsFromFileToFasta()));
     connect(this, SIGNAL(rejected()), this, SLOT(deleteLater()));
 }
 
@@ -148,6 +150,66 @@ void PathSpecifyDialog::savePathToFile()
 }
 
 
+//This function makes a path from each line of a file (circular paths end in
+//"(circular)") and saves the sequences of those which are valid to a FASTA
+//file.  The lines which couldn't be made into paths are reported.
+void PathSpecifyDialog::savePathsFromFileToFasta()
+{
+    QString pathsFileName = QFileDialog::getOpenFileName(this, "Load paths", g_memory->rememberedPath);
+    if (pathsFileName == "") //User hit cancel
+        return;
+    g_memory->rememberedPath = QFileInfo(pathsFileName).absolutePath();
+
+    QList<Path> paths;
+    QStringList pathStrings, pathStringFailures;
+    if (!Path::loadFromFile(pathsFileName, &paths, &pathStrings, &pathStringFailures))
+    {
+        QMessageBox::warning(this, "Error loading paths", "Bandage was unable to read the file:\n" + pathsFileName);
+        return;
+    }
+
+    QString failures;
+    int failureCount = 0;
+    for (int i = 0; i < paths.size(); ++i)
+    {
+        if (!paths[i].isEmpty())
+            continue;
+        ++failureCount;
+        if (failureCount <= 10)
+            failures += "\n" + pathStrings[i] + ": " + pathStringFailures[i];
+    }
+    int validCount = paths.size() - failureCount;
+    if (validCount == 0)
+    {
+        QMessageBox::information(this, "No valid paths", "None of the lines in the file are valid paths." + failures);
+        return;
+    }
+
+    QString defaultFileNameAndPath = g_memory->rememberedPath + "/path_sequences.fasta";
+    QString fullFileName = QFileDialog::getSaveFileName(this, "Save path sequences", defaultFileNameAndPath, "FASTA (*.fasta)");
+    if (fullFileName == "") //User hit cancel
+        return;
+
+    QFile file(fullFileName);
+    file.open(QIODevice::WriteOnly | QIODevice::Text);
+    QTextStream out(&file);
+    for (int i = 0; i < paths.size(); ++i)
+    {
+        if (!paths[i].isEmpty())
+            out << paths[i].getFasta();
+    }
+    g_memory->rememberedPath = QFileInfo(fullFileName).absolutePath();
+
+    if (failureCount > 0)
+    {
+        if (failureCount > 10)
+            failures += "\n...";
+        QMessageBox::information(this, "Paths saved", formatIntForDisplay(validCount) + " paths were saved.  " +
+                                 formatIntForDisplay(failureCount) + " lines were not valid paths:" + failures);
+    }
+}
+
+
 void PathSpecifyDialog::addNodeName(DeBruijnNode * node)
 {
     QString pathText = ui->pathTextEdit->toPlainText();
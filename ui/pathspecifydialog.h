@@ -46,6 +46,7 @@ private slots:
     void checkPathValidity();
     void copyPathToClipboard();
     void savePathToFile();
+    void savePathsFromFileToFasta();
 };
 
 #endif // PATHSPECIFYDIALOG_H